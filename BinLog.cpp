@@ -0,0 +1,76 @@
+//---------------------------------------------------------------------------
+#include "BinLog.h"
+#include <stdio.h>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+void BinLogHeader(TBinLogHdr* h, int year, int month, int day)
+{
+    h->Magic = BLOG_MAGIC;
+    h->Version = BLOG_VERSION;
+    h->RecSize = sizeof(TBinLogRec);
+    h->Year = (WORD)year;
+    h->Month = (BYTE)month;
+    h->Day = (BYTE)day;
+    h->Reserved = 0;
+}
+
+bool BinLogCheck(const TBinLogHdr* h)
+{
+    return h->Magic == BLOG_MAGIC && h->Version == BLOG_VERSION &&
+           h->RecSize == sizeof(TBinLogRec);
+}
+
+//---------------------------------------------------------------------------
+// 레코드 -> 텍스트 한 줄
+//---------------------------------------------------------------------------
+int BinLogFormat(const TBinLogRec* r, char* buf)
+{
+    DWORD sec = r->TimeMs / 1000;
+    int pos = sprintf(buf, "[%02u:%02u:%02u] ", (unsigned)(sec / 3600), (unsigned)((sec / 60) % 60), (unsigned)(sec % 60));
+
+    if (r->Link > 0)
+        pos += sprintf(buf + pos, "P%d ", r->Link);
+
+    switch (r->Code)
+    {
+        case BLOG_DATA:
+            pos += sprintf(buf + pos, "%s%s:%u",
+                           (r->Flags & BLOG_F_KA) ? "K" : ((r->Flags & BLOG_F_BATCH) ? "B" : "D"),
+                           ((r->Flags & BLOG_F_HB) && !(r->Flags & BLOG_F_KA)) ? "(HB)" : "", r->Items);
+            if (r->Changes > 0)
+                pos += sprintf(buf + pos, "(C:%u)", r->Changes);
+            if (r->Flags & BLOG_F_BATCH)
+                pos += sprintf(buf + pos, "(S:%u)", r->Extra);
+            pos += sprintf(buf + pos, " TX:%u", r->Bytes);
+            if (r->Flags & BLOG_F_Z)
+                pos += sprintf(buf + pos, "(Z:%u)", r->Extra);
+
+            if (r->Result == BLOG_RES_OK)
+                pos += sprintf(buf + pos, " OK");
+            else if (r->Result & BLOG_RES_NAK)
+                pos += sprintf(buf + pos, " FAIL(N:%d)", r->Result & 0x7F);
+            else
+                pos += sprintf(buf + pos, " FAIL");
+            break;
+
+        case BLOG_WRITE:
+            pos += sprintf(buf + pos, "WR %u OK:%u", r->Items, r->Changes);
+            if (r->Result == BLOG_RES_TMO)
+                pos += sprintf(buf + pos, " TMO");
+            else
+                pos += sprintf(buf + pos, " T:%ums", r->Extra);
+            break;
+
+        case BLOG_PRIO:
+            pos += sprintf(buf + pos, "A:%u TX:%u L:%u.%ums", r->Items, r->Bytes,
+                           (unsigned)(r->Extra / 10), (unsigned)(r->Extra % 10));
+            break;
+
+        default:
+            pos += sprintf(buf + pos, "?%d", r->Code);
+            break;
+    }
+
+    return pos;
+}
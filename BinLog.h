@@ -0,0 +1,65 @@
+//---------------------------------------------------------------------------
+#ifndef BinLogH
+#define BinLogH
+//---------------------------------------------------------------------------
+// 이진 이벤트 로그 (VCL 비의존 - 리눅스에서도 단독 컴파일 가능)
+// 매 주기 전송 결과처럼 자주 남는 이벤트를 고정 크기 레코드로 기록한다.
+// 파일은 하루 하나 (logbin_YYYYMMDD.bin): [HDR][REC][REC]...
+// 기록은 레코드 복사뿐이고, 텍스트 변환은 BinLogDump (오프라인) 가 한다.
+//---------------------------------------------------------------------------
+#include "PortTypes.h"
+
+#define BLOG_MAGIC      0x474C4247      // "GBLG"
+#define BLOG_VERSION    1
+
+struct TBinLogHdr
+{
+    DWORD   Magic;
+    WORD    Version;
+    WORD    RecSize;        // sizeof(TBinLogRec)
+    WORD    Year;           // 파일 날짜 (현지 시각)
+    BYTE    Month;
+    BYTE    Day;
+    DWORD   Reserved;
+};
+
+// 이벤트 레코드 (16바이트)
+struct TBinLogRec
+{
+    DWORD   TimeMs;         // 파일 날짜 자정부터 ms (현지 시각)
+    BYTE    Code;           // BLOG_xxx
+    BYTE    Link;           // 포트 번호 (0: 포트가 하나 - 접두어 없음)
+    BYTE    Result;         // BLOG_RES_xxx
+    BYTE    Flags;          // BLOG_F_xxx
+    WORD    Items;          // 아이템 수
+    WORD    Changes;        // 변경 수 (쓰기: 성공 수)
+    WORD    Bytes;          // 전송 바이트 수
+    WORD    Extra;          // 압축 전 길이 / 샘플 수 / 쓰기 처리 ms / 우선 전송 지연
+};
+
+// 이벤트 코드
+#define BLOG_DATA       1       // 데이터 전송 (D:5(C:2) TX:43 OK)
+#define BLOG_WRITE      2       // ESP32 쓰기 명령 (WR 3 OK:3 T:14ms)
+#define BLOG_PRIO       3       // 우선 전송 (A:2 TX:23 L:3.1ms, Extra = 지연 0.1ms 단위)
+
+// 결과 (NAK 는 상태 코드를 하위 비트에)
+#define BLOG_RES_OK     0x00
+#define BLOG_RES_TMO    0x01
+#define BLOG_RES_NAK    0x80
+
+// 플래그
+#define BLOG_F_HB       0x01    // Heartbeat
+#define BLOG_F_Z        0x02    // 압축 전송 (Extra = 원본 길이)
+#define BLOG_F_BATCH    0x04    // 다중 샘플 묶음 (Extra = 샘플 수)
+#define BLOG_F_KA       0x08    // 생존 확인 프레임 (K:5 TX:12)
+
+void BinLogHeader(TBinLogHdr* h, int year, int month, int day);
+bool BinLogCheck(const TBinLogHdr* h);
+
+// 에이전트 텍스트 로그와 같은 형식으로 한 줄 (줄바꿈 없음, 길이 반환)
+// 형식: [10:00:05] P2 D:5(C:2) TX:31(Z:55) OK
+#define BLOG_LINE_MAX   96
+int  BinLogFormat(const TBinLogRec* r, char* buf);     // buf 는 BLOG_LINE_MAX 이상
+
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,169 @@
+//---------------------------------------------------------------------------
+// 이진 이벤트 로그 디코더 (콘솔, 오프라인)
+// 빌드: bcc32 BinLogDump.cpp BinLog.cpp RingLog.cpp   (리눅스: g++ BinLogDump.cpp BinLog.cpp RingLog.cpp)
+//
+// 사용: BinLogDump [옵션] logbin_20260118.bin ...
+//   -f HH:MM[:SS]  이 시각부터
+//   -t HH:MM[:SS]  이 시각까지
+//   -p N           N번 포트만 (포트가 하나면 0)
+//   -e             실패/타임아웃만
+//   -s             요약만 (파일별 전송 수 / 실패 수 / 바이트 합)
+//
+// 출력은 에이전트 텍스트 로그와 같은 형식 (파일마다 날짜 머리줄)
+// 텍스트 링 로그 (logsave.ring) 를 주면 오래된 줄부터 그대로 출력 (옵션 무시)
+//---------------------------------------------------------------------------
+#include "BinLog.h"
+#include "RingLog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define READ_RECS   4096
+
+static DWORD ParseTime(const char* s)
+{
+    int h = 0, m = 0, sec = 0;
+    sscanf(s, "%d:%d:%d", &h, &m, &sec);
+    return (DWORD)((h * 3600 + m * 60 + sec) * 1000);
+}
+
+static bool IsFailure(const TBinLogRec* r)
+{
+    return r->Result != BLOG_RES_OK;
+}
+
+//---------------------------------------------------------------------------
+// 링 로그를 시간 순서로 (한 바퀴 돌았으면 Head 뒤부터, 잘린 첫 줄은 버림)
+//---------------------------------------------------------------------------
+static void DumpRing(FILE* fp)
+{
+    TRingLogHdr hdr;
+    fseek(fp, 0, SEEK_SET);
+    if (fread(&hdr, sizeof(hdr), 1, fp) != 1 || hdr.Magic != RLOG_MAGIC ||
+        !RingLogCheck(&hdr, hdr.DataSize))
+    {
+        fprintf(stderr, "bad ring header\n");
+        return;
+    }
+
+    BYTE* data = (BYTE*)malloc(hdr.DataSize);
+    if (data == NULL || fread(data, 1, hdr.DataSize, fp) != hdr.DataSize)
+    {
+        fprintf(stderr, "short ring file\n");
+        free(data);
+        return;
+    }
+
+    DWORD p = 0;
+    if (hdr.Wraps > 0)
+    {
+        // 잘린 줄이 끝을 넘어 이어질 수 있으므로 처음 쪽까지 찾는다
+        p = hdr.Head;
+        while (p < hdr.DataSize && data[p] != '\n') p++;
+        if (p < hdr.DataSize)
+        {
+            fwrite(data + p + 1, 1, hdr.DataSize - p - 1, stdout);
+            p = 0;
+        }
+        else
+        {
+            p = 0;
+            while (p < hdr.Head && data[p] != '\n') p++;
+            p = (p < hdr.Head) ? p + 1 : hdr.Head;
+        }
+    }
+    fwrite(data + p, 1, hdr.Head - p, stdout);
+    free(data);
+}
+
+//---------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    DWORD from = 0, to = 0xFFFFFFFF;
+    int link = -1;
+    bool errorsOnly = false;
+    bool summary = false;
+    int files = 0;
+
+    static TBinLogRec recs[READ_RECS];
+    char line[BLOG_LINE_MAX];
+
+    for (int a = 1; a < argc; a++)
+    {
+        if (strcmp(argv[a], "-f") == 0 && a + 1 < argc)      { from = ParseTime(argv[++a]); continue; }
+        if (strcmp(argv[a], "-t") == 0 && a + 1 < argc)      { to = ParseTime(argv[++a]) + 999; continue; }
+        if (strcmp(argv[a], "-p") == 0 && a + 1 < argc)      { link = atoi(argv[++a]); continue; }
+        if (strcmp(argv[a], "-e") == 0)                       { errorsOnly = true; continue; }
+        if (strcmp(argv[a], "-s") == 0)                       { summary = true; continue; }
+
+        FILE* fp = fopen(argv[a], "rb");
+        if (fp == NULL)
+        {
+            fprintf(stderr, "%s: open fail\n", argv[a]);
+            continue;
+        }
+
+        TBinLogHdr hdr;
+        if (fread(&hdr, sizeof(hdr), 1, fp) == 1 && hdr.Magic == RLOG_MAGIC)
+        {
+            files++;
+            DumpRing(fp);
+            fclose(fp);
+            continue;
+        }
+        if (hdr.Magic != BLOG_MAGIC || !BinLogCheck(&hdr))
+        {
+            fprintf(stderr, "%s: not a log file\n", argv[a]);
+            fclose(fp);
+            continue;
+        }
+        files++;
+
+        printf("=== %04d-%02d-%02d (%s)\n", hdr.Year, hdr.Month, hdr.Day, argv[a]);
+
+        unsigned long sends = 0, fails = 0, bytes = 0, writes = 0;
+        size_t n;
+        while ((n = fread(recs, sizeof(TBinLogRec), READ_RECS, fp)) > 0)
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                const TBinLogRec* r = &recs[i];
+                if (r->TimeMs < from || r->TimeMs > to)
+                    continue;
+                if (link >= 0 && r->Link != link)
+                    continue;
+                if (errorsOnly && !IsFailure(r))
+                    continue;
+
+                if (r->Code == BLOG_DATA)
+                {
+                    sends++;
+                    bytes += r->Bytes;
+                    if (IsFailure(r)) fails++;
+                }
+                else if (r->Code == BLOG_WRITE)
+                {
+                    writes++;
+                }
+
+                if (!summary)
+                {
+                    BinLogFormat(r, line);
+                    puts(line);
+                }
+            }
+        }
+        fclose(fp);
+
+        if (summary)
+            printf("TX:%lu FAIL:%lu BYTES:%lu WR:%lu\n", sends, fails, bytes, writes);
+    }
+
+    if (files == 0)
+    {
+        fprintf(stderr, "usage: BinLogDump [-f HH:MM] [-t HH:MM] [-p N] [-e] [-s] logbin_YYYYMMDD.bin ...\n"
+                        "       BinLogDump logsave.ring\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,239 @@
+//---------------------------------------------------------------------------
+// 아이템 설정 CSV 파싱 측정 (콘솔, 오프라인)
+// 빌드: bcc32 CsvBench.cpp CsvScan.cpp   (리눅스: g++ -O2 CsvBench.cpp CsvScan.cpp)
+//
+// 사용: CsvBench [옵션] [oem_param.csv]
+//   -n N    합성 행 수 (기본 100000, 파일을 주면 무시)
+//   -r N    반복 수 - 가장 빠른 회차를 출력 (기본 5)
+//
+// 파일을 주지 않으면 에이전트 CSV 와 같은 형식의 행을 만든다
+// (인용 필드 안의 쉼표/"" 포함, ItemID 는 16비트라 65536 행마다 겹친다).
+//   SCAN   CsvNextRow 로 행/필드 분리만
+//   HASH   CsvHash (캐시 이미지 사용 여부 판단 - 파싱 생략 경로)
+//   LOAD   ParseItemRows 와 같은 검사 (ItemID/중복/Priority) + 저장 필드 CsvCopy
+//          (에이전트처럼 앞의 MAX_OPC_ITEMS 행만 복사)
+//
+// 출력: 단계 / 행 수 / 크기 / 시간 (ms) / 처리량 (MB/s)
+//---------------------------------------------------------------------------
+#include "CsvScan.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define BENCH_MAX_ITEMS 500             // 에이전트 MAX_OPC_ITEMS
+#define BENCH_TEXT_MAX  128
+
+//---------------------------------------------------------------------------
+// 시계 (ms)
+//---------------------------------------------------------------------------
+#ifdef _WIN32
+static double NowMs()
+{
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER t;
+    if (freq.QuadPart == 0)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&t);
+    return (double)t.QuadPart * 1000.0 / (double)freq.QuadPart;
+}
+#else
+static double NowMs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+#endif
+
+//---------------------------------------------------------------------------
+// 저장 필드 (에이전트 TOPCItemInfo 의 문자열 대신 고정 버퍼)
+//---------------------------------------------------------------------------
+struct TBenchItem
+{
+    long    ItemID;
+    long    Priority;
+    char    TagName[BENCH_TEXT_MAX];
+    char    DataType[16];
+    char    Description[BENCH_TEXT_MAX];
+    char    Server[BENCH_TEXT_MAX];
+};
+
+static TBenchItem g_Items[BENCH_MAX_ITEMS];
+
+//---------------------------------------------------------------------------
+// 합성 CSV (반환: 길이, *out 은 호출측이 delete[])
+//---------------------------------------------------------------------------
+static int MakeRows(int rows, char** out)
+{
+    static const char* server = "Matrikon.OPC.Simulation.1";
+    int cap = 64 + rows * (96 + (int)strlen(server));
+    char* buf = new char[cap];
+    int len = sprintf(buf, "ItemID,TagName,DataType,Description,Server,Priority\r\n");
+
+    for (int i = 0; i < rows; i++)
+        len += sprintf(buf + len, "%d,Plant.Area%d.Tag%d,REAL,\"Temp \"\"A\"\", zone %d\",%s,%d\r\n",
+                       i & 0xFFFF, i % 50, i, i % 50, (i % 7) ? server : "", (i % 97) == 0);
+
+    *out = buf;
+    return len;
+}
+
+static char* ReadFile(const char* path, int* len)
+{
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL)
+        return NULL;
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    char* buf = new char[size > 0 ? size : 1];
+    *len = (int)fread(buf, 1, size, fp);
+    fclose(fp);
+    return buf;
+}
+
+//---------------------------------------------------------------------------
+// 단계별 한 회
+//---------------------------------------------------------------------------
+static int RunScan(const char* data, int len)
+{
+    TCsvReader r;
+    TCsvField f[CSV_MAX_FIELDS];
+    int rows = 0;
+
+    CsvInit(&r, data, len);
+    while (CsvNextRow(&r, f, CSV_MAX_FIELDS) >= 0)
+        rows++;
+    return rows - 1;                    // 헤더 제외
+}
+
+static int RunLoad(const char* data, int len, int* count, int* errors)
+{
+    TCsvReader r;
+    TCsvField f[CSV_MAX_FIELDS];
+    unsigned char seen[0x10000 / 8];
+    memset(seen, 0, sizeof(seen));
+
+    *count = 0;
+    *errors = 0;
+    int rows = 0;
+
+    CsvInit(&r, data, len);
+    CsvNextRow(&r, f, CSV_MAX_FIELDS);      // 헤더
+
+    int n;
+    while ((n = CsvNextRow(&r, f, CSV_MAX_FIELDS)) >= 0)
+    {
+        if (n == 1 && f[0].Len == 0)
+            continue;
+        if (f[0].Len > 0 && !f[0].Quoted && f[0].Ptr[0] == '#')
+            continue;
+        rows++;
+
+        long id = 0;
+        long priority = 0;
+        bool bad = r.BadQuote ||
+                   n < 3 || f[1].Len == 0 || f[2].Len == 0 ||
+                   !CsvToInt(&f[0], &id) || id < 0 || id > 0xFFFF ||
+                   (seen[id >> 3] & (1 << (id & 7))) ||
+                   (n > 5 && f[5].Len > 0 && (!CsvToInt(&f[5], &priority) || priority < 0));
+        if (bad)
+        {
+            (*errors)++;
+            continue;
+        }
+        seen[id >> 3] |= (unsigned char)(1 << (id & 7));
+
+        if (*count >= BENCH_MAX_ITEMS)
+            continue;
+
+        TBenchItem* item = &g_Items[*count];
+        item->ItemID = id;
+        item->Priority = priority;
+        item->TagName[CsvCopy(&f[1], item->TagName, BENCH_TEXT_MAX - 1)] = 0;
+        item->DataType[CsvCopy(&f[2], item->DataType, sizeof(item->DataType) - 1)] = 0;
+        item->Description[(n > 3) ? CsvCopy(&f[3], item->Description, BENCH_TEXT_MAX - 1) : 0] = 0;
+        item->Server[(n > 4) ? CsvCopy(&f[4], item->Server, BENCH_TEXT_MAX - 1) : 0] = 0;
+        if (n > 3) CsvFieldEncoding(&r, &f[3]);
+        (*count)++;
+    }
+    return rows;
+}
+
+//---------------------------------------------------------------------------
+static void Report(const char* name, int rows, int len, double ms)
+{
+    printf("%-5s %7d rows %7dKB %9.2fms %8.1fMB/s\n",
+           name, rows, len / 1024, ms, (ms > 0) ? (double)len / 1048576.0 / (ms / 1000.0) : 0.0);
+}
+
+//---------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    int rows = 100000;
+    int repeat = 5;
+    const char* path = NULL;
+
+    for (int a = 1; a < argc; a++)
+    {
+        if (strcmp(argv[a], "-n") == 0 && a + 1 < argc)      { rows = atoi(argv[++a]); continue; }
+        if (strcmp(argv[a], "-r") == 0 && a + 1 < argc)      { repeat = atoi(argv[++a]); continue; }
+        if (argv[a][0] != '-' && path == NULL)              { path = argv[a]; continue; }
+        fprintf(stderr, "usage: CsvBench [-n rows] [-r repeat] [oem_param.csv]\n");
+        return 2;
+    }
+    if (rows < 1) rows = 1;
+    if (repeat < 1) repeat = 1;
+
+    char* data;
+    int len;
+    if (path != NULL)
+    {
+        data = ReadFile(path, &len);
+        if (data == NULL)
+        {
+            fprintf(stderr, "%s: cannot open\n", path);
+            return 1;
+        }
+    }
+    else
+    {
+        len = MakeRows(rows, &data);
+    }
+
+    double scanMs = 1e30, hashMs = 1e30, loadMs = 1e30;
+    int scanRows = 0, loadRows = 0, count = 0, errors = 0;
+    volatile unsigned long sink = 0;
+
+    for (int k = 0; k < repeat; k++)
+    {
+        double t0 = NowMs();
+        scanRows = RunScan(data, len);
+        double t1 = NowMs();
+        sink ^= CsvHash(data, len, CSV_HASH_SEED);
+        double t2 = NowMs();
+        loadRows = RunLoad(data, len, &count, &errors);
+        double t3 = NowMs();
+
+        if (t1 - t0 < scanMs) scanMs = t1 - t0;
+        if (t2 - t1 < hashMs) hashMs = t2 - t1;
+        if (t3 - t2 < loadMs) loadMs = t3 - t2;
+    }
+
+    Report("SCAN", scanRows, len, scanMs);
+    Report("HASH", scanRows, len, hashMs);
+    Report("LOAD", loadRows, len, loadMs);
+    printf("      I:%d E:%d (first: %ld %s \"%s\")\n", count, errors,
+           count > 0 ? g_Items[0].ItemID : 0L, count > 0 ? g_Items[0].TagName : "",
+           count > 0 ? g_Items[0].Description : "");
+
+    delete[] data;
+    return 0;
+}
@@ -0,0 +1,212 @@
+//---------------------------------------------------------------------------
+#include "CsvScan.h"
+
+//---------------------------------------------------------------------------
+void CsvInit(TCsvReader* r, const char* data, int len)
+{
+    r->Pos = data;
+    r->End = data + len;
+    r->Line = 1;
+    r->RowLine = 1;
+    r->Encoding = CSV_ENC_UNKNOWN;
+    r->BadQuote = false;
+
+    if (len >= 3 && (unsigned char)data[0] == 0xEF &&
+        (unsigned char)data[1] == 0xBB && (unsigned char)data[2] == 0xBF)
+    {
+        r->Pos += 3;
+        r->Encoding = CSV_ENC_UTF8;
+    }
+}
+
+//---------------------------------------------------------------------------
+// 한 행 분리 (버퍼를 한 번만 훑음)
+//---------------------------------------------------------------------------
+int CsvNextRow(TCsvReader* r, TCsvField* fields, int maxFields)
+{
+    const char* p = r->Pos;
+    const char* end = r->End;
+
+    if (p >= end)
+        return -1;
+
+    int count = 0;
+    r->RowLine = r->Line;
+    r->BadQuote = false;
+
+    for (;;)
+    {
+        TCsvField f;
+        f.Quoted = false;
+        f.HighBytes = false;
+
+        while (p < end && (*p == ' ' || *p == '\t'))
+            p++;
+
+        if (p < end && *p == '"')
+        {
+            f.Quoted = true;
+            f.Ptr = ++p;
+            for (;;)
+            {
+                if (p >= end)
+                {
+                    r->BadQuote = true;
+                    break;
+                }
+                char c = *p;
+                if (c == '"')
+                {
+                    if (p + 1 < end && p[1] == '"')
+                    {
+                        p += 2;
+                        continue;
+                    }
+                    break;
+                }
+                if (c == '\n') r->Line++;
+                if ((unsigned char)c >= 0x80) f.HighBytes = true;
+                p++;
+            }
+            f.Len = (int)(p - f.Ptr);
+            if (p < end) p++;
+
+            // 닫는 따옴표 뒤 구분자까지는 무시
+            while (p < end && *p != ',' && *p != '\n' && *p != '\r')
+                p++;
+        }
+        else
+        {
+            f.Ptr = p;
+            while (p < end && *p != ',' && *p != '\n' && *p != '\r')
+            {
+                if ((unsigned char)*p >= 0x80) f.HighBytes = true;
+                p++;
+            }
+            const char* e = p;
+            while (e > f.Ptr && (e[-1] == ' ' || e[-1] == '\t'))
+                e--;
+            f.Len = (int)(e - f.Ptr);
+        }
+
+        if (count < maxFields)
+            fields[count++] = f;
+
+        if (p < end && *p == ',')
+        {
+            p++;
+            continue;
+        }
+        break;
+    }
+
+    // 줄 끝 (CRLF / LF / CR)
+    if (p < end && *p == '\r') p++;
+    if (p < end && *p == '\n') p++;
+    r->Line++;
+
+    r->Pos = p;
+    return count;
+}
+
+//---------------------------------------------------------------------------
+int CsvCopy(const TCsvField* f, char* dst, int cap)
+{
+    int n = 0;
+
+    if (!f->Quoted)
+    {
+        n = (f->Len < cap) ? f->Len : cap;
+        for (int i = 0; i < n; i++)
+            dst[i] = f->Ptr[i];
+        return n;
+    }
+
+    for (int i = 0; i < f->Len && n < cap; i++)
+    {
+        dst[n++] = f->Ptr[i];
+        if (f->Ptr[i] == '"' && i + 1 < f->Len && f->Ptr[i + 1] == '"')
+            i++;
+    }
+    return n;
+}
+
+//---------------------------------------------------------------------------
+bool CsvToInt(const TCsvField* f, long* out)
+{
+    const char* p = f->Ptr;
+    const char* end = p + f->Len;
+    bool neg = false;
+
+    if (p < end && (*p == '-' || *p == '+'))
+        neg = (*p++ == '-');
+    if (p >= end)
+        return false;
+
+    long v = 0;
+    for (; p < end; p++)
+    {
+        if (*p < '0' || *p > '9')
+            return false;
+        if (v > 0x0CCCCCCC)
+            return false;
+        v = v * 10 + (*p - '0');
+    }
+
+    *out = neg ? -v : v;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+int CsvFieldEncoding(TCsvReader* r, const TCsvField* f)
+{
+    if (!f->HighBytes)
+        return CSV_ENC_ANSI;        // ASCII 는 어느 쪽이든 같음
+
+    if (r->Encoding == CSV_ENC_UNKNOWN)
+        r->Encoding = CsvIsUtf8(f->Ptr, f->Len) ? CSV_ENC_UTF8 : CSV_ENC_ANSI;
+
+    return r->Encoding;
+}
+
+//---------------------------------------------------------------------------
+// UTF-8 유효성 (CP949 한글은 두 번째 바이트가 연속 바이트가 아니라서 거의 항상 실패)
+//---------------------------------------------------------------------------
+bool CsvIsUtf8(const char* p, int len)
+{
+    const unsigned char* s = (const unsigned char*)p;
+    int i = 0;
+
+    while (i < len)
+    {
+        unsigned char c = s[i];
+        int extra;
+
+        if (c < 0x80)                   extra = 0;
+        else if (c >= 0xC2 && c < 0xE0) extra = 1;
+        else if (c >= 0xE0 && c < 0xF0) extra = 2;
+        else if (c >= 0xF0 && c < 0xF5) extra = 3;
+        else return false;
+
+        for (int k = 1; k <= extra; k++)
+        {
+            if (i + k >= len || (s[i + k] & 0xC0) != 0x80)
+                return false;
+        }
+        i += extra + 1;
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+unsigned long CsvHash(const char* p, int len, unsigned long h)
+{
+    const unsigned char* s = (const unsigned char*)p;
+    for (int i = 0; i < len; i++)
+    {
+        h ^= s[i];
+        h = (h * 16777619UL) & 0xFFFFFFFFUL;
+    }
+    return h;
+}
+//---------------------------------------------------------------------------
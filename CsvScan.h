@@ -0,0 +1,58 @@
+//---------------------------------------------------------------------------
+#ifndef CsvScanH
+#define CsvScanH
+//---------------------------------------------------------------------------
+// 아이템 설정 CSV 토크나이저 (VCL 비의존 - 리눅스에서도 단독 컴파일 가능)
+// 필드는 파일 버퍼를 그대로 가리키는 뷰로 돌려주고, 문자열 복사는
+// 호출측이 실제로 저장할 필드에 대해서만 한다.
+// - 쉼표 구분, 큰따옴표 인용 ("" = 따옴표 하나, 인용 안의 쉼표/줄바꿈 허용)
+// - CRLF / LF 줄 끝, UTF-8 BOM 건너뜀
+// - 인용되지 않은 필드는 앞뒤 공백 제거
+//---------------------------------------------------------------------------
+#define CSV_MAX_FIELDS  8
+
+// 텍스트 인코딩 (BOM 이 없으면 0x80 이상 바이트가 처음 나온 필드로 판단)
+#define CSV_ENC_UNKNOWN 0
+#define CSV_ENC_ANSI    1       // 시스템 코드 페이지 (CP949)
+#define CSV_ENC_UTF8    2
+
+struct TCsvField
+{
+    const char* Ptr;
+    int         Len;
+    bool        Quoted;         // 인용 필드 ("" 치환은 CsvCopy에서)
+    bool        HighBytes;      // 0x80 이상 바이트 포함 (인코딩 변환 필요)
+};
+
+struct TCsvReader
+{
+    const char* Pos;
+    const char* End;
+    int         Line;           // 다음 행의 시작 줄 번호 (1부터)
+    int         RowLine;        // 마지막으로 읽은 행의 시작 줄 번호 (오류 보고용)
+    int         Encoding;
+    bool        BadQuote;       // 마지막 행에 닫히지 않은 인용이 있음
+};
+
+void CsvInit(TCsvReader* r, const char* data, int len);
+
+// 다음 행의 필드 수 (maxFields 초과분은 버림), 끝이면 -1
+int  CsvNextRow(TCsvReader* r, TCsvField* fields, int maxFields);
+
+// 인용 해제 복사 (cap 바이트까지), 복사한 길이 반환
+int  CsvCopy(const TCsvField* f, char* dst, int cap);
+
+// 정수 필드 (부호 + 숫자만, 빈 필드/다른 문자는 false)
+bool CsvToInt(const TCsvField* f, long* out);
+
+// 필드 텍스트 인코딩 (아직 모르면 이 필드로 결정)
+int  CsvFieldEncoding(TCsvReader* r, const TCsvField* f);
+
+bool CsvIsUtf8(const char* p, int len);
+
+// 내용 해시 (FNV-1a 32비트, 이어서 계산하려면 이전 결과를 h 로)
+#define CSV_HASH_SEED   2166136261UL
+unsigned long CsvHash(const char* p, int len, unsigned long h);
+
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,412 @@
+//---------------------------------------------------------------------------
+// 정상 수집 주기 할당 검사 (콘솔, 오프라인)
+// 빌드: bcc32 CycleCheck.cpp ScanCycle.cpp EspProto.cpp RingLog.cpp
+//       (리눅스: g++ -O2 CycleCheck.cpp ScanCycle.cpp EspProto.cpp RingLog.cpp)
+//
+// 사용: CycleCheck [옵션]
+//   -n N    아이템 수 (기본 100, 최대 MAX_OPC_ITEMS)
+//   -c N    측정 주기 수 (기본 10000)
+//
+// 에이전트와 같은 ScanCycle 함수로 읽기 반영(CyclePublish) -> 변경 감지(CycleMerge)
+// -> 프레임 패치(FramePatch) + 대기열/묶음 샘플(LinkCapture) -> 전송 (데이터 / 묶음 /
+// 생존 확인) -> 장치쪽 응답 -> 응답 디코드(RxPush/RxNext) -> ACK 처리(LinkAcked)
+// -> 결과 로그 한 줄(LinkFormatResult + RingLogPut) 을 주기마다 돈다.
+//   P1  데이터 프레임, 전체 아이템 (CNT 1바이트라 FRAME_ITEMS_MAX 까지)
+//   P2  FRAME_VALUES + 묶음 전송 (Batch 4), 홀수 아이템
+// 장치쪽은 메모리 포트로 받은 프레임의 STX/SOH, ETX, 체크섬을 확인하고 응답한다.
+// 가끔 앞에 잡음 바이트를 섞고, NAK(CHK) 와 무응답(타임아웃)도 돌려준다.
+//
+// 첫 주기는 예열이고, 이후 주기 동안 할당 수를 센다.
+//   new / new[]                - 모든 컴파일러
+//   malloc / calloc / realloc  - glibc (__libc_xxx 로 넘김)
+// 출력: 주기 / 아이템 / 프레임 / ACK / 실패 / 할당 수 / 시간
+// 할당이 하나라도 있거나 프레임/상태 확인이 어긋나면 종료 코드 1.
+//---------------------------------------------------------------------------
+#include "ScanCycle.h"
+#include "RingLog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+#define CHECK_LINKS     2
+#define CHECK_LOG_SIZE  RLOG_MIN_SIZE
+#define CHECK_LINE_MAX  256
+#define CHECK_OLE_BASE  46000.0         // 원본 시각 기준 (OLE DATE, 2025-12)
+
+//---------------------------------------------------------------------------
+// 할당 계수 (g_Counting 동안만)
+//---------------------------------------------------------------------------
+static volatile bool g_Counting;
+static volatile long g_Allocs;
+
+static void CountAlloc()
+{
+    if (g_Counting)
+        g_Allocs++;
+}
+
+#ifdef __GLIBC__
+extern "C"
+{
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void  __libc_free(void* p);
+
+void* malloc(size_t size) throw()                { CountAlloc(); return __libc_malloc(size); }
+void* calloc(size_t n, size_t size) throw()      { CountAlloc(); return __libc_calloc(n, size); }
+void* realloc(void* p, size_t size) throw()      { CountAlloc(); return __libc_realloc(p, size); }
+void  free(void* p) throw()                      { __libc_free(p); }
+}
+
+static void* RawAlloc(size_t size)  { return __libc_malloc(size ? size : 1); }
+static void  RawFree(void* p)       { __libc_free(p); }
+#else
+static void* RawAlloc(size_t size)  { return malloc(size ? size : 1); }
+static void  RawFree(void* p)       { free(p); }
+#endif
+
+void* operator new(size_t size)
+{
+    CountAlloc();
+    void* p = RawAlloc(size);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    CountAlloc();
+    void* p = RawAlloc(size);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) throw()      { RawFree(p); }
+void operator delete[](void* p) throw()    { RawFree(p); }
+#if __cplusplus >= 201402L
+void operator delete(void* p, size_t) throw()      { RawFree(p); }
+void operator delete[](void* p, size_t) throw()    { RawFree(p); }
+#endif
+
+//---------------------------------------------------------------------------
+// 시계 (ms)
+//---------------------------------------------------------------------------
+#ifdef _WIN32
+static double NowMs()
+{
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER t;
+    if (freq.QuadPart == 0)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&t);
+    return (double)t.QuadPart * 1000.0 / (double)freq.QuadPart;
+}
+#else
+static double NowMs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+#endif
+
+//---------------------------------------------------------------------------
+// 장치쪽 응답 (메모리 포트)
+//---------------------------------------------------------------------------
+#define DEV_ACK         0
+#define DEV_JUNK        1               // 응답 앞에 잡음 바이트
+#define DEV_NAK         2               // 체크섬이 맞아도 NAK(CHK)
+#define DEV_DROP        3               // 응답 없음 (타임아웃)
+
+struct TFakePort
+{
+    BYTE    Wire[BATCH_SIZE(MAX_OPC_ITEMS)];
+    int     Len;
+};
+
+// 에이전트 TVaComm::WriteBuf 자리
+static void PortWrite(TFakePort* port, const BYTE* buf, int len)
+{
+    memcpy(port->Wire, buf, len);
+    port->Len = len;
+}
+
+// 프레임 확인 후 응답을 수신 디코더에 (프레임이 온전하면 true)
+static bool DevService(TFakePort* port, TRxDecoder* rx, int mode)
+{
+    const BYTE* f = port->Wire;
+    int len = port->Len;
+    BYTE status = RESP_STATUS_OK;
+
+    if (len < FRAME_HDR_LEN + FRAME_TAIL_LEN ||
+        (f[0] != PROTO_STX && f[0] != PROTO_SOH) || f[len - 1] != PROTO_ETX)
+        status = RESP_STATUS_LEN;
+    else if (ProtoChecksum(f + 1, len - 3) != f[len - 2])
+        status = RESP_STATUS_CHK;
+    bool good = (status == RESP_STATUS_OK);
+
+    if (mode == DEV_DROP)
+        return good;
+    if (mode == DEV_NAK)
+        status = RESP_STATUS_CHK;
+
+    if (mode == DEV_JUNK)
+    {
+        static const BYTE junk[] = { 0xFF, PROTO_STX, 0x00, PROTO_ETX };
+        RxPush(rx, junk, sizeof(junk));
+    }
+
+    BYTE cmd = (status == RESP_STATUS_OK) ? RESP_CMD_ACK : RESP_CMD_NAK;
+    BYTE resp[RESP_FRAME_LEN] = { PROTO_STX, cmd, status, (BYTE)(cmd ^ status), PROTO_ETX };
+    RxPush(rx, resp, RESP_FRAME_LEN);
+    return good;
+}
+
+//---------------------------------------------------------------------------
+// 검사 상태 (모두 정적 - 주기 중에는 힙을 쓰지 않음)
+//---------------------------------------------------------------------------
+static TCycleItem   g_Items[MAX_OPC_ITEMS];
+static long         g_Raw[MAX_OPC_ITEMS];
+static TCycleLink   g_Links[CHECK_LINKS];
+static TFakePort    g_Ports[CHECK_LINKS];
+static BYTE         g_BatchFrame[BATCH_SIZE(MAX_OPC_ITEMS)];
+static BYTE         g_CtrlBuf[EXT_SIZE(KEEPALIVE_LEN)];
+static WORD         g_KeepaliveSeq;
+static BYTE         g_LogMem[sizeof(TRingLogHdr) + CHECK_LOG_SIZE];
+
+static int          g_ItemCount;
+static DWORD        g_Frames;
+static DWORD        g_Acks;
+static DWORD        g_TxFails;
+static DWORD        g_Errors;
+
+static void Fail(int c, int l, const char* what)
+{
+    // 할당 계수를 멈추고 출력 (stdio 버퍼는 힙일 수 있음)
+    bool counting = g_Counting;
+    g_Counting = false;
+    if (g_Errors++ < 10)
+        printf("FAIL C:%d P%d %s\n", c, l + 1, what);
+    g_Counting = counting;
+}
+
+//---------------------------------------------------------------------------
+// 포트 구성 (에이전트 RebuildLinks/BuildPacket 과 같은 순서)
+//---------------------------------------------------------------------------
+static void SetupLink(int l, bool values, int batch, int step)
+{
+    TCycleLink* L = &g_Links[l];
+    memset(L, 0, sizeof(*L));
+
+    for (int i = 0; i < g_ItemCount; i++)
+    {
+        g_Items[i].LinkSlot[l] = -1;
+        if ((i % step) != (step - 1) || L->SlotCount >= (values ? MAX_OPC_ITEMS : FRAME_ITEMS_MAX))
+            continue;
+
+        int k = L->SlotCount++;
+        L->Slots[k] = i;
+        L->SlotID[k] = (WORD)(1000 + i);
+        L->AckValue[k] = g_Items[i].Value;
+        L->AckQCode[k] = g_Items[i].QCode;
+        g_Items[i].LinkSlot[l] = (short)k;
+    }
+
+    if (values)
+        FrameLayoutValues(&L->Frame, L->FrameBuf, L->SlotCount, 0x5CA1AB1E);
+    else
+        FrameLayout(&L->Frame, L->FrameBuf, L->SlotCount);
+    LinkClearSamples(L);
+    for (int k = 0; k < L->SlotCount; k++)
+    {
+        const TCycleItem* item = &g_Items[L->Slots[k]];
+        FrameSetItem(&L->Frame, k, L->SlotID[k], item->QCode, item->Value);
+    }
+    FrameSeal(&L->Frame);
+
+    L->Batch = batch;
+    L->BatchMs = 30;
+    RxReset(&L->Rx);
+}
+
+//---------------------------------------------------------------------------
+// 한 주기 (c: 주기 번호, 시각은 10ms 간격으로 흉내)
+//---------------------------------------------------------------------------
+static void RunCycle(int c, TRingLogHdr* log, BYTE* logData)
+{
+    DWORD now = (DWORD)c * 10;
+    LONGLONG nowMs = 1760000000000LL + (LONGLONG)c * 10;
+    bool quiet = (c % 50) == 49;        // 변경 없는 주기 (생존 확인)
+
+    // 1. 작업자 읽기 - 1/4 씩 값 변경, 홀수 아이템은 원본 시각 (시각만 바뀐 샘플)
+    if (!quiet)
+    {
+        for (int i = 0; i < g_ItemCount; i++)
+        {
+            if (((i + c) & 3) == 0)
+                g_Raw[i] = c * 7 + i;
+            long quality = ((i % 17) == 5 && (c % 40) < 3) ? 0x18 : 0xC0;
+            double srcTime = (i & 1) ? CHECK_OLE_BASE + (double)c * 10.0 / 86400000.0 : 0;
+            CyclePublish(&g_Items[i], true, g_Raw[i], quality, srcTime);
+        }
+    }
+
+    // 2. 메인 스레드 반영 + 포트별 프레임 패치 / 샘플
+    for (int i = 0; i < g_ItemCount; i++)
+    {
+        TCycleItem* item = &g_Items[i];
+        if (!item->Dirty)
+            continue;
+
+        int r = CycleMerge(item, nowMs);
+        for (int l = 0; l < CHECK_LINKS; l++)
+        {
+            TCycleLink* L = &g_Links[l];
+            int slot = item->LinkSlot[l];
+            if (slot < 0 || slot >= L->Frame.Count)
+                continue;
+            FramePatch(&L->Frame, slot, item->QCode, item->Value);
+            if (r & CYCLE_SAMPLE)
+                LinkCapture(L, slot, item, now);
+        }
+    }
+
+    // 3. 포트별 전송 -> 응답 -> 결과
+    for (int l = 0; l < CHECK_LINKS; l++)
+    {
+        TCycleLink* L = &g_Links[l];
+        int changes = LinkChanges(L);
+        const BYTE* tx;
+        int len;
+        int samples = 0;
+        bool keepalive = false;
+
+        if (L->Batch > 0 && L->SampleTotal > 0)
+        {
+            if (!L->BatchFull && now - L->BatchTick < L->BatchMs)
+                continue;
+            len = LinkBuildBatch(L, g_BatchFrame, &samples);
+            tx = g_BatchFrame;
+        }
+        else if ((L->Batch <= 0 && changes > 0) || L->Resync)
+        {
+            tx = L->Frame.Buf;
+            len = L->Frame.Length;
+        }
+        else
+        {
+            len = KeepaliveBuild(g_CtrlBuf, ++g_KeepaliveSeq, FrameDigest(&L->Frame));
+            tx = g_CtrlBuf;
+            keepalive = true;
+        }
+
+        TRxEvent ev;
+        while (RxNext(&L->Rx, &ev));            // 늦은 응답 정리
+        PortWrite(&g_Ports[l], tx, len);
+        LinkSent(L, len, 0, (L->Batch > 0) ? 0 : changes, samples, false, keepalive, now);
+        g_Frames++;
+
+        int mode = DEV_ACK;
+        if ((c % 97) == 96)      mode = DEV_NAK;
+        else if ((c % 89) == 88) mode = DEV_DROP;
+        else if ((c % 13) == 12) mode = DEV_JUNK;
+        if (!DevService(&g_Ports[l], &L->Rx, mode))
+            Fail(c, l, "bad frame");
+
+        while (RxNext(&L->Rx, &ev))
+            L->LastResp = ev;
+        bool ok = (L->LastResp.Cmd == RESP_CMD_ACK && L->LastResp.Status == RESP_STATUS_OK);
+        if (ok != (mode == DEV_ACK || mode == DEV_JUNK))
+            Fail(c, l, "unexpected response");
+
+        char line[CHECK_LINE_MAX];
+        int n = sprintf(line, "[%02d:%02d:%02d] P%d ", (c / 3600) % 24, (c / 60) % 60, c % 60, l + 1);
+        n += LinkFormatResult(line + n, L, ok);
+        line[n++] = '\r';
+        line[n++] = '\n';
+        RingLogPut(log, logData, line, n);
+
+        if (!ok)
+        {
+            L->WaitingAck = false;
+            L->Resync = true;                   // 다음 주기에 다시 전체 (에이전트는 재시도)
+            g_TxFails++;
+            continue;
+        }
+
+        g_Acks++;
+        bool tookSamples = (L->TxSamples > 0);
+        LinkAcked(L);
+        if (keepalive)
+            continue;
+        if (LinkChanges(L) != 0)
+            Fail(c, l, "changes after ACK");
+        if (L->Batch <= 0 && L->QueueDepth != 0)
+            Fail(c, l, "queue after ACK");
+        if (tookSamples && L->SampleTotal != 0)
+            Fail(c, l, "samples after ACK");
+    }
+}
+
+//---------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    int items = 100;
+    int cycles = 10000;
+
+    for (int a = 1; a < argc; a++)
+    {
+        if (strcmp(argv[a], "-n") == 0 && a + 1 < argc)      { items = atoi(argv[++a]); continue; }
+        if (strcmp(argv[a], "-c") == 0 && a + 1 < argc)      { cycles = atoi(argv[++a]); continue; }
+        fprintf(stderr, "usage: CycleCheck [-n items] [-c cycles]\n");
+        return 2;
+    }
+    if (items < 1) items = 1;
+    if (items > MAX_OPC_ITEMS) items = MAX_OPC_ITEMS;
+    if (cycles < 1) cycles = 1;
+    g_ItemCount = items;
+
+    TRingLogHdr* log = (TRingLogHdr*)g_LogMem;
+    BYTE* logData = g_LogMem + sizeof(TRingLogHdr);
+    RingLogInit(log, CHECK_LOG_SIZE);
+
+    SetupLink(0, false, 0, 1);
+    SetupLink(1, true, 4, 2);
+
+    // 품질만 바뀐 슬롯도 변경 (통신 실패 표시 - 값은 그대로)
+    TCycleItem* first = &g_Items[0];
+    CyclePublish(first, false, 0, 0x18, 0);
+    CycleMerge(first, 0);
+    FramePatch(&g_Links[0].Frame, first->LinkSlot[0], first->QCode, first->Value);
+    if (LinkChanges(&g_Links[0]) != 1)
+        Fail(0, 0, "quality-only change not counted");
+
+    // 첫 주기는 예열 (stdio 등 한 번만 일어나는 할당 제외)
+    RunCycle(0, log, logData);
+
+    double t0 = NowMs();
+    g_Allocs = 0;
+    g_Counting = true;
+    for (int c = 1; c <= cycles; c++)
+        RunCycle(c, log, logData);
+    g_Counting = false;
+    double ms = NowMs() - t0;
+
+    printf("CYCLE %d I:%d P:%d F:%u ACK:%u FAIL:%u A:%ld T:%.1fms (%.2fus/cycle) LOG:%uKB W:%u\n",
+           cycles, items, CHECK_LINKS, (unsigned)g_Frames, (unsigned)g_Acks, (unsigned)g_TxFails,
+           (long)g_Allocs, ms, ms * 1000.0 / cycles,
+           (unsigned)(CHECK_LOG_SIZE / 1024), (unsigned)log->Wraps);
+
+    if (g_Allocs != 0)
+        printf("ALLOC! steady cycle must not allocate\n");
+    if (g_Errors != 0)
+        printf("ERR:%u\n", (unsigned)g_Errors);
+    return (g_Allocs == 0 && g_Errors == 0) ? 0 : 1;
+}
@@ -0,0 +1,730 @@
+//---------------------------------------------------------------------------
+#include "EspProto.h"
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// 체크섬 계산 (XOR)
+//---------------------------------------------------------------------------
+BYTE ProtoChecksum(const BYTE* data, int len)
+{
+    BYTE checksum = 0;
+    for (int i = 0; i < len; i++)
+    {
+        checksum ^= data[i];
+    }
+    return checksum;
+}
+
+//---------------------------------------------------------------------------
+// 프레임 헤더/트레일러 배치
+// Length = STX 제외, Checksum/ETX 제외한 데이터 길이
+//---------------------------------------------------------------------------
+void FrameLayout(TFrameImage* f, BYTE* buf, int count)
+{
+    if (count > FRAME_ITEMS_MAX)
+        count = FRAME_ITEMS_MAX;
+
+    f->Buf = buf;
+    f->Count = count;
+    f->Length = FRAME_SIZE(count);
+    f->ItemOfs = FRAME_HDR_LEN;
+    f->Stride = FRAME_ITEM_LEN;
+    f->QOfs = 2;
+
+    WORD dataLen = (WORD)(f->Length - FRAME_TAIL_LEN - 1);
+    buf[0] = PROTO_STX;
+    buf[1] = (BYTE)(dataLen & 0xFF);
+    buf[2] = (BYTE)((dataLen >> 8) & 0xFF);
+    buf[3] = (BYTE)count;
+
+    buf[f->Length - 2] = 0;
+    buf[f->Length - 1] = PROTO_ETX;
+}
+
+//---------------------------------------------------------------------------
+// 위치 기반 데이터 프레임 배치 (ID 없이 스키마 해시 + 슬롯 순서의 Q/VAL)
+// [SOH][FRAME_VALUES][LEN_L][LEN_H][HASH 4B][CNT_L][CNT_H] + CNT x [Q][VAL 4B] + [CHK][ETX]
+//---------------------------------------------------------------------------
+void FrameLayoutValues(TFrameImage* f, BYTE* buf, int count, DWORD schemaHash)
+{
+    f->Buf = buf;
+    f->Count = count;
+    f->Length = VALUES_SIZE(count);
+    f->ItemOfs = EXT_HDR_LEN + SCHEMA_HDR_LEN;
+    f->Stride = VALUES_ITEM_LEN;
+    f->QOfs = 0;
+
+    int payloadLen = SCHEMA_HDR_LEN + count * VALUES_ITEM_LEN;
+    buf[0] = PROTO_SOH;
+    buf[1] = FRAME_VALUES;
+    buf[2] = (BYTE)(payloadLen & 0xFF);
+    buf[3] = (BYTE)((payloadLen >> 8) & 0xFF);
+    buf[4] = (BYTE)(schemaHash & 0xFF);
+    buf[5] = (BYTE)((schemaHash >> 8) & 0xFF);
+    buf[6] = (BYTE)((schemaHash >> 16) & 0xFF);
+    buf[7] = (BYTE)((schemaHash >> 24) & 0xFF);
+    buf[8] = (BYTE)(count & 0xFF);
+    buf[9] = (BYTE)((count >> 8) & 0xFF);
+
+    buf[f->Length - 2] = 0;
+    buf[f->Length - 1] = PROTO_ETX;
+}
+
+//---------------------------------------------------------------------------
+// 슬롯 전체 기록 (체크섬은 FrameSeal에서 일괄 계산)
+// ID 는 레코드에 ID 가 있는 데이터 프레임에만 기록된다.
+//---------------------------------------------------------------------------
+void FrameSetItem(TFrameImage* f, int slot, WORD id, BYTE quality, long value)
+{
+    if (slot >= f->Count)
+        return;                 // 프레임에 자리가 없는 슬롯 (FRAME_ITEMS_MAX 초과)
+
+    BYTE* p = f->Buf + f->ItemOfs + slot * f->Stride;
+
+    // Item ID (2 bytes, Little Endian)
+    if (f->QOfs >= 2)
+    {
+        p[0] = (BYTE)(id & 0xFF);
+        p[1] = (BYTE)((id >> 8) & 0xFF);
+    }
+    p += f->QOfs;
+
+    // Quality (1 byte)
+    p[0] = quality;
+
+    // Value (4 bytes, Little Endian)
+    p[1] = (BYTE)(value & 0xFF);
+    p[2] = (BYTE)((value >> 8) & 0xFF);
+    p[3] = (BYTE)((value >> 16) & 0xFF);
+    p[4] = (BYTE)((value >> 24) & 0xFF);
+}
+
+//---------------------------------------------------------------------------
+// 체크섬 전체 계산 (STX/SOH 다음부터 데이터 끝까지)
+//---------------------------------------------------------------------------
+void FrameSeal(TFrameImage* f)
+{
+    f->Buf[f->Length - 2] = ProtoChecksum(&f->Buf[1], f->Length - 3);
+}
+
+//---------------------------------------------------------------------------
+// Q/VAL 바이트 증분 패치
+// XOR 체크섬이므로 바뀐 바이트마다 chk ^= old ^ new 로 갱신된다.
+//---------------------------------------------------------------------------
+int FramePatch(TFrameImage* f, int slot, BYTE quality, long value)
+{
+    if (slot >= f->Count)
+        return 0;
+
+    BYTE* p = f->Buf + f->ItemOfs + slot * f->Stride + f->QOfs;
+    BYTE nb[5];
+    BYTE delta = 0;
+    int changed = 0;
+
+    nb[0] = quality;
+    nb[1] = (BYTE)(value & 0xFF);
+    nb[2] = (BYTE)((value >> 8) & 0xFF);
+    nb[3] = (BYTE)((value >> 16) & 0xFF);
+    nb[4] = (BYTE)((value >> 24) & 0xFF);
+
+    for (int i = 0; i < 5; i++)
+    {
+        if (p[i] != nb[i])
+        {
+            delta ^= (BYTE)(p[i] ^ nb[i]);
+            p[i] = nb[i];
+            changed++;
+        }
+    }
+
+    if (changed > 0)
+        f->Buf[f->Length - 2] ^= delta;
+
+    return changed;
+}
+
+//---------------------------------------------------------------------------
+// 확장 프레임 생성
+// [SOH][TYPE][LEN_L][LEN_H][PAYLOAD...][CHK][ETX]
+//---------------------------------------------------------------------------
+int FrameBuildExt(BYTE* buf, BYTE type, const BYTE* payload, int len)
+{
+    int pos = 0;
+
+    buf[pos++] = PROTO_SOH;
+    buf[pos++] = type;
+    buf[pos++] = (BYTE)(len & 0xFF);
+    buf[pos++] = (BYTE)((len >> 8) & 0xFF);
+
+    for (int i = 0; i < len; i++)
+        buf[pos++] = payload[i];
+
+    // Checksum (SOH 다음부터 데이터 끝까지)
+    buf[pos] = ProtoChecksum(&buf[1], pos - 1);
+    pos++;
+
+    buf[pos++] = PROTO_ETX;
+    return pos;
+}
+
+//---------------------------------------------------------------------------
+// 값 다이제스트 - 레코드 배치와 무관하게 슬롯 순서의 [Q][VAL 4B] 만 (FNV-1a)
+//---------------------------------------------------------------------------
+DWORD FrameDigest(const TFrameImage* f)
+{
+    DWORD h = 2166136261UL;
+    const BYTE* p = f->Buf + f->ItemOfs + f->QOfs;
+
+    for (int k = 0; k < f->Count; k++, p += f->Stride)
+    {
+        for (int i = 0; i < 5; i++)
+        {
+            h ^= p[i];
+            h *= 16777619UL;
+        }
+    }
+    return h;
+}
+
+//---------------------------------------------------------------------------
+// 생존 확인 프레임 [SEQ_L][SEQ_H][DIGEST 4B LE]
+//---------------------------------------------------------------------------
+int KeepaliveBuild(BYTE* buf, WORD seq, DWORD digest)
+{
+    BYTE payload[KEEPALIVE_LEN];
+    payload[0] = (BYTE)(seq & 0xFF);
+    payload[1] = (BYTE)((seq >> 8) & 0xFF);
+    payload[2] = (BYTE)(digest & 0xFF);
+    payload[3] = (BYTE)((digest >> 8) & 0xFF);
+    payload[4] = (BYTE)((digest >> 16) & 0xFF);
+    payload[5] = (BYTE)((digest >> 24) & 0xFF);
+    return FrameBuildExt(buf, FRAME_KEEPALIVE, payload, KEEPALIVE_LEN);
+}
+
+//---------------------------------------------------------------------------
+// 스키마 항목 하나 기록 [ID_L][ID_H][TYPE][SCALE][NAME_LEN][NAME...]
+// 이름은 SCHEMA_NAME_MAX 바이트까지만 (NUL 없음)
+//---------------------------------------------------------------------------
+int SchemaPutEntry(BYTE* p, WORD id, BYTE type, signed char scale, const char* name, int nameLen)
+{
+    if (nameLen > SCHEMA_NAME_MAX)
+        nameLen = SCHEMA_NAME_MAX;
+
+    p[0] = (BYTE)(id & 0xFF);
+    p[1] = (BYTE)((id >> 8) & 0xFF);
+    p[2] = type;
+    p[3] = (BYTE)scale;
+    p[4] = (BYTE)nameLen;
+    for (int i = 0; i < nameLen; i++)
+        p[5 + i] = (BYTE)name[i];
+
+    return 5 + nameLen;
+}
+
+//---------------------------------------------------------------------------
+// 스키마 해시 (FNV-1a, 항목 영역 전체)
+//---------------------------------------------------------------------------
+DWORD SchemaHash(const BYTE* entries, int len)
+{
+    DWORD h = 2166136261UL;
+    for (int i = 0; i < len; i++)
+    {
+        h ^= entries[i];
+        h *= 16777619UL;
+    }
+    return h;
+}
+
+//---------------------------------------------------------------------------
+// 스키마 payload 헤더 기록 [HASH 4B][CNT 2B] (payload 전체 길이 반환)
+//---------------------------------------------------------------------------
+int SchemaSeal(BYTE* payload, int count, int entriesLen, DWORD* hash)
+{
+    DWORD h = SchemaHash(payload + SCHEMA_HDR_LEN, entriesLen);
+
+    payload[0] = (BYTE)(h & 0xFF);
+    payload[1] = (BYTE)((h >> 8) & 0xFF);
+    payload[2] = (BYTE)((h >> 16) & 0xFF);
+    payload[3] = (BYTE)((h >> 24) & 0xFF);
+    payload[4] = (BYTE)(count & 0xFF);
+    payload[5] = (BYTE)((count >> 8) & 0xFF);
+
+    *hash = h;
+    return SCHEMA_HDR_LEN + entriesLen;
+}
+
+//---------------------------------------------------------------------------
+// 다중 샘플 아이템 블록 헤더 [ID_L][ID_H][N]
+//---------------------------------------------------------------------------
+int BatchPutItem(BYTE* p, WORD id, int samples)
+{
+    p[0] = (BYTE)(id & 0xFF);
+    p[1] = (BYTE)((id >> 8) & 0xFF);
+    p[2] = (BYTE)samples;
+    return 3;
+}
+
+//---------------------------------------------------------------------------
+// 샘플 하나 [DT 가변길이][Q][VAL 4B]
+//---------------------------------------------------------------------------
+int BatchPutSample(BYTE* p, DWORD dt, BYTE quality, long value)
+{
+    int pos = 0;
+    while (dt >= 0x80)
+    {
+        p[pos++] = (BYTE)((dt & 0x7F) | 0x80);
+        dt >>= 7;
+    }
+    p[pos++] = (BYTE)dt;
+
+    p[pos++] = quality;
+    p[pos++] = (BYTE)(value & 0xFF);
+    p[pos++] = (BYTE)((value >> 8) & 0xFF);
+    p[pos++] = (BYTE)((value >> 16) & 0xFF);
+    p[pos++] = (BYTE)((value >> 24) & 0xFF);
+    return pos;
+}
+
+//---------------------------------------------------------------------------
+// 다중 샘플 payload 헤더 [BASE_MS 8B][CNT_L][CNT_H]
+//---------------------------------------------------------------------------
+void BatchSeal(BYTE* payload, LONGLONG baseMs, int count)
+{
+    for (int i = 0; i < 8; i++)
+        payload[i] = (BYTE)((baseMs >> (i * 8)) & 0xFF);
+    payload[8] = (BYTE)(count & 0xFF);
+    payload[9] = (BYTE)((count >> 8) & 0xFF);
+}
+
+//---------------------------------------------------------------------------
+// 우선 전송 아이템 [ID_L][ID_H][Q][VAL 4B]
+//---------------------------------------------------------------------------
+int PriorityPutItem(BYTE* p, WORD id, BYTE quality, long value)
+{
+    p[0] = (BYTE)(id & 0xFF);
+    p[1] = (BYTE)((id >> 8) & 0xFF);
+    p[2] = quality;
+    p[3] = (BYTE)(value & 0xFF);
+    p[4] = (BYTE)((value >> 8) & 0xFF);
+    p[5] = (BYTE)((value >> 16) & 0xFF);
+    p[6] = (BYTE)((value >> 24) & 0xFF);
+    return PRIO_ITEM_LEN;
+}
+
+void PrioritySeal(BYTE* payload, BYTE seq, int count)
+{
+    payload[0] = seq;
+    payload[1] = (BYTE)count;
+}
+
+//---------------------------------------------------------------------------
+// 쓰기 명령 해석
+// FRAME_WRITE:       [SEQ][ID_L][ID_H][VAL 4B]
+// FRAME_WRITE_BATCH: [SEQ][CNT] + CNT x [ID_L][ID_H][VAL 4B]
+//---------------------------------------------------------------------------
+int WriteParse(const TRxCommand* c, BYTE* seq, TWriteItem* items)
+{
+    const BYTE* p = c->Data;
+    int count;
+    int pos;
+
+    if (c->Len < 1)
+        return -1;
+    *seq = p[0];
+
+    if (c->Type == FRAME_WRITE)
+    {
+        count = 1;
+        pos = 1;
+    }
+    else
+    {
+        if (c->Len < 2)
+            return -1;
+        count = p[1];
+        pos = 2;
+    }
+
+    if (count > WRITE_MAX || c->Len != pos + count * 6)
+        return -1;
+
+    for (int i = 0; i < count; i++, pos += 6)
+    {
+        items[i].ID = (WORD)(p[pos] | (p[pos + 1] << 8));
+        items[i].Value = (long)((DWORD)p[pos + 2] | ((DWORD)p[pos + 3] << 8) |
+                                ((DWORD)p[pos + 4] << 16) | ((DWORD)p[pos + 5] << 24));
+    }
+    return count;
+}
+
+//---------------------------------------------------------------------------
+// 쓰기 결과 프레임 [SEQ][CNT][LAT_L][LAT_H] + CNT x RESULT
+//---------------------------------------------------------------------------
+int WriteBuildAck(BYTE* buf, BYTE seq, int latencyMs, const BYTE* results, int count)
+{
+    BYTE payload[4 + WRITE_MAX];
+
+    if (latencyMs < 0) latencyMs = 0;
+    if (latencyMs > 0xFFFF) latencyMs = 0xFFFF;
+
+    payload[0] = seq;
+    payload[1] = (BYTE)count;
+    payload[2] = (BYTE)(latencyMs & 0xFF);
+    payload[3] = (BYTE)((latencyMs >> 8) & 0xFF);
+    for (int i = 0; i < count; i++)
+        payload[4 + i] = results[i];
+
+    return FrameBuildExt(buf, FRAME_WRITE_ACK, payload, 4 + count);
+}
+
+//---------------------------------------------------------------------------
+// 바이트 차분 필터 (stride 간격)
+//---------------------------------------------------------------------------
+void DeltaEncode(BYTE* buf, int len, int stride)
+{
+    for (int i = len - 1; i >= stride; i--)
+        buf[i] = (BYTE)(buf[i] - buf[i - stride]);
+}
+
+void DeltaDecode(BYTE* buf, int len, int stride)
+{
+    for (int i = stride; i < len; i++)
+        buf[i] = (BYTE)(buf[i] + buf[i - stride]);
+}
+
+//---------------------------------------------------------------------------
+// LZSS 압축 (해시 체인, 체인 깊이 LZ_MAX_CHAIN 제한)
+//---------------------------------------------------------------------------
+#define LZ_HASH(p)      ((((p)[0] << 8) ^ ((p)[1] << 4) ^ (p)[2]) & (LZ_HASH_SIZE - 1))
+
+int LzCompress(TLzEncoder* z, const BYTE* src, int len, BYTE* dst, int dstCap)
+{
+    int pos = 0;
+    int out = 0;
+    int flagPos = 0;
+    int tokens = 8;
+
+    for (int i = 0; i < LZ_HASH_SIZE; i++) z->Head[i] = -1;
+
+    while (pos < len)
+    {
+        // 새 그룹: FLAG + 최대 토큰 8개 (토큰당 최대 3바이트)
+        if (tokens == 8)
+        {
+            if (out + 1 + 8 * 3 > dstCap) return 0;
+            flagPos = out++;
+            dst[flagPos] = 0;
+            tokens = 0;
+        }
+
+        // 최장 일치 탐색
+        int bestLen = 0;
+        int bestOfs = 0;
+        if (pos + LZ_MIN_MATCH <= len)
+        {
+            int maxLen = len - pos;
+            if (maxLen > LZ_MAX_MATCH) maxLen = LZ_MAX_MATCH;
+
+            int cand = z->Head[LZ_HASH(&src[pos])];
+            for (int depth = 0; depth < LZ_MAX_CHAIN && cand >= 0; depth++)
+            {
+                if (pos - cand >= LZ_WINDOW) break;
+
+                int n = 0;
+                while (n < maxLen && src[cand + n] == src[pos + n]) n++;
+                if (n > bestLen)
+                {
+                    bestLen = n;
+                    bestOfs = pos - cand;
+                    if (n == maxLen) break;
+                }
+
+                int next = z->Prev[cand & (LZ_WINDOW - 1)];
+                if (next >= cand) break;
+                cand = next;
+            }
+        }
+
+        int step;
+        if (bestLen >= LZ_MIN_MATCH)
+        {
+            int code = bestLen - LZ_MIN_MATCH;
+            dst[flagPos] |= (BYTE)(1 << tokens);
+            dst[out++] = (BYTE)(bestOfs & 0xFF);
+            if (code < 15)
+            {
+                dst[out++] = (BYTE)(((bestOfs >> 4) & 0xF0) | code);
+            }
+            else
+            {
+                dst[out++] = (BYTE)(((bestOfs >> 4) & 0xF0) | 15);
+                dst[out++] = (BYTE)(bestLen - 18);
+            }
+            step = bestLen;
+        }
+        else
+        {
+            dst[out++] = src[pos];
+            step = 1;
+        }
+        tokens++;
+
+        // 해시 체인 등록
+        for (int k = 0; k < step; k++, pos++)
+        {
+            if (pos + LZ_MIN_MATCH <= len)
+            {
+                int h = LZ_HASH(&src[pos]);
+                z->Prev[pos & (LZ_WINDOW - 1)] = z->Head[h];
+                z->Head[h] = pos;
+            }
+        }
+    }
+    return out;
+}
+
+//---------------------------------------------------------------------------
+// LZSS 복원 (출력 버퍼만 사용, 동적 할당 없음)
+//---------------------------------------------------------------------------
+int LzDecompress(const BYTE* src, int len, BYTE* dst, int dstCap)
+{
+    int in = 0;
+    int out = 0;
+
+    while (in < len)
+    {
+        BYTE flags = src[in++];
+        for (int t = 0; t < 8 && in < len; t++)
+        {
+            if (flags & (1 << t))
+            {
+                if (in + 2 > len) return -1;
+                int ofs = src[in] | ((src[in + 1] & 0xF0) << 4);
+                int n = (src[in + 1] & 0x0F) + LZ_MIN_MATCH;
+                in += 2;
+                if (n == 18)
+                {
+                    if (in >= len) return -1;
+                    n += src[in++];
+                }
+                if (ofs == 0 || ofs > out || out + n > dstCap) return -1;
+                for (int k = 0; k < n; k++, out++)
+                    dst[out] = dst[out - ofs];
+            }
+            else
+            {
+                if (out >= dstCap) return -1;
+                dst[out++] = src[in++];
+            }
+        }
+    }
+    return out;
+}
+
+//---------------------------------------------------------------------------
+// 데이터 프레임 압축 -> [SOH][FRAME_LZ][LEN][RAW_LEN 2B][STRIDE][LZ...][CHK][ETX]
+//---------------------------------------------------------------------------
+int FrameBuildLz(TLzEncoder* z, const TFrameImage* f, BYTE* scratch, BYTE* out)
+{
+    int rawLen = f->Length - 3;         // STX/SOH, CHK, ETX 제외
+    int filterOfs = f->ItemOfs - 1;     // 데이터 프레임이면 LZ_FILTER_OFS
+    const int zHdr = EXT_HDR_LEN + 3;
+
+    if (f->Length <= zHdr + FRAME_TAIL_LEN || rawLen <= filterOfs)
+        return 0;
+
+    for (int i = 0; i < rawLen; i++)
+        scratch[i] = f->Buf[1 + i];
+    DeltaEncode(scratch + filterOfs, rawLen - filterOfs, f->Stride);
+
+    // 원본 프레임보다 작아야 의미가 있음
+    int cap = f->Length - zHdr - FRAME_TAIL_LEN - 1;
+    int zLen = LzCompress(z, scratch, rawLen, out + zHdr, cap);
+    if (zLen <= 0)
+        return 0;
+
+    int payloadLen = 3 + zLen;
+    out[0] = PROTO_SOH;
+    out[1] = FRAME_LZ;
+    out[2] = (BYTE)(payloadLen & 0xFF);
+    out[3] = (BYTE)((payloadLen >> 8) & 0xFF);
+    out[4] = (BYTE)(rawLen & 0xFF);
+    out[5] = (BYTE)((rawLen >> 8) & 0xFF);
+    out[6] = (BYTE)f->Stride;
+
+    int pos = zHdr + zLen;
+    out[pos] = ProtoChecksum(&out[1], pos - 1);
+    pos++;
+    out[pos++] = PROTO_ETX;
+    return pos;
+}
+
+//---------------------------------------------------------------------------
+// 수신 디코더
+//---------------------------------------------------------------------------
+#define RX_MASK         (RX_RING_SIZE - 1)
+#define RX_AT(d, i)     ((d)->Ring[((d)->Tail + (i)) & RX_MASK])
+
+void RxReset(TRxDecoder* d)
+{
+    d->Head = 0;
+    d->Tail = 0;
+    d->Frames = 0;
+    d->Resyncs = 0;
+    d->Dropped = 0;
+    d->CmdHead = 0;
+    d->CmdTail = 0;
+    d->CmdDropped = 0;
+}
+
+int RxUsed(const TRxDecoder* d)
+{
+    return (int)(d->Head - d->Tail);
+}
+
+//---------------------------------------------------------------------------
+// 링 끝까지의 연속 빈 공간 반환
+//---------------------------------------------------------------------------
+int RxWriteSpan(TRxDecoder* d, BYTE** p)
+{
+    int freeBytes = RX_RING_SIZE - RxUsed(d);
+    int pos = (int)(d->Head & RX_MASK);
+    int span = RX_RING_SIZE - pos;
+
+    *p = &d->Ring[pos];
+    return (span < freeBytes) ? span : freeBytes;
+}
+
+void RxCommit(TRxDecoder* d, int n)
+{
+    d->Head += (DWORD)n;
+}
+
+int RxPush(TRxDecoder* d, const BYTE* data, int len)
+{
+    int done = 0;
+    while (done < len)
+    {
+        BYTE* p;
+        int span = RxWriteSpan(d, &p);
+        if (span <= 0) break;
+
+        int n = len - done;
+        if (n > span) n = span;
+        for (int i = 0; i < n; i++) p[i] = data[done + i];
+
+        RxCommit(d, n);
+        done += n;
+    }
+    return done;
+}
+
+//---------------------------------------------------------------------------
+// 명령 프레임 디코드: [SOH][TYPE][LEN_L][LEN_H][PAYLOAD...][CHK][ETX]
+// 반환: 1 = 명령 하나 소비, 0 = 부분 프레임 (보류), -1 = 가짜 SOH
+//---------------------------------------------------------------------------
+static int RxTakeCommand(TRxDecoder* d)
+{
+    if (RxUsed(d) < EXT_HDR_LEN)
+        return 0;
+
+    BYTE type = RX_AT(d, 1);
+    int len = RX_AT(d, 2) | (RX_AT(d, 3) << 8);
+    if ((type != FRAME_WRITE && type != FRAME_WRITE_BATCH && type != FRAME_RESYNC) || len > RX_CMD_MAX)
+        return -1;
+
+    int total = EXT_SIZE(len);
+    if (RxUsed(d) < total)
+        return 0;
+
+    BYTE chk = 0;
+    for (int i = 1; i < total - 2; i++)
+        chk ^= RX_AT(d, i);
+    if (RX_AT(d, total - 2) != chk || RX_AT(d, total - 1) != PROTO_ETX)
+        return -1;
+
+    if (d->CmdHead - d->CmdTail < RX_CMD_QUEUE)
+    {
+        TRxCommand* c = &d->Cmds[d->CmdHead & (RX_CMD_QUEUE - 1)];
+        c->Type = type;
+        c->Len = len;
+        for (int i = 0; i < len; i++)
+            c->Data[i] = RX_AT(d, EXT_HDR_LEN + i);
+        d->CmdHead++;
+    }
+    else
+    {
+        d->CmdDropped++;
+    }
+
+    d->Tail += (DWORD)total;
+    d->Frames++;
+    return 1;
+}
+
+//---------------------------------------------------------------------------
+// 응답 프레임 디코드: [STX][CMD][STATUS][CHK][ETX]
+//---------------------------------------------------------------------------
+bool RxNext(TRxDecoder* d, TRxEvent* ev)
+{
+    while (RxUsed(d) > 0)
+    {
+        // 명령 프레임은 대기열로
+        if (RX_AT(d, 0) == PROTO_SOH)
+        {
+            int r = RxTakeCommand(d);
+            if (r == 0)
+                return false;
+            if (r < 0)
+            {
+                d->Tail++;
+                d->Resyncs++;
+            }
+            continue;
+        }
+
+        // STX 탐색
+        if (RX_AT(d, 0) != PROTO_STX)
+        {
+            d->Tail++;
+            d->Dropped++;
+            continue;
+        }
+
+        // 부분 프레임 - 다음 수신까지 보류
+        if (RxUsed(d) < RESP_FRAME_LEN)
+            return false;
+
+        BYTE cmd = RX_AT(d, 1);
+        BYTE status = RX_AT(d, 2);
+        bool valid = (RX_AT(d, 4) == PROTO_ETX) &&
+                     (RX_AT(d, 3) == (BYTE)(cmd ^ status)) &&
+                     (cmd == RESP_CMD_ACK || cmd == RESP_CMD_NAK);
+
+        if (!valid)
+        {
+            // 가짜 STX - 한 바이트만 버리고 재동기
+            d->Tail++;
+            d->Resyncs++;
+            continue;
+        }
+
+        d->Tail += RESP_FRAME_LEN;
+        d->Frames++;
+        ev->Cmd = cmd;
+        ev->Status = status;
+        return true;
+    }
+    return false;
+}
+
+//---------------------------------------------------------------------------
+bool RxNextCommand(TRxDecoder* d, TRxCommand* cmd)
+{
+    if (d->CmdHead == d->CmdTail)
+        return false;
+
+    *cmd = d->Cmds[d->CmdTail & (RX_CMD_QUEUE - 1)];
+    d->CmdTail++;
+    return true;
+}
@@ -0,0 +1,276 @@
+//---------------------------------------------------------------------------
+#ifndef EspProtoH
+#define EspProtoH
+//---------------------------------------------------------------------------
+// ESP32 시리얼 프로토콜 (VCL 비의존 - 리눅스에서도 단독 컴파일 가능)
+//---------------------------------------------------------------------------
+#include "PortTypes.h"
+
+// 프로토콜 상수
+#define PROTO_STX       0x02
+#define PROTO_ETX       0x03
+
+// 응답 코드 ([STX][CMD][STATUS][CHK][ETX], CHK = CMD ^ STATUS)
+#define RESP_FRAME_LEN  5
+#define RESP_CMD_ACK    0x01
+#define RESP_CMD_NAK    0x02
+#define RESP_STATUS_OK  0x00
+#define RESP_STATUS_CHK 0x01
+#define RESP_STATUS_LEN 0x02
+#define RESP_STATUS_TMO 0x03
+#define RESP_STATUS_SCHEMA 0x04         // 모르는 스키마 해시 (FRAME_VALUES 수신 시) -> 스키마 재전송
+#define RESP_STATUS_RESYNC 0x05         // 생존 확인 다이제스트 불일치 -> 전체 데이터 재전송
+
+// 확장 프레임 (데이터 프레임 이외의 제어/부가 프레임)
+// [SOH][TYPE][LEN_L][LEN_H][PAYLOAD...][CHK][ETX], CHK = TYPE ~ PAYLOAD 끝까지 XOR
+#define PROTO_SOH       0x01
+#define EXT_HDR_LEN     4
+#define EXT_SIZE(n)     (EXT_HDR_LEN + (n) + FRAME_TAIL_LEN)
+
+// 확장 프레임 타입
+#define FRAME_BAUD      0x10    // 보오레이트 변경 요청 (payload: baud 4B LE)
+#define FRAME_PROBE     0x11    // 보오레이트 검증 프로브 (payload: 시퀀스 + 패턴)
+#define FRAME_SCHEMA    0x12    // 스키마 사전 (payload: HASH 4B + CNT 2B + CNT x 항목)
+#define FRAME_KEEPALIVE 0x13    // 생존 확인 (payload: SEQ 2B + DIGEST 4B)
+#define FRAME_LZ        0x20    // 압축 데이터 프레임 (payload: RAW_LEN 2B + STRIDE 1B + LZ 스트림)
+#define FRAME_VALUES    0x21    // 위치 기반 데이터 프레임 (payload: HASH 4B + CNT 2B + CNT x [Q][VAL 4B])
+#define FRAME_BATCH     0x22    // 다중 샘플 프레임 (payload: BASE_MS 8B + CNT 2B + CNT x 아이템 블록)
+#define FRAME_PRIORITY  0x23    // 우선 전송 프레임 (payload: SEQ + CNT + CNT x [ID 2B][Q][VAL 4B])
+
+// ESP32 -> 에이전트 명령 프레임 (같은 확장 프레임 형식)
+#define FRAME_WRITE       0x30  // 아이템 하나 쓰기 (payload: SEQ + [ID 2B][VAL 4B])
+#define FRAME_WRITE_BATCH 0x31  // 여러 아이템 쓰기 (payload: SEQ + CNT + CNT x [ID 2B][VAL 4B])
+#define FRAME_WRITE_ACK   0x32  // 쓰기 결과 (에이전트 -> ESP32, payload: SEQ + CNT + LAT 2B + CNT x RESULT)
+#define FRAME_RESYNC      0x33  // 전체 데이터 요청 (payload 없음)
+
+// 쓰기 결과 코드 (아이템별)
+// VAL 은 데이터 프레임과 같은 long (REAL 은 x1000 고정소수점)
+// LAT 는 명령 수신부터 OPC 쓰기 완료까지 에이전트 쪽 경과 ms
+#define WRITE_MAX           32
+#define WRITE_OK            0x00
+#define WRITE_ERR_ID        0x01    // 모르는 ItemID
+#define WRITE_ERR_COMM      0x02    // 서버 연결 끊김 / 아이템 미등록
+#define WRITE_ERR_REJECT    0x03    // 서버가 거부 (쓰기 금지, 범위 초과 등)
+#define WRITE_ERR_BUSY      0x04    // 쓰기 대기열 가득 참
+#define WRITE_ERR_TMO       0x05    // 제한 시간 안에 완료되지 않음
+
+// 보오레이트 협상 규약
+// 1) 현재 속도에서 FRAME_BAUD 전송 -> ESP32 ACK 후 양쪽이 새 속도로 전환
+// 2) 새 속도에서 FRAME_PROBE를 BAUD_PROBE_COUNT회 보내 모두 ACK여야 확정
+// 3) ESP32는 전환 후 BAUD_REVERT_MS 동안 유효 프레임이 없으면 기본 속도로 복귀
+#define BAUD_PROBE_COUNT    8
+#define BAUD_PROBE_LEN      64
+#define BAUD_REVERT_MS      2000
+
+// 데이터 프레임 레이아웃
+// [STX][LEN_L][LEN_H][CNT] + CNT x [ID_L][ID_H][Q][VAL0][VAL1][VAL2][VAL3] + [CHK][ETX]
+#define FRAME_HDR_LEN   4
+#define FRAME_ITEM_LEN  7
+#define FRAME_TAIL_LEN  2
+#define FRAME_SIZE(n)   (FRAME_HDR_LEN + (n) * FRAME_ITEM_LEN + FRAME_TAIL_LEN)
+// CNT 가 1바이트라 데이터 프레임 하나에 255 아이템까지 (FrameLayout 이 잘라 배치).
+// 더 많은 아이템을 보내는 포트는 Schema=1 (FRAME_VALUES, CNT 2바이트)로.
+#define FRAME_ITEMS_MAX 255
+
+// 스키마 사전 / 위치 기반 데이터 프레임
+// 링크가 올라올 때와 스키마 해시가 바뀔 때 FRAME_SCHEMA 로 슬롯별 ID/타입/배율/짧은
+// 이름을 한 번 보내고, 이후 데이터는 FRAME_VALUES 로 해시 + 슬롯 순서의 Q/VAL 만 보낸다.
+// ESP32는 해시가 자기 사전과 다르면 NAK(RESP_STATUS_SCHEMA)로 사전을 다시 요청한다.
+// 스키마 항목: [ID_L][ID_H][TYPE][SCALE][NAME_LEN][NAME...]
+//   SCALE = 10의 지수 (부호 있음), 실제 값 = VAL x 10^SCALE
+//   HASH  = 항목 영역 전체의 FNV-1a
+#define SCHEMA_HDR_LEN      6
+#define SCHEMA_NAME_MAX     16
+#define SCHEMA_ENTRY_MAX    (5 + SCHEMA_NAME_MAX)
+#define SCHEMA_SIZE(n)      EXT_SIZE(SCHEMA_HDR_LEN + (n) * SCHEMA_ENTRY_MAX)
+#define VALUES_ITEM_LEN     5
+#define VALUES_SIZE(n)      EXT_SIZE(SCHEMA_HDR_LEN + (n) * VALUES_ITEM_LEN)
+
+#define SCHEMA_TYPE_INT     1       // 정수
+#define SCHEMA_TYPE_REAL    2       // 실수 (고정소수점, SCALE 로 복원)
+#define SCHEMA_TYPE_BOOL    3       // 0 / 1
+#define SCHEMA_TYPE_TIME    4       // Unix 시간 (초)
+
+// 다중 샘플 프레임 (여러 주기의 샘플을 원본 시각과 함께 한 프레임으로)
+// BASE_MS: Unix 시간 (ms, UTC)
+// 아이템 블록: [ID_L][ID_H][N] + N x [DT][Q][VAL 4B]
+//   DT = 첫 샘플은 BASE_MS 기준, 이후는 같은 아이템의 직전 샘플 기준 경과 ms
+//        7비트씩 LSB 부터, 상위 비트 1 = 다음 바이트 계속 (최대 5바이트)
+#define BATCH_HDR_LEN       10
+#define BATCH_MAX           8       // 아이템당 최대 샘플 수
+#define BATCH_ITEM_MAX      (3 + BATCH_MAX * (5 + 5))
+#define BATCH_SIZE(n)       EXT_SIZE(BATCH_HDR_LEN + (n) * BATCH_ITEM_MAX)
+
+// 생존 확인 (값이 그대로인 동안 전체 프레임 대신 Keepalive 주기로)
+// SEQ    = 포트별 증가 번호 (ESP32 가 빠진 생존 확인을 셀 수 있도록)
+// DIGEST = 마지막 데이터 프레임의 슬롯 순서 [Q][VAL 4B] 전체의 FNV-1a
+// ESP32 는 자기 값으로 계산한 다이제스트가 다르면 NAK(RESP_STATUS_RESYNC),
+// 언제든 FRAME_RESYNC 를 보내 다음 주기에 전체 데이터를 받을 수 있다.
+#define KEEPALIVE_LEN       6
+
+// 우선 전송 프레임 (CSV Priority=1 아이템의 변경만, 주기/응답 대기와 무관하게 바로)
+// 데이터 프레임 응답을 기다리는 중에도 보내므로 ESP32 는 응답하지 않는다.
+// 같은 값이 다음 데이터 프레임에도 실리므로 빠진 우선 프레임은 그 주기에 보완된다.
+// SEQ = 포트별 증가 번호 (ESP32 가 빠진 프레임을 셀 수 있도록)
+#define PRIO_HDR_LEN        2
+#define PRIO_ITEM_LEN       7
+#define PRIO_MAX            32      // 프레임당 아이템 수 (넘으면 여러 프레임)
+#define PRIO_SIZE(n)        EXT_SIZE(PRIO_HDR_LEN + (n) * PRIO_ITEM_LEN)
+
+// 미리 배치된 프레임 이미지
+// ID는 LoadItemConfig 이후 바뀌지 않으므로 한 번만 기록하고,
+// 이후에는 바뀐 Q/VAL 바이트만 덮어쓰면서 XOR 체크섬을 증분 갱신한다.
+// 레코드 배치는 프레임 종류마다 다르다 (데이터 프레임: ID+Q+VAL, FRAME_VALUES: Q+VAL).
+struct TFrameImage
+{
+    BYTE*   Buf;        // FRAME_SIZE(Count) / VALUES_SIZE(Count) 이상 (호출측 소유)
+    int     Count;      // 아이템 수
+    int     Length;     // 전체 프레임 길이 (STX/SOH ~ ETX)
+    int     ItemOfs;    // 첫 아이템 레코드 위치
+    int     Stride;     // 아이템 레코드 길이
+    int     QOfs;       // 레코드 안의 Q 위치 (VAL 은 바로 뒤 4바이트)
+};
+
+BYTE ProtoChecksum(const BYTE* data, int len);
+
+// 전체 재구성 (헤더/ID/값 기록 후 체크섬 전체 계산)
+void FrameLayout(TFrameImage* f, BYTE* buf, int count);
+void FrameLayoutValues(TFrameImage* f, BYTE* buf, int count, DWORD schemaHash);
+void FrameSetItem(TFrameImage* f, int slot, WORD id, BYTE quality, long value);
+void FrameSeal(TFrameImage* f);
+
+// 증분 패치 (바뀐 바이트 수 반환, 0이면 프레임 변화 없음)
+int  FramePatch(TFrameImage* f, int slot, BYTE quality, long value);
+
+// 확장 프레임 생성 (전체 길이 반환, buf는 EXT_SIZE(len) 이상)
+int  FrameBuildExt(BYTE* buf, BYTE type, const BYTE* payload, int len);
+
+// 프레임 이미지의 값 다이제스트 / 생존 확인 프레임 (buf는 EXT_SIZE(KEEPALIVE_LEN) 이상)
+DWORD FrameDigest(const TFrameImage* f);
+int   KeepaliveBuild(BYTE* buf, WORD seq, DWORD digest);
+
+// 스키마 payload 작성: 항목을 SCHEMA_HDR_LEN 뒤부터 차례로 넣고 (항목 길이 반환)
+// 마지막에 SchemaSeal 로 해시/개수를 기록 (payload 전체 길이 반환)
+int   SchemaPutEntry(BYTE* p, WORD id, BYTE type, signed char scale, const char* name, int nameLen);
+DWORD SchemaHash(const BYTE* entries, int len);
+int   SchemaSeal(BYTE* payload, int count, int entriesLen, DWORD* hash);
+
+// 다중 샘플 payload 작성: 아이템 블록을 BATCH_HDR_LEN 뒤부터 차례로 넣고
+// 마지막에 BatchSeal 로 기준 시각/아이템 수를 기록 (각 함수는 기록한 길이 반환)
+int   BatchPutItem(BYTE* p, WORD id, int samples);
+int   BatchPutSample(BYTE* p, DWORD dt, BYTE quality, long value);
+void  BatchSeal(BYTE* payload, LONGLONG baseMs, int count);
+
+// 우선 전송 payload 작성: 아이템을 PRIO_HDR_LEN 뒤부터 차례로 넣고 (PRIO_ITEM_LEN 반환)
+// 마지막에 PrioritySeal 로 SEQ/아이템 수를 기록
+int   PriorityPutItem(BYTE* p, WORD id, BYTE quality, long value);
+void  PrioritySeal(BYTE* payload, BYTE seq, int count);
+
+// 쓰기 명령 해석 (아이템 수 반환, 형식 오류면 -1)
+struct TWriteItem
+{
+    WORD    ID;
+    long    Value;
+};
+
+struct TRxCommand;
+int   WriteParse(const TRxCommand* c, BYTE* seq, TWriteItem* items);
+// 쓰기 결과 프레임 생성 (전체 길이 반환, buf는 EXT_SIZE(4 + WRITE_MAX) 이상)
+int   WriteBuildAck(BYTE* buf, BYTE seq, int latencyMs, const BYTE* results, int count);
+
+//---------------------------------------------------------------------------
+// 키프레임 압축 (LZSS 계열, ESP32에서 동적 할당 없이 복원 가능)
+//
+// 원본: 데이터 프레임 본문 [LEN_L][LEN_H][CNT][아이템...] (STX/CHK/ETX 제외)
+// 필터: 아이템 영역(본문 오프셋 3~)을 STRIDE(=7) 간격 바이트 차분
+//       -> 연속 ID는 01 00, 같은 Quality/값 상위 바이트는 00 으로 정리됨
+// STRIDE 가 VALUES_ITEM_LEN(=5) 이면 원본은 FRAME_VALUES 본문
+//       [TYPE][LEN_L][LEN_H][HASH 4B][CNT 2B][아이템...], 필터는 본문 오프셋 9~
+// 스트림: [FLAG] + 토큰 8개 반복, FLAG 비트(LSB부터) 0=리터럴 1바이트, 1=매치 2바이트
+//       매치: [OFS_L][OFS_H(4) | LEN-3(4)], LEN-3 == 15 이면 추가 1바이트 (LEN = 18 + n)
+//       OFS는 이미 복원된 출력 기준 거리 (1 ~ LZ_WINDOW-1) -> 별도 윈도우 버퍼 불필요
+//---------------------------------------------------------------------------
+#define LZ_WINDOW       4096
+#define LZ_MIN_MATCH    3
+#define LZ_MAX_MATCH    (18 + 255)
+#define LZ_HASH_SIZE    4096
+#define LZ_MAX_CHAIN    16
+#define LZ_FILTER_OFS   3
+
+struct TLzEncoder
+{
+    int     Head[LZ_HASH_SIZE];
+    int     Prev[LZ_WINDOW];
+};
+
+// 압축 (출력 길이 반환, dstCap 안에 못 들어가면 0)
+int  LzCompress(TLzEncoder* z, const BYTE* src, int len, BYTE* dst, int dstCap);
+// 복원 (출력 길이 반환, 형식 오류면 -1) - ESP32 펌웨어 참조 구현
+int  LzDecompress(const BYTE* src, int len, BYTE* dst, int dstCap);
+
+void DeltaEncode(BYTE* buf, int len, int stride);
+void DeltaDecode(BYTE* buf, int len, int stride);
+
+// 데이터 프레임 -> FRAME_LZ 확장 프레임 (원본보다 작을 때만 길이 반환, 아니면 0)
+// scratch 는 f->Length 이상, out 은 f->Length 이상
+int  FrameBuildLz(TLzEncoder* z, const TFrameImage* f, BYTE* scratch, BYTE* out);
+
+//---------------------------------------------------------------------------
+// 수신 스트림 디코더
+// 수신 바이트를 링버퍼에 한 번에 모아두고 완성된 응답 프레임만 꺼낸다.
+// 부분 프레임은 다음 수신까지 보류하고, ETX/체크섬이 틀리면 해당 STX 한 바이트만
+// 버린 뒤 바로 다음 STX부터 다시 동기를 잡는다 (타임아웃을 기다리지 않음).
+//
+// 중간에 섞여 오는 ESP32 명령 프레임(SOH)은 응답과 따로 명령 대기열에 넣는다.
+// 응답을 버리는 정리 루프(while RxNext)가 돌아도 명령은 잃지 않는다.
+//---------------------------------------------------------------------------
+#define RX_RING_SIZE    1024        // 2의 거듭제곱
+#define RX_CMD_QUEUE    4           // 2의 거듭제곱
+#define RX_CMD_MAX      (2 + WRITE_MAX * 6)
+
+struct TRxCommand
+{
+    BYTE    Type;       // FRAME_WRITE / FRAME_WRITE_BATCH / FRAME_RESYNC
+    int     Len;
+    BYTE    Data[RX_CMD_MAX];
+};
+
+struct TRxEvent
+{
+    BYTE    Cmd;        // RESP_CMD_ACK / RESP_CMD_NAK
+    BYTE    Status;     // RESP_STATUS_xxx
+};
+
+struct TRxDecoder
+{
+    BYTE    Ring[RX_RING_SIZE];
+    DWORD   Head;       // 누적 쓰기 위치
+    DWORD   Tail;       // 누적 읽기 위치
+    DWORD   Frames;     // 디코드된 프레임 수
+    DWORD   Resyncs;    // ETX/체크섬 오류로 재동기한 횟수
+    DWORD   Dropped;    // 프레임 밖에서 버린 바이트 수
+
+    TRxCommand Cmds[RX_CMD_QUEUE];
+    DWORD   CmdHead;
+    DWORD   CmdTail;
+    DWORD   CmdDropped; // 대기열이 가득 차서 버린 명령 수
+};
+
+void RxReset(TRxDecoder* d);
+int  RxUsed(const TRxDecoder* d);
+
+// 연속된 빈 공간 (ReadBuf로 바로 채운 뒤 RxCommit)
+int  RxWriteSpan(TRxDecoder* d, BYTE** p);
+void RxCommit(TRxDecoder* d, int n);
+
+// 바이트열 복사 투입 (받아들인 바이트 수 반환)
+int  RxPush(TRxDecoder* d, const BYTE* data, int len);
+
+// 완성된 프레임 하나를 꺼냄 (없으면 false)
+bool RxNext(TRxDecoder* d, TRxEvent* ev);
+
+// RxNext 가 모아 둔 명령 하나를 꺼냄 (없으면 false)
+bool RxNextCommand(TRxDecoder* d, TRxCommand* cmd);
+
+//---------------------------------------------------------------------------
+#endif
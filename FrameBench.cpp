@@ -0,0 +1,147 @@
+//---------------------------------------------------------------------------
+// 프레임 이미지 측정 (콘솔, 오프라인)
+// 빌드: bcc32 FrameBench.cpp EspProto.cpp   (리눅스: g++ -O2 FrameBench.cpp EspProto.cpp)
+//
+// 사용: FrameBench [옵션]
+//   -n N    아이템 수 하나만 (기본 50, 255, 500 을 차례로)
+//   -r N    반복 수 (기본 1000)
+//   -c PCT  주기당 바뀌는 아이템 비율 % (기본 5)
+//
+// 주기마다 PCT% 아이템 값을 바꾸고 프레임을 매번 전체 재구성(RB)할 때와 바뀐 슬롯만
+// 패치(PT)할 때의 주기당 시간을 잰다. 패치 결과는 전체 재계산 체크섬과 비교한다.
+//   DATA    데이터 프레임 (ID+Q+VAL) - CNT 1바이트라 FRAME_ITEMS_MAX(255) 까지만
+//   VALUES  FRAME_VALUES (Q+VAL, Schema=1) - CNT 2바이트
+// 에이전트 한 포트는 MAX_OPC_ITEMS(500) 아이템까지 싣는다.
+//
+// 출력: 종류 / 아이템 수 / 프레임 길이 / RB, PT (us, 주기당) / 배율
+// 체크섬이 어긋나면 종료 코드 1.
+//---------------------------------------------------------------------------
+#include "EspProto.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+//---------------------------------------------------------------------------
+// 시계 (us)
+//---------------------------------------------------------------------------
+#ifdef _WIN32
+static double NowUs()
+{
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER t;
+    if (freq.QuadPart == 0)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&t);
+    return (double)t.QuadPart * 1000000.0 / (double)freq.QuadPart;
+}
+#else
+static double NowUs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+#endif
+
+//---------------------------------------------------------------------------
+// 한 종류/크기 측정 (체크섬이 같으면 true)
+//---------------------------------------------------------------------------
+static bool RunOne(bool values, int itemCount, int rounds, int pct)
+{
+    int changes = itemCount * pct / 100;
+    if (changes < 1) changes = 1;
+
+    BYTE* buf = new BYTE[VALUES_SIZE(itemCount) + FRAME_SIZE(itemCount)];
+    long* val = new long[itemCount];
+    for (int i = 0; i < itemCount; i++) val[i] = i * 37;
+
+    TFrameImage f;
+    volatile BYTE sink = 0;
+
+    // 1. 매번 전체 재구성
+    double t0 = NowUs();
+    for (int r = 0; r < rounds; r++)
+    {
+        for (int c = 0; c < changes; c++) val[(r * 7 + c * 20) % itemCount]++;
+
+        if (values)
+            FrameLayoutValues(&f, buf, itemCount, 0x12345678);
+        else
+            FrameLayout(&f, buf, itemCount);
+        for (int i = 0; i < itemCount; i++)
+            FrameSetItem(&f, i, (WORD)(i + 1), 0, val[i]);
+        FrameSeal(&f);
+        sink ^= buf[f.Length - 2];
+    }
+    double rebuildUs = (NowUs() - t0) / rounds;
+
+    // 2. 바뀐 슬롯만 패치
+    t0 = NowUs();
+    for (int r = 0; r < rounds; r++)
+    {
+        for (int c = 0; c < changes; c++)
+        {
+            int slot = (r * 7 + c * 20) % itemCount;
+            val[slot]++;
+            FramePatch(&f, slot, 0, val[slot]);
+        }
+        sink ^= buf[f.Length - 2];
+    }
+    double patchUs = (NowUs() - t0) / rounds;
+
+    // 패치 결과가 전체 재구성과 같은 체크섬인지 확인
+    BYTE chk = f.Buf[f.Length - 2];
+    FrameSeal(&f);
+    bool same = (chk == f.Buf[f.Length - 2]);
+
+    printf("%-6s N:%-5d C:%-4d LEN:%-6d RB:%8.2fus PT:%7.3fus x%.0f%s\n",
+           values ? "VALUES" : "DATA", f.Count, changes, f.Length, rebuildUs, patchUs,
+           (patchUs > 0) ? rebuildUs / patchUs : 0.0, same ? "" : " CHK MISMATCH");
+
+    delete[] val;
+    delete[] buf;
+    return same;
+}
+
+//---------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    int only = 0;
+    int rounds = 1000;
+    int pct = 5;
+
+    for (int a = 1; a < argc; a++)
+    {
+        if (strcmp(argv[a], "-n") == 0 && a + 1 < argc)      { only = atoi(argv[++a]); continue; }
+        if (strcmp(argv[a], "-r") == 0 && a + 1 < argc)      { rounds = atoi(argv[++a]); continue; }
+        if (strcmp(argv[a], "-c") == 0 && a + 1 < argc)      { pct = atoi(argv[++a]); continue; }
+        fprintf(stderr, "usage: FrameBench [-n items] [-r rounds] [-c pct]\n");
+        return 2;
+    }
+    if (rounds < 1) rounds = 1;
+    if (pct < 1) pct = 1;
+    if (pct > 100) pct = 100;
+
+    static const int sizes[] = { 50, FRAME_ITEMS_MAX, 500 };
+    int sizeCount = sizeof(sizes) / sizeof(sizes[0]);
+    bool ok = true;
+
+    for (int s = 0; s < sizeCount; s++)
+    {
+        int n = (only > 0) ? only : sizes[s];
+
+        // 데이터 프레임은 CNT 1바이트 - 그보다 많으면 FRAME_VALUES 만
+        if (n <= FRAME_ITEMS_MAX)
+            ok = RunOne(false, n, rounds, pct) && ok;
+        else
+            printf("DATA   N:%-5d (CNT max %d - Schema=1)\n", n, FRAME_ITEMS_MAX);
+        ok = RunOne(true, n, rounds, pct) && ok;
+
+        if (only > 0)
+            break;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,266 @@
+//---------------------------------------------------------------------------
+#include "MetricsServer.h"
+#include <stdio.h>
+#include <stddef.h>
+//---------------------------------------------------------------------------
+#pragma package(smart_init)
+
+// 지표 정의 (이름 / 형식 / 설명 / 구조체 안 위치)
+struct TMetricDef
+{
+    const char* Name;
+    const char* Type;
+    const char* Help;
+    int         Ofs;
+};
+
+static const TMetricDef AgentDefs[] =
+{
+    { "ga1_cycles_total",           "counter", "Main send cycles",                      offsetof(TAgentMetrics, Cycles) },
+    { "ga1_cycle_ms",               "gauge",   "Duration of the last send cycle (ms)",  offsetof(TAgentMetrics, CycleMs) },
+    { "ga1_changes_total",          "counter", "Item value/quality changes",            offsetof(TAgentMetrics, Changes) },
+    { "ga1_cycle_changes",          "gauge",   "Item value/quality changes in the last cycle", offsetof(TAgentMetrics, LastChanges) },
+    { "ga1_items",                  "gauge",   "Items in the active table",             offsetof(TAgentMetrics, ItemCount) },
+    { "ga1_scan_interval_ms",       "gauge",   "Effective scan interval (ms)",          offsetof(TAgentMetrics, ScanInterval) },
+    { "ga1_write_commands_total",   "counter", "Write commands received from ESP32",    offsetof(TAgentMetrics, WriteCmds) },
+    { "ga1_write_queue_depth",      "gauge",   "Write commands in progress",            offsetof(TAgentMetrics, WriteQueue) },
+    { "ga1_priority_edges_total",   "counter", "Priority item changes detected",        offsetof(TAgentMetrics, PrioEdges) },
+    { "ga1_priority_latency_us",    "gauge",   "Change-to-wire latency of the last priority frame (us)", offsetof(TAgentMetrics, PrioLatencyUs) },
+    { "ga1_priority_latency_ms_total", "counter", "Change-to-wire latency summed over priority frames (ms, wraps at 2^32)", offsetof(TAgentMetrics, PrioLatencyMsSum) },
+};
+
+static const TMetricDef ScanDefs[] =
+{
+    { "ga1_opc_connected",          "gauge",   "OPC server connected (1) or lost (0)",  offsetof(TScanMetrics, Connected) },
+    { "ga1_opc_scans_total",        "counter", "OPC read cycles",                       offsetof(TScanMetrics, Scans) },
+    { "ga1_opc_scan_ms_total",      "counter", "Time spent in OPC read cycles (ms)",    offsetof(TScanMetrics, ScanMs) },
+    { "ga1_opc_scan_ms",            "gauge",   "Duration of the last OPC read cycle (ms)", offsetof(TScanMetrics, LastScanMs) },
+    { "ga1_opc_items_read_total",   "counter", "Items read",                            offsetof(TScanMetrics, ItemsRead) },
+    { "ga1_opc_read_errors_total",  "counter", "Item reads that raised an exception",   offsetof(TScanMetrics, ReadErrors) },
+};
+
+static const TMetricDef LinkDefs[] =
+{
+    { "ga1_link_up",                "gauge",   "Serial link open (1) or down (0)",      offsetof(TLinkMetrics, Up) },
+    { "ga1_link_baud",              "gauge",   "Current link baud rate",                offsetof(TLinkMetrics, BaudRate) },
+    { "ga1_link_frames_total",      "counter", "Data frames completed",                 offsetof(TLinkMetrics, Frames) },
+    { "ga1_link_tx_bytes_total",    "counter", "Data frame bytes sent",                 offsetof(TLinkMetrics, TxBytes) },
+    { "ga1_link_acks_total",        "counter", "Frames acknowledged",                   offsetof(TLinkMetrics, Acks) },
+    { "ga1_link_naks_total",        "counter", "Frames rejected with NAK",              offsetof(TLinkMetrics, Naks) },
+    { "ga1_link_timeouts_total",    "counter", "Frames without response",               offsetof(TLinkMetrics, Timeouts) },
+    { "ga1_link_retries_total",     "counter", "Send failures counted toward reconnect", offsetof(TLinkMetrics, Retries) },
+    { "ga1_link_queue_depth",       "gauge",   "Samples (batch ports) or items waiting for ACK", offsetof(TLinkMetrics, QueueDepth) },
+    { "ga1_link_coalesced_total",   "counter", "Updates merged into a pending slot before transmit (latest wins)", offsetof(TLinkMetrics, Coalesced) },
+    { "ga1_link_priority_frames_total", "counter", "Priority frames sent (unacknowledged)", offsetof(TLinkMetrics, PrioFrames) },
+};
+
+#define DEF_COUNT(a)    (int)(sizeof(a) / sizeof(a[0]))
+
+static unsigned long ReadLong(const void* base, int ofs)
+{
+    return (unsigned long)(DWORD)*(const volatile LONG*)((const char*)base + ofs);
+}
+
+static int PutHead(char* p, const TMetricDef* d)
+{
+    return sprintf(p, "# HELP %s %s\n# TYPE %s %s\n", d->Name, d->Help, d->Name, d->Type);
+}
+
+//---------------------------------------------------------------------------
+__fastcall TMetricsServer::TMetricsServer(const TAgentMetrics* metrics, int port)
+    : TThread(true)
+{
+    FreeOnTerminate = false;
+
+    FMetrics = metrics;
+    FPort = port;
+    FListen = INVALID_SOCKET;
+    FPrevTick = GetTickCount();
+    for (int l = 0; l < MAX_ESP_LINKS; l++)
+        FPrevBytes[l] = metrics->Link[l].TxBytes;
+}
+
+//---------------------------------------------------------------------------
+__fastcall TMetricsServer::~TMetricsServer()
+{
+    if (FListen != INVALID_SOCKET)
+        closesocket(FListen);
+    WSACleanup();
+}
+
+//---------------------------------------------------------------------------
+// 수신 소켓 열기 (메인 스레드, Resume 전) - loopback 에만 묶는다
+//---------------------------------------------------------------------------
+bool __fastcall TMetricsServer::Listen()
+{
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(1, 1), &wsa) != 0)
+        return false;
+
+    FListen = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (FListen == INVALID_SOCKET)
+        return false;
+
+    sockaddr_in addr;
+    ZeroMemory(&addr, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    addr.sin_port = htons((u_short)FPort);
+
+    if (bind(FListen, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR ||
+        listen(FListen, 2) == SOCKET_ERROR)
+    {
+        closesocket(FListen);
+        FListen = INVALID_SOCKET;
+        return false;
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+void __fastcall TMetricsServer::Stop()
+{
+    Terminate();
+    WaitFor();
+}
+
+//---------------------------------------------------------------------------
+// 지표 본문 (Prometheus text format 0.0.4)
+//---------------------------------------------------------------------------
+int __fastcall TMetricsServer::Format(char* body)
+{
+    const TAgentMetrics* m = FMetrics;
+    int links = m->LinkCount;
+    int len = 0;
+
+    if (links > MAX_ESP_LINKS) links = MAX_ESP_LINKS;
+
+    for (int d = 0; d < DEF_COUNT(AgentDefs); d++)
+    {
+        len += PutHead(body + len, &AgentDefs[d]);
+        len += sprintf(body + len, "%s %lu\n", AgentDefs[d].Name, ReadLong(m, AgentDefs[d].Ofs));
+    }
+
+    // 작업자 칸은 재적재 중에 바뀔 수 있다 - 이름이 잠깐 어긋나도 값은 칸 기준
+    for (int d = 0; d < DEF_COUNT(ScanDefs); d++)
+    {
+        len += PutHead(body + len, &ScanDefs[d]);
+        for (int w = 0; w < MAX_OPC_SERVERS; w++)
+        {
+            const TScanMetrics* s = &m->Server[w];
+            if (!s->Active)
+                continue;
+
+            char name[METRICS_NAME_LEN];
+            lstrcpyn(name, s->Name, METRICS_NAME_LEN);
+            len += sprintf(body + len, "%s{server=\"%s\"} %lu\n", ScanDefs[d].Name, name,
+                           ReadLong(s, ScanDefs[d].Ofs));
+        }
+    }
+
+    for (int d = 0; d < DEF_COUNT(LinkDefs); d++)
+    {
+        len += PutHead(body + len, &LinkDefs[d]);
+        for (int l = 0; l < links; l++)
+        {
+            len += sprintf(body + len, "%s{port=\"COM%ld\"} %lu\n", LinkDefs[d].Name,
+                           m->Link[l].ComPort, ReadLong(&m->Link[l], LinkDefs[d].Ofs));
+        }
+    }
+
+    // 포트 이용률 = 스크레이프 사이 전송 비트 / (속도 x 경과 시간), 10비트/바이트 (8N1)
+    DWORD now = GetTickCount();
+    DWORD dt = now - FPrevTick;
+    FPrevTick = now;
+
+    len += sprintf(body + len, "# HELP ga1_link_utilization Share of line time spent sending data frames since the last scrape\n"
+                               "# TYPE ga1_link_utilization gauge\n");
+    for (int l = 0; l < MAX_ESP_LINKS; l++)
+    {
+        LONG bytes = m->Link[l].TxBytes;
+        DWORD sent = (DWORD)(bytes - FPrevBytes[l]);
+        FPrevBytes[l] = bytes;
+
+        if (l >= links)
+            continue;
+
+        LONG baud = m->Link[l].BaudRate;
+        double util = (baud > 0 && dt > 0) ? (double)sent * 10.0 * 1000.0 / ((double)baud * dt) : 0;
+        len += sprintf(body + len, "ga1_link_utilization{port=\"COM%ld\"} %.4f\n", m->Link[l].ComPort, util);
+    }
+
+    return len;
+}
+
+//---------------------------------------------------------------------------
+// 요청 하나 처리 (요청 줄은 보지 않고 항상 지표를 돌려준다)
+//---------------------------------------------------------------------------
+void __fastcall TMetricsServer::Serve(SOCKET s)
+{
+    int timeout = METRICS_IO_TIMEOUT_MS;
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout, sizeof(timeout));
+    setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, (char*)&timeout, sizeof(timeout));
+
+    // 요청 머리 끝(빈 줄)까지 읽기 - 본문 버퍼를 임시로 사용
+    int got = 0;
+    while (got < 1024)
+    {
+        int n = recv(s, FBuf + got, 1024 - got, 0);
+        if (n <= 0)
+            return;
+        got += n;
+        FBuf[got] = 0;
+        if (strstr(FBuf, "\r\n\r\n") != NULL || strstr(FBuf, "\n\n") != NULL)
+            break;
+    }
+
+    char head[128];
+    int bodyLen = Format(FBuf);
+    int headLen = sprintf(head, "HTTP/1.0 200 OK\r\n"
+                                "Content-Type: text/plain; version=0.0.4\r\n"
+                                "Content-Length: %d\r\n\r\n", bodyLen);
+
+    if (send(s, head, headLen, 0) != headLen)
+        return;
+
+    int sent = 0;
+    while (sent < bodyLen)
+    {
+        int n = send(s, FBuf + sent, bodyLen - sent, 0);
+        if (n <= 0)
+            break;
+        sent += n;
+    }
+}
+
+//---------------------------------------------------------------------------
+// 수락 루프 (0.5초마다 종료 확인)
+//---------------------------------------------------------------------------
+void __fastcall TMetricsServer::Execute()
+{
+    while (!Terminated)
+    {
+        fd_set rd;
+        FD_ZERO(&rd);
+        FD_SET(FListen, &rd);
+        timeval tv;
+        tv.tv_sec = 0;
+        tv.tv_usec = 500000;
+
+        int r = select(0, &rd, NULL, NULL, &tv);
+        if (r == SOCKET_ERROR)
+        {
+            Sleep(500);
+            continue;
+        }
+        if (r == 0)
+            continue;
+
+        SOCKET s = accept(FListen, NULL, NULL);
+        if (s == INVALID_SOCKET)
+            continue;
+
+        Serve(s);
+        closesocket(s);
+    }
+}
@@ -0,0 +1,46 @@
+//---------------------------------------------------------------------------
+#ifndef MetricsServerH
+#define MetricsServerH
+//---------------------------------------------------------------------------
+#include <Classes.hpp>
+#include <winsock.h>
+#include "SvcController.h"
+
+#define METRICS_BUF_SIZE        32768
+#define METRICS_IO_TIMEOUT_MS   1000
+
+//---------------------------------------------------------------------------
+// 실시간 지표 서버 (127.0.0.1:MetricsPort, HTTP GET 아무 경로)
+// 요청이 오면 TAgentMetrics 를 잠금 없이 읽어 Prometheus 텍스트 형식으로
+// 한 번 응답하고 연결을 닫는다. 한 번에 한 클라이언트만, 송수신 제한 시간이
+// 있으므로 느린 클라이언트도 이 스레드만 붙잡을 뿐 수집 주기에는 영향이 없다.
+//
+// 포트 이용률은 스크레이프 사이의 전송 바이트를 현재 속도로 나눈 값이다.
+//---------------------------------------------------------------------------
+class TMetricsServer : public TThread
+{
+private:
+    const TAgentMetrics* FMetrics;
+    int                 FPort;
+    SOCKET              FListen;
+    char                FBuf[METRICS_BUF_SIZE];
+
+    // 이용률 계산용 직전 스크레이프 (이 스레드 전용)
+    LONG                FPrevBytes[MAX_ESP_LINKS];
+    DWORD               FPrevTick;
+
+    int __fastcall Format(char* body);
+    void __fastcall Serve(SOCKET s);
+
+protected:
+    void __fastcall Execute();
+
+public:
+    __fastcall TMetricsServer(const TAgentMetrics* metrics, int port);
+    __fastcall ~TMetricsServer();
+
+    bool __fastcall Listen();
+    void __fastcall Stop();
+};
+//---------------------------------------------------------------------------
+#endif
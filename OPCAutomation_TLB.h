@@ -10,7 +10,7 @@
 // ************************************************************************ //
 
 // C++ TLBWRTR : $Revision:   1.151.1.0.1.27  $
-// File generated on 2026-01-17  5:25:57 from Type Library described below.
+// File generated on 2026-01-17 오후 5:25:57 from Type Library described below.
 
 // ************************************************************************  //
 // Type Lib: E:\GA1Agent\OpcDaAuto.dll (1)
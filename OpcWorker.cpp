@@ -0,0 +1,890 @@
+//---------------------------------------------------------------------------
+#include "OpcWorker.h"
+#include <utilcls.h>
+#include <objbase.h>
+#include <ocidl.h>
+//---------------------------------------------------------------------------
+#pragma package(smart_init)
+
+// 지표 칸을 못 잡은 작업자용 (갱신만 되고 노출되지 않음)
+static TScanMetrics g_NoMetrics;
+
+//---------------------------------------------------------------------------
+// ServerShutDown 이벤트 수신용 디스패치 싱크 (DIOPCServerEvent)
+// 이벤트는 작업자 스레드의 메시지 펌프(WaitWake)에서 호출된다.
+//---------------------------------------------------------------------------
+class TOpcShutdownSink : public IDispatch
+{
+private:
+    LONG            FRef;
+    TOpcWorker*     FWorker;
+
+public:
+    TOpcShutdownSink(TOpcWorker* worker) : FRef(1), FWorker(worker) {}
+
+    void Detach() { FWorker = NULL; }
+
+    STDMETHODIMP QueryInterface(REFIID riid, void** ppv)
+    {
+        if (riid == IID_IUnknown || riid == IID_IDispatch || riid == DIID_DIOPCServerEvent)
+        {
+            *ppv = (IDispatch*)this;
+            AddRef();
+            return S_OK;
+        }
+        *ppv = NULL;
+        return E_NOINTERFACE;
+    }
+    STDMETHODIMP_(ULONG) AddRef()
+    {
+        return InterlockedIncrement(&FRef);
+    }
+    STDMETHODIMP_(ULONG) Release()
+    {
+        LONG ref = InterlockedDecrement(&FRef);
+        if (ref == 0)
+            delete this;
+        return ref;
+    }
+    STDMETHODIMP GetTypeInfoCount(UINT* pctinfo)
+    {
+        *pctinfo = 0;
+        return S_OK;
+    }
+    STDMETHODIMP GetTypeInfo(UINT, LCID, ITypeInfo**)
+    {
+        return E_NOTIMPL;
+    }
+    STDMETHODIMP GetIDsOfNames(REFIID, LPOLESTR*, UINT, LCID, DISPID*)
+    {
+        return E_NOTIMPL;
+    }
+    STDMETHODIMP Invoke(DISPID dispid, REFIID, LCID, WORD, DISPPARAMS* params,
+                        VARIANT*, EXCEPINFO*, UINT*)
+    {
+        // DISPID 1 = ServerShutDown(BSTR Reason)
+        if (dispid == 1 && FWorker != NULL)
+        {
+            String reason;
+            if (params != NULL && params->cArgs > 0 && params->rgvarg[0].vt == VT_BSTR)
+                reason = params->rgvarg[0].bstrVal;
+            FWorker->NotifyShutdown(reason);
+        }
+        return S_OK;
+    }
+};
+
+//---------------------------------------------------------------------------
+__fastcall TOpcWorker::TOpcWorker(TGa1Agent* agent, String progId, DWORD interval, int gen)
+    : TThread(true)
+{
+    FreeOnTerminate = false;
+
+    FAgent = agent;
+    FProgID = progId;
+    FInterval = interval;
+    FCount = 0;
+    FGen = gen;
+    for (int i = 0; i < MAX_OPC_ITEMS; i++)
+        FLocal[i] = -1;
+
+    FPlanPending = 0;
+    FAppliedGen = gen;
+    FPlanGen = gen;
+    FPlanCount = 0;
+
+    FEventCP = NULL;
+    FSink = NULL;
+    FEventCookie = 0;
+    FShutdown = false;
+    FReadFailed = false;
+
+    FMetrics = agent->OpenScanMetrics(progId);
+    if (FMetrics == NULL)
+        FMetrics = &g_NoMetrics;
+
+    FWake = CreateEvent(NULL, TRUE, FALSE, NULL);
+    FReady = CreateEvent(NULL, TRUE, FALSE, NULL);
+    FPlanEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+    FRateEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+
+    InitializeCriticalSection(&FcsWrite);
+    FWriteCount = 0;
+    FWritePending = 0;
+    FWriteEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+}
+
+//---------------------------------------------------------------------------
+__fastcall TOpcWorker::~TOpcWorker()
+{
+    CloseHandle(FWake);
+    CloseHandle(FReady);
+    CloseHandle(FPlanEvent);
+    CloseHandle(FRateEvent);
+    CloseHandle(FWriteEvent);
+
+    for (int n = 0; n < FWriteCount; n++)
+        VariantClear(&FWrites[n].Value);
+    DeleteCriticalSection(&FcsWrite);
+
+    if (FMetrics != &g_NoMetrics)
+        FAgent->CloseScanMetrics(FMetrics);
+}
+
+//---------------------------------------------------------------------------
+void __fastcall TOpcWorker::AddItem(int index)
+{
+    if (FCount < MAX_OPC_ITEMS)
+    {
+        FItems[FCount] = NULL;
+        FLocal[index] = FCount;
+        FIndex[FCount++] = index;
+    }
+}
+
+//---------------------------------------------------------------------------
+// 재적재 계획 전달 (메인 스레드, 이전 계획이 적용된 뒤에만 호출)
+//---------------------------------------------------------------------------
+void __fastcall TOpcWorker::PostPlan(int gen, const int* index, const int* old, int count)
+{
+    for (int k = 0; k < count; k++)
+    {
+        FPlanIndex[k] = index[k];
+        FPlanOld[k] = old[k];
+    }
+    FPlanCount = count;
+    FPlanGen = gen;
+
+    InterlockedExchange(&FPlanPending, 1);
+    SetEvent(FPlanEvent);
+}
+
+//---------------------------------------------------------------------------
+// 읽기 주기 변경 (메인 스레드) - 줄어들면 대기 중인 작업자를 깨워 새 주기로
+// 다시 대기하게 한다. 늘어난 주기는 다음 대기부터.
+//---------------------------------------------------------------------------
+void __fastcall TOpcWorker::SetInterval(DWORD interval)
+{
+    bool shorter = (interval < FInterval);
+    FInterval = interval;
+    if (shorter)
+        SetEvent(FRateEvent);
+}
+
+//---------------------------------------------------------------------------
+// 종료 요청 후 스레드 종료까지 대기
+//---------------------------------------------------------------------------
+void __fastcall TOpcWorker::Stop()
+{
+    Terminate();
+    SetEvent(FWake);
+    WaitFor();
+}
+
+//---------------------------------------------------------------------------
+// ServerShutDown 수신 (싱크에서 호출, 작업자 스레드)
+//---------------------------------------------------------------------------
+void __fastcall TOpcWorker::NotifyShutdown(String reason)
+{
+    FShutdown = true;
+    FAgent->LogMessage("OPC SHUTDOWN " + FProgID + ": " + reason);
+}
+
+//---------------------------------------------------------------------------
+// 대기 (메시지 펌프 포함 - STA 이므로 서버 이벤트가 이 스레드로 전달된다)
+// 종료 요청, ServerShutDown 수신, 재적재 계획 도착, 주기 변경 시 즉시 반환
+//---------------------------------------------------------------------------
+void __fastcall TOpcWorker::WaitWake(DWORD ms)
+{
+    DWORD startTick = GetTickCount();
+    HANDLE handles[4] = { FWake, FPlanEvent, FWriteEvent, FRateEvent };
+
+    while (!Terminated && !FShutdown && !FPlanPending)
+    {
+        DWORD elapsed = GetTickCount() - startTick;
+        if (elapsed >= ms)
+            break;
+
+        DWORD r = MsgWaitForMultipleObjects(4, handles, FALSE, ms - elapsed, QS_ALLINPUT);
+        if (r == WAIT_OBJECT_0 + 2)
+        {
+            // 쓰기 명령은 주기를 기다리지 않고 바로 적용 후 계속 대기
+            ApplyWrites();
+            continue;
+        }
+        if (r != WAIT_OBJECT_0 + 4)
+            break;      // 종료 신호, 재적재 계획, 주기 변경 또는 시간 만료
+
+        MSG msg;
+        while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+        {
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+// 서버 상태 확인 - ServerShutDown / 전체 읽기 실패 / ServerState != Running
+//---------------------------------------------------------------------------
+bool __fastcall TOpcWorker::IsHealthy()
+{
+    if (FShutdown || FReadFailed)
+        return false;
+
+    try
+    {
+        return (OPCServer->get_ServerState() == OPCRunning);
+    }
+    catch (Exception &e)
+    {
+        return false;
+    }
+}
+
+//---------------------------------------------------------------------------
+// 서버가 돌려준 ClientHandle -> 담당 순번 (-1: 이 작업자의 현재 세대 아이템 아님)
+// 테이블 인덱스는 FIndex[k], OPC 아이템은 FItems[k]
+//---------------------------------------------------------------------------
+int __fastcall TOpcWorker::LocalIndex(long clientHandle)
+{
+    if (clientHandle < 0 || clientHandle >= MAX_OPC_ITEMS)
+        return -1;
+    return FLocal[clientHandle];
+}
+
+//---------------------------------------------------------------------------
+// 쓰기 요청 넣기 (메인 스레드, 대기열이 가득 차면 false)
+//---------------------------------------------------------------------------
+bool __fastcall TOpcWorker::PostWrite(int cmd, int pos, int gen, int index, const VARIANT &value)
+{
+    bool ok = false;
+
+    EnterCriticalSection(&FcsWrite);
+    if (FWriteCount < OPC_WRITE_QUEUE)
+    {
+        TOpcWrite* w = &FWrites[FWriteCount++];
+        w->Cmd = cmd;
+        w->Pos = pos;
+        w->Gen = gen;
+        w->Index = index;
+        VariantInit(&w->Value);
+        VariantCopy(&w->Value, (VARIANT*)&value);
+        ok = true;
+    }
+    LeaveCriticalSection(&FcsWrite);
+
+    if (ok)
+    {
+        InterlockedExchange(&FWritePending, 1);
+        SetEvent(FWriteEvent);
+    }
+    return ok;
+}
+
+//---------------------------------------------------------------------------
+// 쌓인 쓰기 적용 (작업자 스레드) - 서버 왕복 한 번 (OPCGroup.SyncWrite)
+// 작업자 스레드에서 동기로 쓰므로 다른 서버/메인 스레드는 기다리지 않는다.
+//---------------------------------------------------------------------------
+void __fastcall TOpcWorker::ApplyWrites()
+{
+    TOpcWrite writes[OPC_WRITE_QUEUE];
+    int count;
+
+    EnterCriticalSection(&FcsWrite);
+    count = FWriteCount;
+    for (int n = 0; n < count; n++)
+        writes[n] = FWrites[n];         // VARIANT 소유권 이동
+    FWriteCount = 0;
+    InterlockedExchange(&FWritePending, 0);
+    LeaveCriticalSection(&FcsWrite);
+
+    if (count == 0)
+        return;
+
+    BYTE result[OPC_WRITE_QUEUE];
+    long handles[OPC_WRITE_QUEUE];
+    int map[OPC_WRITE_QUEUE];          // SAFEARRAY 순번 -> writes 순번
+    int valid = 0;
+
+    for (int n = 0; n < count; n++)
+    {
+        // 재적재 중이라 세대가 다르면 인덱스가 다른 아이템을 가리킬 수 있음
+        if (writes[n].Gen != FGen)
+        {
+            result[n] = WRITE_ERR_BUSY;
+            continue;
+        }
+
+        result[n] = WRITE_ERR_COMM;
+        int k = LocalIndex(writes[n].Index);
+        if (!MyGroup || k < 0 || FItems[k] == NULL)
+            continue;
+
+        handles[valid] = FItems[k]->get_ServerHandle();
+        map[valid++] = n;
+    }
+
+    if (valid > 0)
+    {
+        SAFEARRAYBOUND bound;
+        bound.lLbound = 1;
+        bound.cElements = valid;
+
+        SAFEARRAY* psaHandles = SafeArrayCreate(VT_I4, 1, &bound);
+        SAFEARRAY* psaValues = SafeArrayCreate(VT_VARIANT, 1, &bound);
+        SAFEARRAY* psaErrors = NULL;
+
+        for (long v = 0; v < valid; v++)
+        {
+            long ix = v + 1;
+            SafeArrayPutElement(psaHandles, &ix, &handles[v]);
+            SafeArrayPutElement(psaValues, &ix, &writes[map[v]].Value);
+        }
+
+        try
+        {
+            HRESULT hr = MyGroup->SyncWrite(valid, &psaHandles, &psaValues, &psaErrors);
+
+            long lb = 1;
+            if (psaErrors != NULL)
+                SafeArrayGetLBound(psaErrors, 1, &lb);
+
+            for (long v = 0; v < valid; v++)
+            {
+                long err = hr;
+                long ix = lb + v;
+                if (psaErrors != NULL)
+                    SafeArrayGetElement(psaErrors, &ix, &err);
+                result[map[v]] = SUCCEEDED(err) ? WRITE_OK : WRITE_ERR_REJECT;
+            }
+        }
+        catch (Exception &e)
+        {
+            FAgent->LogMessage("OPC WRITE ERR " + FProgID + ": " + e.Message);
+            for (int v = 0; v < valid; v++)
+                result[map[v]] = WRITE_ERR_COMM;
+        }
+
+        SafeArrayDestroy(psaHandles);
+        SafeArrayDestroy(psaValues);
+        if (psaErrors != NULL)
+            SafeArrayDestroy(psaErrors);
+    }
+
+    for (int n = 0; n < count; n++)
+    {
+        FAgent->CompleteWrite(writes[n].Cmd, writes[n].Pos, result[n]);
+        VariantClear(&writes[n].Value);
+    }
+}
+
+//---------------------------------------------------------------------------
+// 담당 아이템을 Comm Failure 로 표시 (값은 마지막 값 유지)
+//---------------------------------------------------------------------------
+void __fastcall TOpcWorker::MarkCommFailure()
+{
+    InterlockedExchange(&FMetrics->Connected, 0);
+    for (int k = 0; k < FCount; k++)
+        FAgent->PublishItem(FGen, FIndex[k], NULL, OPC_QUALITY_COMM_FAILURE);
+}
+
+//---------------------------------------------------------------------------
+// 아이템 하나 등록 (FIndex[k] -> FItems[k])
+//---------------------------------------------------------------------------
+bool __fastcall TOpcWorker::RegisterItem(int k)
+{
+    int i = FIndex[k];
+    TOPCItemInfo* item = &FAgent->ItemTable(FGen)[i];
+    OPCItem *tempItem = NULL;
+    try
+    {
+        MyItems->AddItem(WideString(item->TagName), i, &tempItem);
+        FItems[k] = tempItem;
+
+        if (tempItem != NULL)
+        {
+            long serverHandle = tempItem->get_ServerHandle();
+            long clientHandle = tempItem->get_ClientHandle();
+            item->ServerHandle = serverHandle;
+            item->AddError = S_OK;
+            FAgent->LogMessage("  [" + IntToStr(i) + "] SH=" + IntToStr(serverHandle) + " CH=" + IntToStr(clientHandle));
+        }
+        return true;
+    }
+    catch (Exception &e)
+    {
+        FAgent->LogMessage("  [" + IntToStr(i) + "] AddItem FAIL: " + e.Message);
+        FItems[k] = NULL;
+        item->ServerHandle = 0;
+        item->AddError = E_FAIL;
+        return false;
+    }
+}
+
+//---------------------------------------------------------------------------
+// 담당 아이템 일괄 등록 (OPCItems.AddItems - 서버 왕복 한 번)
+// 일괄 호출 자체가 실패하면 아이템별 AddItem 으로 대신한다.
+//---------------------------------------------------------------------------
+int __fastcall TOpcWorker::RegisterAll()
+{
+    if (FCount == 0)
+        return 0;
+
+    TOPCItemInfo* table = FAgent->ItemTable(FGen);
+
+    SAFEARRAYBOUND bound;
+    bound.lLbound = 1;
+    bound.cElements = FCount;
+
+    SAFEARRAY* psaIds = SafeArrayCreate(VT_BSTR, 1, &bound);
+    SAFEARRAY* psaClient = SafeArrayCreate(VT_I4, 1, &bound);
+    SAFEARRAY* psaServer = NULL;
+    SAFEARRAY* psaErrors = NULL;
+
+    for (long k = 0; k < FCount; k++)
+    {
+        long ix = k + 1;
+        WideString tag = table[FIndex[k]].TagName;
+        long clientHandle = FIndex[k];
+        SafeArrayPutElement(psaIds, &ix, tag.c_bstr());
+        SafeArrayPutElement(psaClient, &ix, &clientHandle);
+    }
+
+    HRESULT hr = MyItems->AddItems(FCount, &psaIds, &psaClient, &psaServer, &psaErrors);
+
+    int regCount = 0;
+    if (SUCCEEDED(hr) && psaServer != NULL && psaErrors != NULL)
+    {
+        long lbServer, lbErrors;
+        SafeArrayGetLBound(psaServer, 1, &lbServer);
+        SafeArrayGetLBound(psaErrors, 1, &lbErrors);
+
+        for (long k = 0; k < FCount; k++)
+        {
+            int i = FIndex[k];
+            long ix;
+            long serverHandle = 0;
+            long err = E_FAIL;
+
+            ix = lbServer + k;
+            SafeArrayGetElement(psaServer, &ix, &serverHandle);
+            ix = lbErrors + k;
+            SafeArrayGetElement(psaErrors, &ix, &err);
+
+            FItems[k] = NULL;
+            if (SUCCEEDED(err))
+            {
+                try
+                {
+                    FItems[k] = MyItems->GetOPCItem(serverHandle);
+                }
+                catch (Exception &e)
+                {
+                    err = E_FAIL;
+                }
+            }
+
+            table[i].ServerHandle = (FItems[k] != NULL) ? serverHandle : 0;
+            table[i].AddError = err;
+
+            if (FItems[k] != NULL)
+                regCount++;
+            else
+                FAgent->LogMessage("  [" + IntToStr(i) + "] AddItem FAIL: " + IntToHex((int)err, 8));
+        }
+    }
+    else
+    {
+        FAgent->LogMessage("OPC AddItems " + IntToHex((int)hr, 8) + " " + FProgID);
+        for (int k = 0; k < FCount; k++)
+        {
+            if (RegisterItem(k))
+                regCount++;
+        }
+    }
+
+    SafeArrayDestroy(psaIds);
+    SafeArrayDestroy(psaClient);
+    if (psaServer != NULL) SafeArrayDestroy(psaServer);
+    if (psaErrors != NULL) SafeArrayDestroy(psaErrors);
+
+    return regCount;
+}
+
+//---------------------------------------------------------------------------
+// 아이템 해제 (OPCItems.Remove - 서버 핸들 배열은 1부터 시작)
+//---------------------------------------------------------------------------
+void __fastcall TOpcWorker::RemoveHandles(long* handles, int count)
+{
+    SAFEARRAYBOUND bound;
+    bound.lLbound = 1;
+    bound.cElements = count;
+
+    SAFEARRAY* psaHandles = SafeArrayCreate(VT_I4, 1, &bound);
+    SAFEARRAY* psaErrors = NULL;
+
+    for (long n = 0; n < count; n++)
+    {
+        long ix = n + 1;
+        SafeArrayPutElement(psaHandles, &ix, &handles[n]);
+    }
+
+    try
+    {
+        MyItems->Remove(count, &psaHandles, &psaErrors);
+    }
+    catch (Exception &e)
+    {
+        FAgent->LogMessage("OPC REMOVE ERR " + FProgID + ": " + e.Message);
+    }
+
+    SafeArrayDestroy(psaHandles);
+    if (psaErrors != NULL)
+        SafeArrayDestroy(psaErrors);
+}
+
+//---------------------------------------------------------------------------
+// 재적재 계획 적용 (작업자 스레드, 주기 사이)
+// 유지되는 아이템은 등록 그대로 옮기고, 빠진 것만 해제 / 새 것만 등록
+// 서버가 끊겨 있으면 목록만 바꾸고 등록은 재연결 시 Connect 가 한다.
+//---------------------------------------------------------------------------
+void __fastcall TOpcWorker::ApplyPlan()
+{
+    if (InterlockedExchange(&FPlanPending, 0) == 0)
+        return;
+
+    bool keep[MAX_OPC_ITEMS];
+    for (int k = 0; k < FCount; k++)
+        keep[k] = false;
+    for (int k = 0; k < FPlanCount; k++)
+    {
+        if (FPlanOld[k] >= 0)
+            keep[FPlanOld[k]] = true;
+    }
+
+    // 1. 빠진 아이템 해제
+    long handles[MAX_OPC_ITEMS];
+    int removeCount = 0;
+    for (int k = 0; k < FCount; k++)
+    {
+        if (keep[k] || FItems[k] == NULL)
+            continue;
+        try
+        {
+            handles[removeCount] = FItems[k]->get_ServerHandle();
+            removeCount++;
+        }
+        catch (Exception &e)
+        {
+        }
+    }
+    if (removeCount > 0 && MyItems)
+        RemoveHandles(handles, removeCount);
+
+    // 2. 새 세대 목록으로 교체 (유지 아이템은 등록 승계)
+    OPCItem* items[MAX_OPC_ITEMS];
+    for (int k = 0; k < FPlanCount; k++)
+        items[k] = (FPlanOld[k] >= 0) ? FItems[FPlanOld[k]] : NULL;
+
+    // 유지 아이템의 테이블 인덱스가 바뀌었으면 ClientHandle 도 새 인덱스로
+    for (int k = 0; k < FPlanCount; k++)
+    {
+        int o = FPlanOld[k];
+        if (o >= 0 && items[k] != NULL && FIndex[o] != FPlanIndex[k])
+            items[k]->set_ClientHandle(FPlanIndex[k]);
+    }
+
+    for (int k = 0; k < FCount; k++)
+        FLocal[FIndex[k]] = -1;
+
+    FGen = FPlanGen;
+    FCount = FPlanCount;
+
+    int addCount = 0;
+    for (int k = 0; k < FCount; k++)
+    {
+        FIndex[k] = FPlanIndex[k];
+        FItems[k] = items[k];
+        FLocal[FIndex[k]] = k;
+
+        if (FPlanOld[k] < 0 && MyItems && RegisterItem(k))
+            addCount++;
+    }
+
+    InterlockedExchange(&FAppliedGen, FGen);
+    FAgent->LogMessage("OPC RELOAD " + FProgID + " +" + IntToStr(addCount) +
+                       " -" + IntToStr(removeCount) + " =" + IntToStr(FCount));
+}
+
+//---------------------------------------------------------------------------
+// 서버 연결 + 그룹 설정 + 아이템 등록
+//---------------------------------------------------------------------------
+bool __fastcall TOpcWorker::Connect()
+{
+    try
+    {
+        // 1. OPC 서버 연결
+        OPCServer = CoOPCServer::Create();
+        OPCServer->Connect(WideString(FProgID), TNoParam());
+        FAgent->LogMessage("OPC OK " + FProgID);
+
+        // ServerShutDown 이벤트 구독 (실패해도 ServerState 폴링으로 감시)
+        IConnectionPointContainer* cpc = NULL;
+        if (SUCCEEDED(OPCServer->QueryInterface(IID_IConnectionPointContainer, (void**)&cpc)))
+        {
+            if (SUCCEEDED(cpc->FindConnectionPoint(DIID_DIOPCServerEvent, &FEventCP)))
+            {
+                FSink = new TOpcShutdownSink(this);
+                if (FAILED(FEventCP->Advise(FSink, &FEventCookie)))
+                    FEventCookie = 0;
+            }
+            cpc->Release();
+        }
+
+        // 2. 그룹 설정
+        OPCGroups = OPCServer->OPCGroups;
+        OPCGroups->DefaultGroupIsActive = true;
+        OPCGroups->DefaultGroupUpdateRate = 1000;
+
+        IOPCGroup *tempGroup = NULL;
+        OPCGroups->Add(TVariant(WideString("TestGroup")), &tempGroup);
+        MyGroup = tempGroup;
+
+        MyGroup->IsActive = true;
+        MyGroup->IsSubscribed = true;
+        MyGroup->set_IsActive(VARIANT_TRUE);
+        MyGroup->set_IsSubscribed(VARIANT_TRUE);
+        MyGroup->set_UpdateRate(1000);
+
+        MyItems = MyGroup->OPCItems;
+    }
+    catch (Exception &e)
+    {
+        FAgent->LogMessage("OPC FAIL " + FProgID + ": " + e.Message);
+        return false;
+    }
+    FShutdown = false;
+    FReadFailed = false;
+
+    // 3. 아이템 등록 (일괄)
+    int regCount = RegisterAll();
+    FAgent->LogMessage("ITEM:" + IntToStr(regCount) + "/" + IntToStr(FCount) + " " + FProgID);
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+void __fastcall TOpcWorker::Disconnect()
+{
+    for (int k = 0; k < FCount; k++)
+        FItems[k] = NULL;
+
+    // 이벤트 구독 해제 (서버가 죽었으면 실패할 수 있음 - 무시)
+    if (FEventCP != NULL)
+    {
+        if (FEventCookie != 0)
+            FEventCP->Unadvise(FEventCookie);
+        FEventCP->Release();
+        FEventCP = NULL;
+        FEventCookie = 0;
+    }
+    if (FSink != NULL)
+    {
+        FSink->Detach();
+        FSink->Release();
+        FSink = NULL;
+    }
+
+    try
+    {
+        if (OPCServer)
+        {
+            OPCServer->Disconnect();
+        }
+    }
+    catch (Exception &ex)
+    {
+        FAgent->LogMessage("E:" + ex.Message);
+    }
+
+    MyItems = NULL;
+    MyGroup = NULL;
+    OPCGroups = NULL;
+    OPCServer = NULL;
+}
+
+//---------------------------------------------------------------------------
+// 담당 아이템 읽기 - OPCItem.Read() 사용
+// 읽기는 잠금 없이 하고, 결과만 PublishItem으로 공용 테이블에 반영
+//---------------------------------------------------------------------------
+void __fastcall TOpcWorker::ReadItems(bool initial)
+{
+    int tried = 0;
+    int errors = 0;
+
+    for (int k = 0; k < FCount && !Terminated; k++)
+    {
+        // 느린 서버의 긴 읽기 주기 중에도 쓰기는 아이템 사이에서 바로 처리
+        if (FWritePending)
+            ApplyWrites();
+
+        int i = FIndex[k];
+        OPCItem* pItem = FItems[k];
+        if (pItem == NULL)
+            continue;
+
+        VARIANT varValue, varQuality, varTimestamp;
+        VariantInit(&varValue);
+        VariantInit(&varQuality);
+        VariantInit(&varTimestamp);
+        tried++;
+
+        try
+        {
+            HRESULT hr = pItem->Read(2, &varValue, &varQuality, &varTimestamp);
+
+            if (initial)
+            {
+                FAgent->LogMessage("INIT RD[" + IntToStr(i) + "] hr=" + IntToHex((int)hr, 8) +
+                                   " vt=" + IntToStr(varValue.vt) +
+                                   " V=" + FAgent->VariantToString(varValue));
+            }
+
+            if (SUCCEEDED(hr))
+            {
+                long quality;
+                if (varQuality.vt == VT_I2) quality = varQuality.iVal;
+                else if (varQuality.vt == VT_I4) quality = varQuality.lVal;
+                else quality = 192;
+
+                // 원본 시각 (서버 타임스탬프, 묶음 전송의 샘플 시각)
+                double srcTime = (varTimestamp.vt == VT_DATE) ? varTimestamp.date : 0;
+
+                FAgent->PublishItem(FGen, i, &varValue, quality, srcTime);
+            }
+            else if (!initial)
+            {
+                // Read 실패 시 get_Value 시도
+                long quality = 0;
+                VariantClear(&varValue);
+                pItem->get_Value(&varValue);
+                pItem->get_Quality(&quality);
+
+                FAgent->PublishItem(FGen, i, &varValue, quality);
+            }
+        }
+        catch (Exception &e)
+        {
+            FAgent->LogMessage((initial ? "INIT RD ERR[" : "RD ERR[") + IntToStr(i) + "]: " + e.Message);
+            if (!initial)
+                FAgent->PublishItem(FGen, i, NULL, 0);
+            errors++;
+        }
+
+        VariantClear(&varValue);
+        VariantClear(&varQuality);
+        VariantClear(&varTimestamp);
+    }
+
+    InterlockedExchangeAdd(&FMetrics->ItemsRead, tried);
+    InterlockedExchangeAdd(&FMetrics->ReadErrors, errors);
+
+    // 모든 아이템이 예외 -> 서버 연결 끊김으로 판단
+    FReadFailed = (tried > 0 && errors == tried);
+}
+
+//---------------------------------------------------------------------------
+// 작업자 본체: 연결 -> 초기 읽기 -> 주기 읽기 (끊기면 백오프 재연결)
+//---------------------------------------------------------------------------
+void __fastcall TOpcWorker::Execute()
+{
+    // STA 모드로 COM 초기화 (OPC Automation은 STA 필요, 스레드마다 별도 아파트)
+    CoInitialize(NULL);
+
+    DWORD backoff = OPC_RECONN_MIN_MS;
+    DWORD lostTick = 0;
+    bool first = true;
+
+    while (!Terminated)
+    {
+        ApplyPlan();
+
+        if (!Connect())
+        {
+            Disconnect();
+            if (first)
+            {
+                // 초기 연결 실패 - 서비스 기동은 막지 않고 백그라운드에서 재시도
+                MarkCommFailure();
+                SetEvent(FReady);
+                first = false;
+                lostTick = GetTickCount();
+            }
+
+            FAgent->LogMessage("OPC RETRY " + FProgID + " " + IntToStr((int)backoff) + "ms");
+            WaitWake(backoff);
+            backoff = (backoff * 2 > OPC_RECONN_MAX_MS) ? OPC_RECONN_MAX_MS : backoff * 2;
+            continue;
+        }
+        backoff = OPC_RECONN_MIN_MS;
+        InterlockedExchange(&FMetrics->Connected, 1);
+
+        if (first)
+        {
+            // 초기 데이터 읽기 대기 (OPC 서버가 데이터 준비할 시간)
+            WaitWake(2000);
+
+            if (!Terminated)
+                ReadItems(true);
+            SetEvent(FReady);
+            first = false;
+        }
+        else
+        {
+            FAgent->LogMessage("OPC RECONN " + FProgID + " T:" + IntToStr((int)(GetTickCount() - lostTick)) + "ms");
+        }
+
+        // 주기 읽기 + 상태 감시
+        while (!Terminated)
+        {
+            ApplyPlan();
+
+            DWORD startTick = GetTickCount();
+            ReadItems(false);
+
+            DWORD elapsed = GetTickCount() - startTick;
+            InterlockedIncrement(&FMetrics->Scans);
+            InterlockedExchangeAdd(&FMetrics->ScanMs, (LONG)elapsed);
+            InterlockedExchange(&FMetrics->LastScanMs, (LONG)elapsed);
+
+            if (!IsHealthy())
+                break;
+
+            // 대기 중 주기가 바뀌면 (적응 주기) 읽기 시작 시각부터 새 주기로
+            while (!Terminated && !FShutdown && !FPlanPending)
+            {
+                DWORD waited = GetTickCount() - startTick;
+                DWORD interval = FInterval;
+                if (waited >= interval)
+                    break;
+                WaitWake(interval - waited);
+            }
+
+            if (FShutdown)
+                break;
+        }
+
+        if (!Terminated)
+        {
+            // 연결 끊김: 마지막 값 + Comm Failure 로 전송은 계속되고 재연결 시도
+            FAgent->LogMessage("OPC LOST " + FProgID);
+            MarkCommFailure();
+            lostTick = GetTickCount();
+        }
+
+        Disconnect();
+    }
+
+    CoUninitialize();
+}
@@ -0,0 +1,129 @@
+//---------------------------------------------------------------------------
+#ifndef OpcWorkerH
+#define OpcWorkerH
+//---------------------------------------------------------------------------
+#include <Classes.hpp>
+#include "SvcController.h"
+
+// 서버 재연결 대기 (지수 증가)
+#define OPC_RECONN_MIN_MS       1000
+#define OPC_RECONN_MAX_MS       60000
+
+// 연결이 끊긴 동안 마지막 값에 붙이는 Quality (OPC Bad - Comm Failure)
+#define OPC_QUALITY_COMM_FAILURE    0x18
+
+// 쓰기 대기열 (아이템 단위)
+#define OPC_WRITE_QUEUE         64
+
+class TOpcShutdownSink;
+
+// 쓰기 요청 하나 (메인 스레드가 넣고 작업자가 SyncWrite 로 적용)
+struct TOpcWrite
+{
+    int         Cmd;            // 에이전트 명령 번호 (결과 보고용)
+    int         Pos;            // 명령 안의 순번
+    int         Gen;            // Index 의 테이블 세대
+    int         Index;          // 테이블 인덱스 (= ClientHandle)
+    VARIANT     Value;
+};
+
+//---------------------------------------------------------------------------
+// OPC 서버별 수집 작업자
+// 서버마다 스레드와 COM 아파트(STA)를 하나씩 가지고 자기 아이템만 읽어서
+// 공용 아이템 테이블에 반영한다. 느린 서버가 다른 서버의 수집을 막지 않는다.
+//
+// ServerState 폴링과 ServerShutDown 이벤트로 서버 상태를 감시하고, 끊기면
+// 담당 아이템을 Comm Failure 로 표시한 뒤 지수 백오프로 재연결하여
+// 기존 아이템 테이블을 그대로 다시 등록한다.
+//
+// 설정 재적재 시 메인 스레드가 새 테이블 세대의 담당 목록(계획)을 넘기면
+// 주기 사이에 적용하여 빠진 아이템만 해제하고 새 아이템만 등록한다.
+//
+// ESP32 쓰기 명령은 대기열로 받아 주기 읽기 중간에도(아이템 사이) 바로
+// 한 번의 SyncWrite 로 적용하고 아이템별 결과를 에이전트에 돌려준다.
+//
+// ClientHandle 은 테이블 인덱스로 등록한다. 서버가 돌려주는 핸들(DataChange,
+// AsyncReadComplete 등)에서 검색 없이 바로 테이블 칸과 담당 순번을 찾는다.
+//---------------------------------------------------------------------------
+class TOpcWorker : public TThread
+{
+private:
+    TGa1Agent*          FAgent;
+    String              FProgID;
+    volatile DWORD      FInterval;      // 읽기 주기 (ms)
+    HANDLE              FWake;          // 종료 시 대기 해제
+    HANDLE              FRateEvent;     // 주기 변경 (적응 주기 - 남은 대기를 새 주기로)
+    HANDLE              FReady;         // 초기 읽기 완료 (성공/실패 무관)
+
+    int                 FGen;                   // 사용 중인 아이템 테이블 세대
+    int                 FIndex[MAX_OPC_ITEMS];  // 담당 아이템 (테이블 인덱스)
+    OPCItem*            FItems[MAX_OPC_ITEMS];  // 등록된 OPC 아이템 (FIndex 와 같은 순서)
+    int                 FLocal[MAX_OPC_ITEMS];  // 테이블 인덱스 -> 담당 순번 (-1: 담당 아님)
+    int                 FCount;
+
+    // 설정 재적재 계획 (메인 스레드가 작성, 작업자가 적용)
+    HANDLE              FPlanEvent;
+    volatile LONG       FPlanPending;
+    volatile LONG       FAppliedGen;
+    int                 FPlanGen;
+    int                 FPlanIndex[MAX_OPC_ITEMS];
+    int                 FPlanOld[MAX_OPC_ITEMS];    // 기존 FIndex 위치 (-1: 새 아이템)
+    int                 FPlanCount;
+
+    // OPC 관련 (이 스레드의 아파트에서만 사용)
+    _di_IOPCAutoServer  OPCServer;
+    _di_IOPCGroups      OPCGroups;
+    _di_IOPCGroup       MyGroup;
+    _di_IOPCItems       MyItems;
+
+    // 쓰기 대기열 (메인 스레드 -> 작업자)
+    CRITICAL_SECTION    FcsWrite;
+    TOpcWrite           FWrites[OPC_WRITE_QUEUE];
+    int                 FWriteCount;
+    volatile LONG       FWritePending;
+    HANDLE              FWriteEvent;
+
+    // 서버 상태 감시
+    IConnectionPoint*   FEventCP;
+    TOpcShutdownSink*   FSink;
+    DWORD               FEventCookie;
+    volatile bool       FShutdown;      // ServerShutDown 수신
+    bool                FReadFailed;    // 직전 주기 전체 읽기 실패
+
+    TScanMetrics*       FMetrics;       // 실시간 지표 칸 (에이전트 소유)
+
+    bool __fastcall Connect();
+    void __fastcall Disconnect();
+    bool __fastcall RegisterItem(int k);
+    int __fastcall RegisterAll();
+    void __fastcall RemoveHandles(long* handles, int count);
+    void __fastcall ApplyPlan();
+    void __fastcall ReadItems(bool initial);
+    bool __fastcall IsHealthy();
+    void __fastcall MarkCommFailure();
+    void __fastcall WaitWake(DWORD ms);
+    void __fastcall ApplyWrites();
+
+protected:
+    void __fastcall Execute();
+
+public:
+    __fastcall TOpcWorker(TGa1Agent* agent, String progId, DWORD interval, int gen);
+    __fastcall ~TOpcWorker();
+
+    void __fastcall AddItem(int index);
+    void __fastcall Stop();
+    void __fastcall NotifyShutdown(String reason);
+    void __fastcall PostPlan(int gen, const int* index, const int* old, int count);
+    bool __fastcall PostWrite(int cmd, int pos, int gen, int index, const VARIANT &value);
+    void __fastcall SetInterval(DWORD interval);
+    int __fastcall IndexAt(int k) { return FIndex[k]; }
+    int __fastcall LocalIndex(long clientHandle);
+
+    __property String ProgID = {read = FProgID};
+    __property HANDLE ReadyEvent = {read = FReady};
+    __property int ItemCount = {read = FCount};
+    __property LONG AppliedGen = {read = FAppliedGen};
+};
+//---------------------------------------------------------------------------
+#endif
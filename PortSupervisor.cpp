@@ -0,0 +1,142 @@
+//---------------------------------------------------------------------------
+#include "PortSupervisor.h"
+//---------------------------------------------------------------------------
+#pragma package(smart_init)
+
+//---------------------------------------------------------------------------
+__fastcall TPortSupervisor::TPortSupervisor()
+    : TThread(true)
+{
+    FreeOnTerminate = false;
+
+    FWake = CreateEvent(NULL, FALSE, FALSE, NULL);
+    FSeed = GetTickCount() ^ GetCurrentProcessId();
+
+    for (int l = 0; l < MAX_ESP_LINKS; l++)
+    {
+        FWatch[l] = 0;
+        FReady[l] = 0;
+        FReset[l] = 0;
+        FPort[l] = 0;
+        FArmed[l] = false;
+        FBackoff[l] = PORT_RECONN_MIN_MS;
+        FNextTick[l] = 0;
+    }
+}
+
+//---------------------------------------------------------------------------
+__fastcall TPortSupervisor::~TPortSupervisor()
+{
+    CloseHandle(FWake);
+}
+
+//---------------------------------------------------------------------------
+// 감시 시작 (메인 스레드) - 끊김 직후에는 resetBackoff=true,
+// 장치는 있었지만 열기에 실패했으면 false 로 대기 시간을 계속 늘린다.
+//---------------------------------------------------------------------------
+void __fastcall TPortSupervisor::Watch(int link, int portNum, bool resetBackoff)
+{
+    InterlockedExchange(&FPort[link], portNum);
+    if (resetBackoff)
+        InterlockedExchange(&FReset[link], 1);
+    InterlockedExchange(&FReady[link], 0);
+    InterlockedExchange(&FWatch[link], 1);
+    SetEvent(FWake);
+}
+
+//---------------------------------------------------------------------------
+// 장치가 다시 나타났는지 확인 (메인 스레드, 확인하면 플래그 소거)
+//---------------------------------------------------------------------------
+bool __fastcall TPortSupervisor::TakeReady(int link)
+{
+    return (InterlockedExchange(&FReady[link], 0) != 0);
+}
+
+//---------------------------------------------------------------------------
+void __fastcall TPortSupervisor::Stop()
+{
+    Terminate();
+    SetEvent(FWake);
+    WaitFor();
+}
+
+//---------------------------------------------------------------------------
+// 대기 시간 ±25% 지터 (여러 포트가 같은 순간에 재시도하지 않도록)
+//---------------------------------------------------------------------------
+DWORD __fastcall TPortSupervisor::Jitter(DWORD ms)
+{
+    FSeed = FSeed * 1103515245 + 12345;
+    DWORD span = ms / 2;
+    DWORD r = (span > 0) ? ((FSeed >> 8) % (span + 1)) : 0;
+    return ms - ms / 4 + r;
+}
+
+//---------------------------------------------------------------------------
+// 장치 확인 - 배타적으로 열렸다 닫히면 메인 스레드가 열 수 있는 상태
+// (분리된 USB 포트는 ERROR_FILE_NOT_FOUND 로 즉시 실패)
+//---------------------------------------------------------------------------
+bool __fastcall TPortSupervisor::ProbePort(int portNum)
+{
+    String name = "\\\\.\\COM" + IntToStr(portNum);
+
+    HANDLE h = CreateFile(name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL,
+                          OPEN_EXISTING, 0, NULL);
+    if (h == INVALID_HANDLE_VALUE)
+        return false;
+
+    CloseHandle(h);
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// 감시 본체: 포트마다 다음 확인 시각이 되면 장치 확인, 없으면 대기 2배
+//---------------------------------------------------------------------------
+void __fastcall TPortSupervisor::Execute()
+{
+    while (!Terminated)
+    {
+        DWORD now = GetTickCount();
+        DWORD wait = INFINITE;
+
+        for (int l = 0; l < MAX_ESP_LINKS; l++)
+        {
+            if (FWatch[l] == 0)
+            {
+                FArmed[l] = false;
+                continue;
+            }
+
+            if (!FArmed[l])
+            {
+                if (InterlockedExchange(&FReset[l], 0) != 0)
+                    FBackoff[l] = PORT_RECONN_MIN_MS;
+                FNextTick[l] = now + Jitter(FBackoff[l]);
+                FArmed[l] = true;
+            }
+
+            long remain = (long)(FNextTick[l] - now);
+            if (remain <= 0)
+            {
+                if (ProbePort(FPort[l]))
+                {
+                    // 메인 스레드가 다음 주기에 연다 (실패하면 Watch 로 다시 요청)
+                    FArmed[l] = false;
+                    InterlockedExchange(&FWatch[l], 0);
+                    InterlockedExchange(&FReady[l], 1);
+                    continue;
+                }
+
+                FBackoff[l] = (FBackoff[l] * 2 > PORT_RECONN_MAX_MS) ? PORT_RECONN_MAX_MS : FBackoff[l] * 2;
+                FNextTick[l] = GetTickCount() + Jitter(FBackoff[l]);
+                remain = (long)(FNextTick[l] - GetTickCount());
+                if (remain < 0) remain = 0;
+            }
+
+            if ((DWORD)remain < wait)
+                wait = (DWORD)remain;
+        }
+
+        WaitForSingleObject(FWake, wait);
+    }
+}
+//---------------------------------------------------------------------------
@@ -0,0 +1,48 @@
+//---------------------------------------------------------------------------
+#ifndef PortSupervisorH
+#define PortSupervisorH
+//---------------------------------------------------------------------------
+#include <Classes.hpp>
+#include "SvcController.h"
+
+// 포트 재연결 대기 (지수 증가, ±25% 지터)
+#define PORT_RECONN_MIN_MS      500
+#define PORT_RECONN_MAX_MS      30000
+
+//---------------------------------------------------------------------------
+// 시리얼 포트 감시자
+// 끊긴 포트(USB-시리얼 분리 등)의 장치가 다시 나타나는지 백그라운드에서
+// 확인한다. 포트 열기는 TVaComm 을 쓰는 메인 스레드가 하고, 여기서는
+// 장치가 열릴 수 있는 상태인지만 알려준다. 타이머 스레드는 대기하지 않는다.
+//---------------------------------------------------------------------------
+class TPortSupervisor : public TThread
+{
+private:
+    HANDLE              FWake;                          // 감시 요청 / 종료
+    volatile LONG       FWatch[MAX_ESP_LINKS];          // 1 = 감시 중
+    volatile LONG       FReady[MAX_ESP_LINKS];          // 1 = 장치 있음, 열기 시도 가능
+    volatile LONG       FReset[MAX_ESP_LINKS];          // 1 = 대기 시간 초기화
+    volatile LONG       FPort[MAX_ESP_LINKS];           // COM 번호
+
+    // 감시 스레드 전용
+    bool                FArmed[MAX_ESP_LINKS];
+    DWORD               FBackoff[MAX_ESP_LINKS];
+    DWORD               FNextTick[MAX_ESP_LINKS];
+    DWORD               FSeed;
+
+    bool __fastcall ProbePort(int portNum);
+    DWORD __fastcall Jitter(DWORD ms);
+
+protected:
+    void __fastcall Execute();
+
+public:
+    __fastcall TPortSupervisor();
+    __fastcall ~TPortSupervisor();
+
+    void __fastcall Watch(int link, int portNum, bool resetBackoff);
+    bool __fastcall TakeReady(int link);
+    void __fastcall Stop();
+};
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,20 @@
+//---------------------------------------------------------------------------
+#ifndef PortTypesH
+#define PortTypesH
+//---------------------------------------------------------------------------
+// VCL 비의존 단위의 공용 형식 (리눅스에서도 단독 컴파일 가능)
+// Win32 는 windows.h 그대로, 그 밖에서는 Win32 와 같은 폭으로 맞춘다.
+// DWORD 는 32비트 고정 - 로그/기록 파일 형식과 프로토콜 필드가 그대로 쓴다.
+//---------------------------------------------------------------------------
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <stdint.h>
+typedef uint8_t         BYTE;
+typedef uint16_t        WORD;
+typedef uint32_t        DWORD;
+typedef int64_t         LONGLONG;
+#endif
+
+//---------------------------------------------------------------------------
+#endif
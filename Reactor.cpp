@@ -0,0 +1,230 @@
+//---------------------------------------------------------------------------
+#include "Reactor.h"
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#endif
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+bool ReactorInit(TReactor* r)
+{
+    memset(r, 0, sizeof(TReactor));
+#ifdef _WIN32
+    return true;
+#else
+    r->Ep = epoll_create(REACTOR_MAX);
+    return r->Ep >= 0;
+#endif
+}
+
+void ReactorClose(TReactor* r)
+{
+    for (int id = 0; id < REACTOR_MAX; id++)
+    {
+        if (r->Entry[id].Used)
+            ReactorRemove(r, id);
+    }
+#ifndef _WIN32
+    if (r->Ep >= 0)
+        close(r->Ep);
+    r->Ep = -1;
+#endif
+}
+
+//---------------------------------------------------------------------------
+static int AddEntry(TReactor* r, TReactorHandle h, TReactorFn fn, void* ctx, bool timer)
+{
+    for (int id = 0; id < REACTOR_MAX; id++)
+    {
+        TReactorEntry* e = &r->Entry[id];
+        if (e->Used)
+            continue;
+
+#ifndef _WIN32
+        epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.u32 = (unsigned)id;
+        if (epoll_ctl(r->Ep, EPOLL_CTL_ADD, h, &ev) != 0)
+            return -1;
+#endif
+        e->Used = true;
+        e->Timer = timer;
+        e->H = h;
+        e->Fn = fn;
+        e->Ctx = ctx;
+        return id;
+    }
+    return -1;
+}
+
+int ReactorAddHandle(TReactor* r, TReactorHandle h, TReactorFn fn, void* ctx)
+{
+    return AddEntry(r, h, fn, ctx, false);
+}
+
+void ReactorRemove(TReactor* r, int id)
+{
+    if (id < 0 || id >= REACTOR_MAX || !r->Entry[id].Used)
+        return;
+
+    TReactorEntry* e = &r->Entry[id];
+#ifdef _WIN32
+    if (e->Timer)
+    {
+        CancelWaitableTimer(e->H);
+        CloseHandle(e->H);
+    }
+#else
+    epoll_ctl(r->Ep, EPOLL_CTL_DEL, e->H, NULL);
+    if (e->Timer)
+        close(e->H);
+#endif
+    memset(e, 0, sizeof(TReactorEntry));
+}
+
+//---------------------------------------------------------------------------
+// 타이머
+//---------------------------------------------------------------------------
+int ReactorAddTimer(TReactor* r, TReactorFn fn, void* ctx)
+{
+#ifdef _WIN32
+    HANDLE h = CreateWaitableTimer(NULL, FALSE, NULL);      // 자동 리셋
+    if (h == NULL)
+        return -1;
+    int id = AddEntry(r, h, fn, ctx, true);
+    if (id < 0)
+        CloseHandle(h);
+#else
+    int h = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    if (h < 0)
+        return -1;
+    int id = AddEntry(r, h, fn, ctx, true);
+    if (id < 0)
+        close(h);
+#endif
+    return id;
+}
+
+void ReactorArmTimer(TReactor* r, int id, DWORD dueMs, DWORD periodMs)
+{
+    if (id < 0 || id >= REACTOR_MAX || !r->Entry[id].Timer)
+        return;
+
+#ifdef _WIN32
+    LARGE_INTEGER due;
+    due.QuadPart = -(LONGLONG)dueMs * 10000;    // 상대 시간 (100ns)
+    if (due.QuadPart == 0)
+        due.QuadPart = -1;
+    SetWaitableTimer(r->Entry[id].H, &due, (LONG)periodMs, NULL, NULL, FALSE);
+#else
+    itimerspec ts;
+    memset(&ts, 0, sizeof(ts));
+    ts.it_value.tv_sec = dueMs / 1000;
+    ts.it_value.tv_nsec = (long)(dueMs % 1000) * 1000000L;
+    if (dueMs == 0)
+        ts.it_value.tv_nsec = 1;                // 0 이면 멈춤이므로
+    ts.it_interval.tv_sec = periodMs / 1000;
+    ts.it_interval.tv_nsec = (long)(periodMs % 1000) * 1000000L;
+    timerfd_settime(r->Entry[id].H, 0, &ts, NULL);
+#endif
+}
+
+void ReactorStopTimer(TReactor* r, int id)
+{
+    if (id < 0 || id >= REACTOR_MAX || !r->Entry[id].Timer)
+        return;
+
+#ifdef _WIN32
+    CancelWaitableTimer(r->Entry[id].H);
+#else
+    itimerspec ts;
+    memset(&ts, 0, sizeof(ts));
+    timerfd_settime(r->Entry[id].H, 0, &ts, NULL);
+#endif
+}
+
+//---------------------------------------------------------------------------
+// 대기 + 처리
+// 처리 함수 안에서 등록/해제가 일어나도 되도록 매번 등록 번호로 다시 확인한다.
+//---------------------------------------------------------------------------
+#ifdef _WIN32
+int ReactorRunOnce(TReactor* r, DWORD timeoutMs)
+{
+    HANDLE handles[REACTOR_MAX];
+    int ids[REACTOR_MAX];
+    int n = 0;
+
+    for (int id = 0; id < REACTOR_MAX; id++)
+    {
+        if (!r->Entry[id].Used)
+            continue;
+        handles[n] = r->Entry[id].H;
+        ids[n] = id;
+        n++;
+    }
+
+    DWORD w = MsgWaitForMultipleObjects(n, handles, FALSE,
+                                        (timeoutMs == REACTOR_INFINITE) ? INFINITE : timeoutMs, r->MsgMask);
+    if (w == WAIT_TIMEOUT)
+        return 0;
+    if (w == WAIT_OBJECT_0 + (DWORD)n)
+        return REACTOR_MESSAGE;
+    if (w >= WAIT_OBJECT_0 + (DWORD)n)
+        return -1;
+
+    r->Wakeups++;
+
+    // 깨운 핸들부터, 뒤쪽에서 함께 신호된 핸들도 이번에 처리 (앞쪽 핸들만 계속 이기지 않도록)
+    int done = 0;
+    for (int k = (int)(w - WAIT_OBJECT_0); k < n; k++)
+    {
+        if (k != (int)(w - WAIT_OBJECT_0) && WaitForSingleObject(handles[k], 0) != WAIT_OBJECT_0)
+            continue;
+
+        TReactorEntry* e = &r->Entry[ids[k]];
+        if (!e->Used || e->H != handles[k])
+            continue;       // 앞선 처리 함수가 해제함
+
+        e->Fn(e->Ctx);
+        r->Dispatched++;
+        done++;
+    }
+    return done;
+}
+#else
+int ReactorRunOnce(TReactor* r, DWORD timeoutMs)
+{
+    epoll_event evs[REACTOR_MAX];
+    int n = epoll_wait(r->Ep, evs, REACTOR_MAX, (timeoutMs == REACTOR_INFINITE) ? -1 : (int)timeoutMs);
+    if (n < 0)
+        return -1;
+    if (n == 0)
+        return 0;
+
+    r->Wakeups++;
+
+    int done = 0;
+    for (int k = 0; k < n; k++)
+    {
+        TReactorEntry* e = &r->Entry[evs[k].data.u32];
+        if (!e->Used)
+            continue;
+
+        if (e->Timer)
+        {
+            unsigned long long expirations;
+            if (read(e->H, &expirations, sizeof(expirations)) != sizeof(expirations))
+                continue;
+        }
+
+        e->Fn(e->Ctx);
+        r->Dispatched++;
+        done++;
+    }
+    return done;
+}
+#endif
@@ -0,0 +1,72 @@
+//---------------------------------------------------------------------------
+#ifndef ReactorH
+#define ReactorH
+//---------------------------------------------------------------------------
+// 단일 스레드 이벤트 루프 (VCL 비의존 - 리눅스에서도 단독 컴파일 가능)
+// 대기 가능한 핸들과 타이머를 한 곳에서 기다렸다가 준비된 것의 처리 함수를 부른다.
+//   Win32 - MsgWaitForMultipleObjects + 대기 타이머 (CreateWaitableTimer)
+//           MsgMask 를 주면 창 메시지/서비스 요청이 와도 깨어나 REACTOR_MESSAGE 반환
+//   Linux - epoll + timerfd (fd 는 비차단으로 등록)
+//
+// 처리 함수는 신호를 스스로 정리해야 한다 (수동 리셋 이벤트는 ResetEvent,
+// 변경 알림은 FindNextChangeNotification, fd 는 읽을 수 있는 만큼 읽기).
+// 타이머는 루프가 정리한다. 한 번 깨어나면 준비된 핸들을 모두 처리한다.
+//---------------------------------------------------------------------------
+#include "PortTypes.h"
+
+#ifdef _WIN32
+typedef HANDLE          TReactorHandle;
+#else
+typedef int             TReactorHandle;
+#endif
+
+// 등록 수 (Win32 는 MsgWaitForMultipleObjects 한도 MAXIMUM_WAIT_OBJECTS - 1 안)
+#ifdef _WIN32
+#define REACTOR_MAX         60
+#else
+#define REACTOR_MAX         128
+#endif
+#define REACTOR_INFINITE    0xFFFFFFFF
+#define REACTOR_MESSAGE     (-2)    // Win32: 창 메시지 도착 (호출측이 처리)
+
+typedef void (*TReactorFn)(void* ctx);
+
+struct TReactorEntry
+{
+    bool            Used;
+    bool            Timer;          // 루프가 만든 타이머 (해제도 루프가)
+    TReactorHandle  H;
+    TReactorFn      Fn;
+    void*           Ctx;
+};
+
+struct TReactor
+{
+    TReactorEntry   Entry[REACTOR_MAX];
+    DWORD           Dispatched;     // 처리 함수 호출 누적
+    DWORD           Wakeups;        // 대기에서 깨어난 횟수
+#ifdef _WIN32
+    DWORD           MsgMask;        // QS_xxx (0: 메시지로 깨지 않음)
+#else
+    int             Ep;
+#endif
+};
+
+bool ReactorInit(TReactor* r);
+void ReactorClose(TReactor* r);
+
+// 핸들/fd 등록 (등록 번호 반환, 가득 차면 -1) - 핸들 소유권은 호출측
+int  ReactorAddHandle(TReactor* r, TReactorHandle h, TReactorFn fn, void* ctx);
+void ReactorRemove(TReactor* r, int id);
+
+// 타이머 (만들기만 하고 멈춘 상태) - ReactorArmTimer 로 시작
+// periodMs 0 이면 한 번만, dueMs 0 이면 바로
+int  ReactorAddTimer(TReactor* r, TReactorFn fn, void* ctx);
+void ReactorArmTimer(TReactor* r, int id, DWORD dueMs, DWORD periodMs);
+void ReactorStopTimer(TReactor* r, int id);
+
+// 한 번 대기 + 처리 (처리한 수, 0: 시간 만료, REACTOR_MESSAGE, -1: 오류)
+int  ReactorRunOnce(TReactor* r, DWORD timeoutMs);
+
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,446 @@
+//---------------------------------------------------------------------------
+// 이벤트 루프 측정 (콘솔, 오프라인)
+// 빌드: bcc32 ReactorBench.cpp Reactor.cpp EspProto.cpp   (리눅스: g++ -O2 ReactorBench.cpp Reactor.cpp EspProto.cpp)
+//
+// 사용: ReactorBench [옵션]
+//   -d MS   측정 시간 (기본 2000)
+//   -p MS   수집 주기 (기본 10)
+//   -n N    프레임당 아이템 수 (기본 50)
+//   -e N    연결 수 하나만 (기본 1, 8, 32 을 차례로)
+//
+// 스레드 하나에서 연결 N개를 돌린다. 수집 타이머마다 응답을 기다리지 않는 연결에
+// 데이터 프레임(값 하나 패치)을 쓰고, 장치쪽 처리 함수가 프레임을 확인해 ACK 를 돌려준다.
+// 에이전트쪽 처리 함수는 RxPush/RxNext 로 응답을 꺼내 전송 -> ACK 지연을 잰다.
+//   Linux - 연결마다 socketpair (양끝 모두 비차단 fd 로 등록)
+//   Win32 - 연결마다 메모리 버퍼 + 이벤트 (장치쪽은 이벤트 하나를 함께 쓴다 - 대기 한도 63)
+//
+// 출력: 연결 수 / 프레임 / 넘긴 주기 / 지연 평균, p50, p99, 최대 / CPU % / 초당 깨어남
+// p50/p99 는 해당 지연 칸(LAT_BUCKET_US)의 가운데 값이고 최대를 넘지 않게 자른다.
+//---------------------------------------------------------------------------
+#include "EspProto.h"
+#include "Reactor.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#endif
+
+#define BENCH_MAX_EP    32
+#define BENCH_MAX_ITEMS 140
+#define BENCH_BUF       FRAME_SIZE(BENCH_MAX_ITEMS)
+#define LAT_BUCKET_US   10              // 지연 분포 칸 (10us)
+#define LAT_BUCKETS     10000           // 100ms 까지 (넘으면 마지막 칸)
+
+//---------------------------------------------------------------------------
+// 시계 (us)
+//---------------------------------------------------------------------------
+#ifdef _WIN32
+typedef __int64     TBenchUs;
+
+static TBenchUs NowUs()
+{
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER t;
+    if (freq.QuadPart == 0)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&t);
+    return (TBenchUs)(t.QuadPart * 1000000 / freq.QuadPart);
+}
+
+static TBenchUs CpuUs()
+{
+    FILETIME c, e, k, u;
+    GetProcessTimes(GetCurrentProcess(), &c, &e, &k, &u);
+    ULARGE_INTEGER kk, uu;
+    kk.LowPart = k.dwLowDateTime;  kk.HighPart = k.dwHighDateTime;
+    uu.LowPart = u.dwLowDateTime;  uu.HighPart = u.dwHighDateTime;
+    return (TBenchUs)((kk.QuadPart + uu.QuadPart) / 10);
+}
+#else
+typedef long long   TBenchUs;
+
+static TBenchUs NowUs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (TBenchUs)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static TBenchUs CpuUs()
+{
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (TBenchUs)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000 +
+           ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+#endif
+
+//---------------------------------------------------------------------------
+// 연결 양끝
+//---------------------------------------------------------------------------
+struct TPipeEnd
+{
+#ifdef _WIN32
+    HANDLE      Ev;             // 상대가 쓰면 신호 (장치쪽은 공용 이벤트)
+    BYTE        Buf[BENCH_BUF]; // 상대가 쓴 바이트
+    int         Len;
+    TPipeEnd*   Peer;
+#else
+    int         Fd;
+#endif
+};
+
+#ifdef _WIN32
+static HANDLE g_DevEvent;
+
+static bool PipeOpen(TPipeEnd* host, TPipeEnd* dev)
+{
+    memset(host, 0, sizeof(TPipeEnd));
+    memset(dev, 0, sizeof(TPipeEnd));
+    host->Ev = CreateEvent(NULL, FALSE, FALSE, NULL);
+    dev->Ev = g_DevEvent;
+    host->Peer = dev;
+    dev->Peer = host;
+    return host->Ev != NULL;
+}
+
+static void PipeClose(TPipeEnd* host, TPipeEnd* dev)
+{
+    CloseHandle(host->Ev);
+    (void)dev;
+}
+
+static int PipeWrite(TPipeEnd* p, const BYTE* data, int len)
+{
+    TPipeEnd* q = p->Peer;
+    if (len > BENCH_BUF - q->Len)
+        len = BENCH_BUF - q->Len;
+    memcpy(q->Buf + q->Len, data, len);
+    q->Len += len;
+    SetEvent(q->Ev);
+    return len;
+}
+
+static int PipeRead(TPipeEnd* p, BYTE* data, int cap)
+{
+    int n = (p->Len < cap) ? p->Len : cap;
+    memcpy(data, p->Buf, n);
+    memmove(p->Buf, p->Buf + n, p->Len - n);
+    p->Len -= n;
+    return n;
+}
+
+static TReactorHandle PipeHandle(TPipeEnd* p) { return p->Ev; }
+#else
+static bool PipeOpen(TPipeEnd* host, TPipeEnd* dev)
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+        return false;
+    fcntl(sv[0], F_SETFL, fcntl(sv[0], F_GETFL) | O_NONBLOCK);
+    fcntl(sv[1], F_SETFL, fcntl(sv[1], F_GETFL) | O_NONBLOCK);
+    host->Fd = sv[0];
+    dev->Fd = sv[1];
+    return true;
+}
+
+static void PipeClose(TPipeEnd* host, TPipeEnd* dev)
+{
+    close(host->Fd);
+    close(dev->Fd);
+}
+
+static int PipeWrite(TPipeEnd* p, const BYTE* data, int len)
+{
+    int n = (int)write(p->Fd, data, len);
+    return (n < 0) ? 0 : n;
+}
+
+static int PipeRead(TPipeEnd* p, BYTE* data, int cap)
+{
+    int n = (int)read(p->Fd, data, cap);
+    return (n < 0) ? 0 : n;
+}
+
+static TReactorHandle PipeHandle(TPipeEnd* p) { return p->Fd; }
+#endif
+
+//---------------------------------------------------------------------------
+// 연결 하나
+//---------------------------------------------------------------------------
+struct TEndpoint
+{
+    TPipeEnd    Host;
+    TPipeEnd    Dev;
+
+    // 에이전트쪽
+    BYTE        FrameBuf[BENCH_BUF];
+    TFrameImage Frame;
+    TRxDecoder  Rx;
+    bool        Waiting;
+    TBenchUs    SentUs;
+    long        Value;
+
+    // 장치쪽 (프레임 하나 모일 때까지)
+    BYTE        DevBuf[BENCH_BUF];
+    int         DevLen;
+};
+
+struct TBench
+{
+    TReactor    R;
+    TEndpoint   Ep[BENCH_MAX_EP];
+    int         Count;
+    int         Items;
+    int         ScanId;
+    int         StopId;
+    bool        Stop;
+
+    DWORD       Sent;
+    DWORD       Acked;
+    DWORD       Naks;
+    DWORD       Skipped;        // 응답 대기 중이라 넘긴 주기
+    TBenchUs    LatSum;
+    TBenchUs    LatMax;
+    DWORD       Lat[LAT_BUCKETS];
+};
+
+static TBench g_Bench;
+
+//---------------------------------------------------------------------------
+// 처리 함수
+//---------------------------------------------------------------------------
+static void OnScan(void* ctx)
+{
+    TBench* b = (TBench*)ctx;
+    for (int k = 0; k < b->Count; k++)
+    {
+        TEndpoint* e = &b->Ep[k];
+        if (e->Waiting)
+        {
+            b->Skipped++;
+            continue;
+        }
+
+        e->Value++;
+        FramePatch(&e->Frame, (int)(e->Value % b->Items), 0xC0, e->Value);
+        e->SentUs = NowUs();
+        e->Waiting = true;
+        PipeWrite(&e->Host, e->Frame.Buf, e->Frame.Length);
+        b->Sent++;
+    }
+}
+
+static void OnStop(void* ctx)
+{
+    ((TBench*)ctx)->Stop = true;
+}
+
+// 에이전트쪽 - 응답 꺼내기
+static void OnHostRead(void* ctx)
+{
+    TEndpoint* e = (TEndpoint*)ctx;
+    TBench* b = &g_Bench;
+    BYTE buf[64];
+    int n;
+
+    while ((n = PipeRead(&e->Host, buf, sizeof(buf))) > 0)
+        RxPush(&e->Rx, buf, n);
+
+    TRxEvent ev;
+    while (RxNext(&e->Rx, &ev))
+    {
+        if (!e->Waiting)
+            continue;
+        e->Waiting = false;
+
+        if (ev.Cmd != RESP_CMD_ACK)
+        {
+            b->Naks++;
+            continue;
+        }
+
+        TBenchUs lat = NowUs() - e->SentUs;
+        int slot = (int)(lat / LAT_BUCKET_US);
+        if (slot >= LAT_BUCKETS) slot = LAT_BUCKETS - 1;
+        b->Lat[slot]++;
+        b->LatSum += lat;
+        if (lat > b->LatMax) b->LatMax = lat;
+        b->Acked++;
+    }
+}
+
+// 장치쪽 - 프레임 확인 후 응답
+static void DevService(TEndpoint* e, int frameLen)
+{
+    int n;
+    while ((n = PipeRead(&e->Dev, e->DevBuf + e->DevLen, frameLen - e->DevLen)) > 0)
+    {
+        e->DevLen += n;
+        if (e->DevLen < frameLen)
+            continue;
+
+        const BYTE* f = e->DevBuf;
+        BYTE status = RESP_STATUS_OK;
+        if (f[0] != PROTO_STX || f[frameLen - 1] != PROTO_ETX)
+            status = RESP_STATUS_LEN;
+        else if (ProtoChecksum(f + 1, frameLen - 3) != f[frameLen - 2])
+            status = RESP_STATUS_CHK;
+
+        BYTE cmd = (status == RESP_STATUS_OK) ? RESP_CMD_ACK : RESP_CMD_NAK;
+        BYTE resp[RESP_FRAME_LEN] = { PROTO_STX, cmd, status, (BYTE)(cmd ^ status), PROTO_ETX };
+        PipeWrite(&e->Dev, resp, RESP_FRAME_LEN);
+        e->DevLen = 0;
+    }
+}
+
+#ifdef _WIN32
+static void OnDevRead(void* ctx)
+{
+    TBench* b = (TBench*)ctx;
+    for (int k = 0; k < b->Count; k++)
+        DevService(&b->Ep[k], FRAME_SIZE(b->Items));
+}
+#else
+static void OnDevRead(void* ctx)
+{
+    DevService((TEndpoint*)ctx, FRAME_SIZE(g_Bench.Items));
+}
+#endif
+
+//---------------------------------------------------------------------------
+// 백분위 지연 (칸의 가운데 값, 최대 지연으로 자름)
+//---------------------------------------------------------------------------
+static TBenchUs Percentile(const TBench* b, double p)
+{
+    DWORD want = (DWORD)(b->Acked * p);
+    DWORD sum = 0;
+    TBenchUs us = b->LatMax;
+    for (int k = 0; k < LAT_BUCKETS; k++)
+    {
+        sum += b->Lat[k];
+        if (sum > want)
+        {
+            us = (TBenchUs)k * LAT_BUCKET_US + LAT_BUCKET_US / 2;
+            break;
+        }
+    }
+    return (us < b->LatMax) ? us : b->LatMax;
+}
+
+static bool RunOne(int count, int items, int periodMs, int durationMs)
+{
+    TBench* b = &g_Bench;
+    memset(b, 0, sizeof(TBench));
+    b->Count = count;
+    b->Items = items;
+
+    if (!ReactorInit(&b->R))
+        return false;
+
+#ifdef _WIN32
+    g_DevEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+    ReactorAddHandle(&b->R, g_DevEvent, OnDevRead, b);
+#endif
+
+    for (int k = 0; k < count; k++)
+    {
+        TEndpoint* e = &b->Ep[k];
+        if (!PipeOpen(&e->Host, &e->Dev))
+            return false;
+
+        FrameLayout(&e->Frame, e->FrameBuf, items);
+        for (int s = 0; s < items; s++)
+            FrameSetItem(&e->Frame, s, (WORD)(k * 1000 + s), 0xC0, 0);
+        FrameSeal(&e->Frame);
+        RxReset(&e->Rx);
+
+        if (ReactorAddHandle(&b->R, PipeHandle(&e->Host), OnHostRead, e) < 0)
+            return false;
+#ifndef _WIN32
+        if (ReactorAddHandle(&b->R, PipeHandle(&e->Dev), OnDevRead, e) < 0)
+            return false;
+#endif
+    }
+
+    b->ScanId = ReactorAddTimer(&b->R, OnScan, b);
+    b->StopId = ReactorAddTimer(&b->R, OnStop, b);
+    if (b->ScanId < 0 || b->StopId < 0)
+        return false;
+
+    TBenchUs t0 = NowUs();
+    TBenchUs c0 = CpuUs();
+    ReactorArmTimer(&b->R, b->ScanId, periodMs, periodMs);
+    ReactorArmTimer(&b->R, b->StopId, durationMs, 0);
+
+    while (!b->Stop)
+    {
+        if (ReactorRunOnce(&b->R, REACTOR_INFINITE) < 0)
+            break;
+    }
+
+    TBenchUs wall = NowUs() - t0;
+    TBenchUs cpu = CpuUs() - c0;
+
+    ReactorClose(&b->R);
+    for (int k = 0; k < count; k++)
+        PipeClose(&b->Ep[k].Host, &b->Ep[k].Dev);
+#ifdef _WIN32
+    CloseHandle(g_DevEvent);
+#endif
+
+    double avg = b->Acked ? (double)b->LatSum / b->Acked : 0;
+    printf("%3d %8lu %6lu %8.1f %7ld %7ld %7ld %6.2f %8.0f\n", count,
+           (unsigned long)b->Acked, (unsigned long)b->Skipped, avg,
+           (long)Percentile(b, 0.50), (long)Percentile(b, 0.99), (long)b->LatMax,
+           wall ? cpu * 100.0 / wall : 0, wall ? b->R.Wakeups * 1000000.0 / wall : 0);
+    if (b->Naks)
+        printf("    NAK %lu\n", (unsigned long)b->Naks);
+    return true;
+}
+
+//---------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    int duration = 2000;
+    int period = 10;
+    int items = 50;
+    int only = 0;
+
+    for (int a = 1; a < argc; a++)
+    {
+        if (strcmp(argv[a], "-d") == 0 && a + 1 < argc)      { duration = atoi(argv[++a]); continue; }
+        if (strcmp(argv[a], "-p") == 0 && a + 1 < argc)      { period = atoi(argv[++a]); continue; }
+        if (strcmp(argv[a], "-n") == 0 && a + 1 < argc)      { items = atoi(argv[++a]); continue; }
+        if (strcmp(argv[a], "-e") == 0 && a + 1 < argc)      { only = atoi(argv[++a]); continue; }
+        fprintf(stderr, "usage: ReactorBench [-d ms] [-p ms] [-n items] [-e endpoints]\n");
+        return 1;
+    }
+
+    if (items < 1) items = 1;
+    if (items > BENCH_MAX_ITEMS) items = BENCH_MAX_ITEMS;
+    if (only > BENCH_MAX_EP) only = BENCH_MAX_EP;
+    if (period < 1) period = 1;
+
+    printf("period %d ms, %d items/frame (%d B), %d ms\n", period, items, FRAME_SIZE(items), duration);
+    printf(" EP   frames  skip   avg us  p50 us  p99 us  max us   cpu%%   wake/s\n");
+
+    static const int counts[] = { 1, 8, 32 };
+    for (int k = 0; k < 3; k++)
+    {
+        int n = only ? only : counts[k];
+        if (!RunOne(n, items, period, duration))
+        {
+            fprintf(stderr, "%d endpoints: setup fail\n", n);
+            return 1;
+        }
+        if (only)
+            break;
+    }
+    return 0;
+}
@@ -0,0 +1,117 @@
+//---------------------------------------------------------------------------
+#include "RingLog.h"
+#include <string.h>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+void RingLogInit(TRingLogHdr* h, DWORD dataSize)
+{
+    memset(h, 0, sizeof(TRingLogHdr));
+    h->Magic = RLOG_MAGIC;
+    h->Version = RLOG_VERSION;
+    h->HdrSize = sizeof(TRingLogHdr);
+    h->DataSize = dataSize;
+}
+
+bool RingLogCheck(const TRingLogHdr* h, DWORD dataSize)
+{
+    return h->Magic == RLOG_MAGIC && h->Version == RLOG_VERSION &&
+           h->HdrSize == sizeof(TRingLogHdr) && h->DataSize == dataSize &&
+           h->Head < dataSize;
+}
+
+//---------------------------------------------------------------------------
+void RingLogPut(TRingLogHdr* h, BYTE* data, const char* s, int len)
+{
+    DWORD head = h->Head;
+
+    if (len > (int)h->DataSize)
+    {
+        // 영역보다 긴 줄은 뒷부분만
+        s += len - h->DataSize;
+        len = h->DataSize;
+    }
+
+    DWORD span = h->DataSize - head;
+    if ((DWORD)len < span)
+    {
+        memcpy(data + head, s, len);
+        head += len;
+    }
+    else
+    {
+        memcpy(data + head, s, span);
+        memcpy(data, s + span, len - span);
+        head = len - span;
+        h->Wraps++;
+    }
+
+    h->Head = head;
+}
+
+#ifdef _WIN32
+//---------------------------------------------------------------------------
+// 링 파일 열기 (없거나 크기/형식이 다르면 새로 잡음)
+//---------------------------------------------------------------------------
+bool RingLogOpen(TRingLog* r, const char* path, DWORD dataSize)
+{
+    DWORD total = sizeof(TRingLogHdr) + dataSize;
+
+    r->hMap = NULL;
+    r->Hdr = NULL;
+    r->Data = NULL;
+
+    r->hFile = CreateFile(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                          OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (r->hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    bool fresh = (GetFileSize(r->hFile, NULL) != total);
+    if (fresh)
+    {
+        // 처음부터 전체 크기를 잡아 두므로 이후 디스크 사용량은 변하지 않는다
+        SetFilePointer(r->hFile, total, NULL, FILE_BEGIN);
+        SetEndOfFile(r->hFile);
+    }
+
+    r->hMap = CreateFileMapping(r->hFile, NULL, PAGE_READWRITE, 0, total, NULL);
+    if (r->hMap != NULL)
+        r->Hdr = (TRingLogHdr*)MapViewOfFile(r->hMap, FILE_MAP_WRITE, 0, 0, total);
+
+    if (r->Hdr == NULL)
+    {
+        RingLogClose(r);
+        return false;
+    }
+
+    r->Data = (BYTE*)r->Hdr + sizeof(TRingLogHdr);
+    if (fresh || !RingLogCheck(r->Hdr, dataSize))
+    {
+        RingLogInit(r->Hdr, dataSize);
+        memset(r->Data, 0, dataSize);
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+void RingLogClose(TRingLog* r)
+{
+    if (r->Hdr != NULL)
+    {
+        FlushViewOfFile(r->Hdr, 0);
+        UnmapViewOfFile(r->Hdr);
+        r->Hdr = NULL;
+        r->Data = NULL;
+    }
+    if (r->hMap != NULL)
+    {
+        CloseHandle(r->hMap);
+        r->hMap = NULL;
+    }
+    if (r->hFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(r->hFile);
+        r->hFile = INVALID_HANDLE_VALUE;
+    }
+}
+#endif
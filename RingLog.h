@@ -0,0 +1,50 @@
+//---------------------------------------------------------------------------
+#ifndef RingLogH
+#define RingLogH
+//---------------------------------------------------------------------------
+// 고정 크기 링 로그 (VCL 비의존 - 리눅스에서도 단독 컴파일 가능)
+// 파일 크기를 처음에 잡아 두고 메모리 맵으로 열어, 한 줄 기록은 메모리 복사
+// 뿐이다. 끝에 닿으면 처음으로 돌아가 가장 오래된 줄을 덮어쓴다.
+// 파일: [HDR 64][데이터 DataSize] - 쓰기 위치(Head)는 헤더에 있으므로
+// 프로세스가 죽어도 (맵 페이지는 OS 가 기록) 최근 DataSize 바이트가 남는다.
+//---------------------------------------------------------------------------
+#include "PortTypes.h"
+
+#define RLOG_MAGIC      0x474C5247      // "GRLG"
+#define RLOG_VERSION    1
+#define RLOG_MIN_SIZE   (64 * 1024)
+
+struct TRingLogHdr
+{
+    DWORD   Magic;
+    WORD    Version;
+    WORD    HdrSize;        // sizeof(TRingLogHdr)
+    DWORD   DataSize;       // 데이터 영역 크기
+    DWORD   Head;           // 다음 기록 위치 (데이터 영역 오프셋)
+    DWORD   Wraps;          // 끝에서 처음으로 돌아간 횟수 (0 이면 [0, Head) 만 유효)
+    DWORD   Reserved[11];
+};
+
+void RingLogInit(TRingLogHdr* h, DWORD dataSize);
+bool RingLogCheck(const TRingLogHdr* h, DWORD dataSize);
+
+// 데이터 영역에 len 바이트 추가 (끝을 넘으면 나눠서 처음부터)
+// 내용을 먼저 쓰고 Head 를 나중에 옮기므로 중간에 죽어도 Head 앞은 온전하다.
+void RingLogPut(TRingLogHdr* h, BYTE* data, const char* s, int len);
+
+#ifdef _WIN32
+struct TRingLog
+{
+    HANDLE          hFile;
+    HANDLE          hMap;
+    TRingLogHdr*    Hdr;            // 맵 시작 (NULL 이면 닫힘)
+    BYTE*           Data;
+};
+
+// 파일을 hdr + dataSize 크기로 열어 맵핑. 형식/크기가 다르면 새로 초기화.
+bool RingLogOpen(TRingLog* r, const char* path, DWORD dataSize);
+void RingLogClose(TRingLog* r);
+#endif
+
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,452 @@
+//---------------------------------------------------------------------------
+// 수신 디코더 검사 (콘솔, 오프라인)
+// 빌드: bcc32 RxCheck.cpp EspProto.cpp   (리눅스: g++ -O2 RxCheck.cpp EspProto.cpp)
+//
+// 사용: RxCheck [-v]
+//   -v      통과한 항목도 출력
+//
+// 실제 포트에서 나오는 바이트열을 흉내 내 TRxDecoder(RxPush/RxWriteSpan/RxNext)에
+// 넣고, 응답/명령을 빠짐없이 순서대로 꺼내는지와 재동기 횟수를 확인한다.
+//   잡음      프레임 사이의 쓰레기 바이트 (STX/SOH 없음)
+//   가짜 STX  응답처럼 시작했다가 깨진 바이트, 진짜 프레임과 겹쳐 옴
+//   쪼개짐    한 바이트씩 / 임의 크기로 나뉘어 도착 (응답, 명령 모두)
+//   연속      응답과 명령이 틈 없이 이어서 도착
+//   링 넘김   링버퍼 끝을 넘어 이어지는 프레임, 링이 가득 찬 상태
+//
+// 하나라도 틀리면 종료 코드 1.
+//---------------------------------------------------------------------------
+#include "EspProto.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int  g_Checks = 0;
+static int  g_Fails = 0;
+static bool g_Verbose = false;
+
+static void Check(bool ok, const char* name, int line)
+{
+    g_Checks++;
+    if (!ok)
+        g_Fails++;
+    if (!ok || g_Verbose)
+        printf("%s %s (line %d)\n", ok ? "ok  " : "FAIL", name, line);
+}
+
+#define CHECK(cond)     Check((cond), #cond, __LINE__)
+
+//---------------------------------------------------------------------------
+// 장치쪽 프레임
+//---------------------------------------------------------------------------
+static int PutResp(BYTE* p, BYTE cmd, BYTE status)
+{
+    p[0] = PROTO_STX;
+    p[1] = cmd;
+    p[2] = status;
+    p[3] = (BYTE)(cmd ^ status);
+    p[4] = PROTO_ETX;
+    return RESP_FRAME_LEN;
+}
+
+// FRAME_WRITE 한 개 (SEQ + [ID 2B][VAL 4B])
+static int PutWrite(BYTE* p, BYTE seq, WORD id, long value)
+{
+    BYTE payload[7];
+    payload[0] = seq;
+    payload[1] = (BYTE)(id & 0xFF);
+    payload[2] = (BYTE)(id >> 8);
+    payload[3] = (BYTE)(value & 0xFF);
+    payload[4] = (BYTE)((value >> 8) & 0xFF);
+    payload[5] = (BYTE)((value >> 16) & 0xFF);
+    payload[6] = (BYTE)((value >> 24) & 0xFF);
+    return FrameBuildExt(p, FRAME_WRITE, payload, 7);
+}
+
+//---------------------------------------------------------------------------
+// 꺼낼 수 있는 응답을 모두 꺼냄 (꺼낸 수 반환)
+//---------------------------------------------------------------------------
+static int Drain(TRxDecoder* d, TRxEvent* out, int max)
+{
+    int n = 0;
+    TRxEvent ev;
+    while (RxNext(d, &ev))
+    {
+        if (n < max)
+            out[n] = ev;
+        n++;
+    }
+    return n;
+}
+
+static bool IsAck(const TRxEvent& ev)
+{
+    return ev.Cmd == RESP_CMD_ACK && ev.Status == RESP_STATUS_OK;
+}
+
+//---------------------------------------------------------------------------
+// 잡음: 프레임 앞뒤/사이의 쓰레기는 Dropped 로 세고 응답은 그대로
+//---------------------------------------------------------------------------
+static void CheckJunk(TRxDecoder* d)
+{
+    BYTE buf[256];
+    TRxEvent ev[8];
+    int len = 0;
+
+    static const BYTE junk[] = { 0x00, 0xFF, 0x55, 0xAA, 0x03, 0x7E, 0x80, 0x04 };
+    memcpy(buf + len, junk, sizeof(junk));      len += sizeof(junk);
+    len += PutResp(buf + len, RESP_CMD_ACK, RESP_STATUS_OK);
+    memcpy(buf + len, junk, 3);                 len += 3;
+    len += PutResp(buf + len, RESP_CMD_NAK, RESP_STATUS_CHK);
+    memcpy(buf + len, junk + 4, 4);             len += 4;
+
+    RxReset(d);
+    CHECK(RxPush(d, buf, len) == len);
+    CHECK(Drain(d, ev, 8) == 2);
+    CHECK(IsAck(ev[0]));
+    CHECK(ev[1].Cmd == RESP_CMD_NAK && ev[1].Status == RESP_STATUS_CHK);
+    CHECK(d->Dropped == sizeof(junk) + 3 + 4);
+    CHECK(d->Resyncs == 0);
+    CHECK(d->Frames == 2);
+    CHECK(RxUsed(d) == 0);
+}
+
+//---------------------------------------------------------------------------
+// 가짜 STX: 깨진 응답 머리는 한 바이트씩 버리고, 겹쳐 있는 진짜 프레임은 살린다
+//---------------------------------------------------------------------------
+static void CheckStrayStx(TRxDecoder* d)
+{
+    BYTE buf[256];
+    TRxEvent ev[8];
+    int len = 0;
+
+    // STX + ACK 로 시작했지만 3바이트에서 끊기고 바로 진짜 ACK
+    buf[len++] = PROTO_STX;
+    buf[len++] = RESP_CMD_ACK;
+    buf[len++] = RESP_STATUS_OK;
+    len += PutResp(buf + len, RESP_CMD_ACK, RESP_STATUS_OK);
+
+    // 체크섬이 틀린 응답 (STX 한 바이트만 버리고 나머지는 잡음으로)
+    buf[len++] = PROTO_STX;
+    buf[len++] = RESP_CMD_NAK;
+    buf[len++] = RESP_STATUS_CHK;
+    buf[len++] = 0x00;
+    buf[len++] = PROTO_ETX;
+
+    // 응답 코드가 아닌 CMD
+    buf[len++] = PROTO_STX;
+    buf[len++] = 0x09;
+    buf[len++] = 0x00;
+    buf[len++] = 0x09;
+    buf[len++] = PROTO_ETX;
+
+    // 모르는 명령 종류의 SOH (가짜 SOH)
+    buf[len++] = PROTO_SOH;
+    buf[len++] = 0x7F;
+    buf[len++] = 0x00;
+    buf[len++] = 0x00;
+
+    len += PutResp(buf + len, RESP_CMD_NAK, RESP_STATUS_SCHEMA);
+
+    RxReset(d);
+    CHECK(RxPush(d, buf, len) == len);
+    CHECK(Drain(d, ev, 8) == 2);
+    CHECK(IsAck(ev[0]));
+    CHECK(ev[1].Cmd == RESP_CMD_NAK && ev[1].Status == RESP_STATUS_SCHEMA);
+    CHECK(d->Resyncs >= 4);
+    CHECK(d->Frames == 2);
+    CHECK(RxUsed(d) == 0);
+    CHECK(d->CmdHead == d->CmdTail);
+}
+
+//---------------------------------------------------------------------------
+// 쪼개짐: 마지막 바이트가 올 때까지 보류, 들어온 크기와 관계없이 같은 결과
+//---------------------------------------------------------------------------
+static void CheckSplit(TRxDecoder* d)
+{
+    BYTE buf[256];
+    TRxEvent ev[8];
+    TRxCommand cmd;
+    int len = 0;
+
+    len += PutResp(buf + len, RESP_CMD_ACK, RESP_STATUS_OK);
+    int cmdStart = len;
+    len += PutWrite(buf + len, 0x42, 0x1234, -5);
+    len += PutResp(buf + len, RESP_CMD_NAK, RESP_STATUS_RESYNC);
+
+    // 한 바이트씩: 각 프레임 마지막 바이트 전까지는 아무것도 안 나옴
+    RxReset(d);
+    int got = 0;
+    bool early = false;
+    for (int i = 0; i < len; i++)
+    {
+        RxPush(d, buf + i, 1);
+        int n = Drain(d, ev + got, 8 - got);
+        if (n > 0 && i != RESP_FRAME_LEN - 1 && i != len - 1)
+            early = true;
+        got += n;
+    }
+    CHECK(!early);
+    CHECK(got == 2);
+    CHECK(IsAck(ev[0]));
+    CHECK(ev[1].Cmd == RESP_CMD_NAK && ev[1].Status == RESP_STATUS_RESYNC);
+    CHECK(RxNextCommand(d, &cmd));
+    CHECK(cmd.Type == FRAME_WRITE && cmd.Len == 7 &&
+          memcmp(cmd.Data, buf + cmdStart + EXT_HDR_LEN, 7) == 0);
+    CHECK(!RxNextCommand(d, &cmd));
+    CHECK(d->Resyncs == 0 && d->Dropped == 0);
+
+    // 모든 분할 위치 두 곳 (세 조각)
+    bool same = true;
+    for (int a = 1; a < len - 1; a++)
+    {
+        for (int b = a + 1; b < len; b++)
+        {
+            RxReset(d);
+            RxPush(d, buf, a);
+            got = Drain(d, ev, 8);
+            RxPush(d, buf + a, b - a);
+            got += Drain(d, ev + got, 8 - got);
+            RxPush(d, buf + b, len - b);
+            got += Drain(d, ev + got, 8 - got);
+
+            if (got != 2 || !IsAck(ev[0]) || ev[1].Status != RESP_STATUS_RESYNC ||
+                !RxNextCommand(d, &cmd) || cmd.Len != 7 || d->Resyncs != 0)
+                same = false;
+        }
+    }
+    CHECK(same);
+}
+
+//---------------------------------------------------------------------------
+// 연속: 응답/명령이 틈 없이 이어져도 순서대로, 명령 대기열이 넘치면 버린 수만 센다
+//---------------------------------------------------------------------------
+static void CheckBackToBack(TRxDecoder* d)
+{
+    BYTE buf[512];
+    TRxEvent ev[16];
+    TRxCommand cmd;
+    int len = 0;
+
+    for (int k = 0; k < 6; k++)
+    {
+        len += PutResp(buf + len, RESP_CMD_ACK, RESP_STATUS_OK);
+        len += PutWrite(buf + len, (BYTE)k, (WORD)(100 + k), k * 1000);
+        len += PutResp(buf + len, RESP_CMD_NAK, RESP_STATUS_TMO);
+    }
+
+    RxReset(d);
+    CHECK(RxPush(d, buf, len) == len);
+    int got = Drain(d, ev, 16);
+    CHECK(got == 12);
+
+    bool order = true;
+    for (int k = 0; k < 6 && k * 2 + 1 < got; k++)
+    {
+        if (!IsAck(ev[k * 2]) || ev[k * 2 + 1].Status != RESP_STATUS_TMO)
+            order = false;
+    }
+    CHECK(order);
+
+    // 대기열은 RX_CMD_QUEUE 개 - 앞선 명령부터 남고 나머지는 CmdDropped
+    int cmds = 0;
+    bool seq = true;
+    while (RxNextCommand(d, &cmd))
+    {
+        if (cmd.Data[0] != (BYTE)cmds)
+            seq = false;
+        cmds++;
+    }
+    CHECK(cmds == RX_CMD_QUEUE);
+    CHECK(seq);
+    CHECK(d->CmdDropped == 6 - RX_CMD_QUEUE);
+    CHECK(d->Frames == 18);
+    CHECK(d->Resyncs == 0 && d->Dropped == 0);
+}
+
+//---------------------------------------------------------------------------
+// 링 넘김: 수신 위치를 링 끝 근처부터 바꿔 가며 프레임이 끝을 넘게 한다
+// PumpReceive 처럼 RxWriteSpan 으로 연속 공간만 채우는 경로와 RxPush 경로 모두.
+//---------------------------------------------------------------------------
+static void CheckWrap(TRxDecoder* d)
+{
+    BYTE buf[64];
+    TRxEvent ev[4];
+    TRxCommand cmd;
+
+    int len = 0;
+    len += PutWrite(buf + len, 0x77, 0xBEEF, 0x12345678);
+    len += 2;                                   // 잡음 2바이트
+    buf[len - 2] = 0xEE;
+    buf[len - 1] = PROTO_ETX;
+    len += PutResp(buf + len, RESP_CMD_ACK, RESP_STATUS_OK);
+
+    bool spanOk = true;
+    bool pushOk = true;
+    for (int start = RX_RING_SIZE - len - 1; start <= RX_RING_SIZE + 1; start++)
+    {
+        // 스팬 경로: 링 끝에서 잘리는 만큼 두 번에 나눠 채움
+        RxReset(d);
+        d->Head = d->Tail = (DWORD)start;
+        int done = 0;
+        while (done < len)
+        {
+            BYTE* p;
+            int span = RxWriteSpan(d, &p);
+            int n = (len - done < span) ? len - done : span;
+            memcpy(p, buf + done, n);
+            RxCommit(d, n);
+            done += n;
+        }
+        if (Drain(d, ev, 4) != 1 || !IsAck(ev[0]) || !RxNextCommand(d, &cmd) ||
+            cmd.Data[0] != 0x77 || cmd.Data[3] != 0x78 || cmd.Data[6] != 0x12 ||
+            d->Dropped != 2 || d->Resyncs != 0 || RxUsed(d) != 0)
+            spanOk = false;
+
+        // 복사 경로
+        RxReset(d);
+        d->Head = d->Tail = (DWORD)start;
+        if (RxPush(d, buf, len) != len || Drain(d, ev, 4) != 1 || !RxNextCommand(d, &cmd) ||
+            RxUsed(d) != 0)
+            pushOk = false;
+    }
+    CHECK(spanOk);
+    CHECK(pushOk);
+
+    // 누적 위치가 DWORD 를 넘어가는 경우
+    RxReset(d);
+    d->Head = d->Tail = 0xFFFFFFFE;
+    CHECK(RxPush(d, buf, len) == len);
+    CHECK(Drain(d, ev, 4) == 1 && RxNextCommand(d, &cmd));
+    CHECK(RxUsed(d) == 0);
+
+    // 가득 찬 링: 넘치는 바이트는 받지 않고, 비운 뒤 이어서 받으면 손실 없음
+    BYTE big[RX_RING_SIZE + 64];
+    int bigLen = 0;
+    while (bigLen + RESP_FRAME_LEN <= (int)sizeof(big))
+        bigLen += PutResp(big + bigLen, RESP_CMD_ACK, RESP_STATUS_OK);
+
+    RxReset(d);
+    d->Head = d->Tail = RX_RING_SIZE - 3;
+    int taken = RxPush(d, big, bigLen);
+    CHECK(taken == RX_RING_SIZE);
+    int got = Drain(d, ev, 4);
+    taken += RxPush(d, big + taken, bigLen - taken);
+    got += Drain(d, ev, 4);
+    CHECK(taken == bigLen);
+    CHECK(got == bigLen / RESP_FRAME_LEN);
+    CHECK(d->Resyncs == 0 && d->Dropped == 0 && RxUsed(d) == 0);
+}
+
+//---------------------------------------------------------------------------
+// 섞어서 오래: 잡음/가짜 STX/쪼개짐을 난수로 섞어도 진짜 프레임은 하나도 잃지 않음
+// (잡음에는 STX/SOH 를 넣지 않는다 - 잡음이 우연히 유효 프레임이 되는 경우 제외)
+//---------------------------------------------------------------------------
+static void CheckSoak(TRxDecoder* d)
+{
+    BYTE buf[64];
+    TRxEvent ev[64];
+    TRxCommand cmd;
+    int sentResp = 0, gotResp = 0;
+    int sentCmd = 0, gotCmd = 0;
+    bool order = true;
+
+    srand(12345);
+    RxReset(d);
+
+    for (int round = 0; round < 20000; round++)
+    {
+        int len = 0;
+        int kind = rand() % 4;
+
+        if (kind == 0)
+        {
+            int n = 1 + rand() % 6;
+            for (int i = 0; i < n; i++)
+            {
+                BYTE b = (BYTE)rand();
+                buf[len++] = (b == PROTO_STX || b == PROTO_SOH) ? 0x00 : b;
+            }
+        }
+        else if (kind == 1)
+        {
+            // 끊긴 응답 머리 (STX + 1~3바이트, ETX 자리에 다른 값)
+            buf[len++] = PROTO_STX;
+            int n = 1 + rand() % 3;
+            for (int i = 0; i < n; i++)
+                buf[len++] = 0x10;
+        }
+        else if (kind == 2)
+        {
+            len += PutResp(buf, RESP_CMD_ACK, (BYTE)(sentResp & 0x03));
+            sentResp++;
+        }
+        else
+        {
+            len += PutWrite(buf, (BYTE)sentCmd, (WORD)sentCmd, sentCmd);
+            sentCmd++;
+        }
+
+        // 임의 크기로 나눠 넣고 매번 꺼냄 (포트 읽기 한 번 = 조각 하나)
+        int done = 0;
+        while (done < len)
+        {
+            int n = 1 + rand() % (len - done);
+            RxPush(d, buf + done, n);
+            done += n;
+
+            int got = Drain(d, ev, 64);
+            for (int i = 0; i < got; i++)
+            {
+                if (ev[i].Status != (BYTE)(gotResp & 0x03))
+                    order = false;
+                gotResp++;
+            }
+            while (RxNextCommand(d, &cmd))
+            {
+                if (cmd.Data[0] != (BYTE)gotCmd)
+                    order = false;
+                gotCmd++;
+            }
+        }
+    }
+
+    // 끝에 남은 끊긴 머리 밀어내기
+    BYTE pad[RESP_FRAME_LEN] = { 0, 0, 0, 0, 0 };
+    RxPush(d, pad, sizeof(pad));
+    gotResp += Drain(d, ev, 64);
+
+    CHECK(gotResp == sentResp);
+    CHECK(gotCmd == sentCmd);
+    CHECK(order);
+    CHECK(d->CmdDropped == 0);
+    if (g_Verbose)
+        printf("     soak: resp %d cmd %d resync %u dropped %u\n",
+               gotResp, gotCmd, (unsigned)d->Resyncs, (unsigned)d->Dropped);
+}
+
+//---------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-v") == 0)
+            g_Verbose = true;
+        else
+        {
+            printf("usage: RxCheck [-v]\n");
+            return 2;
+        }
+    }
+
+    static TRxDecoder d;        // 링 + 명령 대기열 - 스택에 두지 않음
+
+    CheckJunk(&d);
+    CheckStrayStx(&d);
+    CheckSplit(&d);
+    CheckBackToBack(&d);
+    CheckWrap(&d);
+    CheckSoak(&d);
+
+    printf("RxCheck: %d checks, %d failed\n", g_Checks, g_Fails);
+    return (g_Fails == 0) ? 0 : 1;
+}
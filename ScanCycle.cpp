@@ -0,0 +1,272 @@
+//---------------------------------------------------------------------------
+#include "ScanCycle.h"
+#include <stdio.h>
+#include <string.h>
+
+//---------------------------------------------------------------------------
+// Quality 코드 변환
+//---------------------------------------------------------------------------
+BYTE CycleQualityCode(long quality)
+{
+    int majorQuality = quality & 0xC0;
+
+    if (majorQuality == 0xC0) return 0;   // Good
+    else if (majorQuality == 0x40) return 1;   // Uncertain
+    else
+    {
+        switch (quality)
+        {
+            case 0x08: return 2;    // Not Connected
+            case 0x18: return 3;    // Comm Failure
+            case 0x0C: return 4;    // Device Failure
+            case 0x10: return 5;    // Sensor Failure
+            default:   return 9;    // Other Error
+        }
+    }
+}
+
+LONGLONG CycleOleToUnixMs(double date)
+{
+    // OLE DATE (1899-12-30 기준, 일) -> Unix (1970-01-01 기준, ms)
+    return (LONGLONG)((date - 25569.0) * 86400000.0 + 0.5);
+}
+
+//---------------------------------------------------------------------------
+void CyclePublish(TCycleItem* item, bool hasValue, long raw, long quality, double srcTime)
+{
+    if (hasValue)
+        item->RawValue = raw;
+    item->Quality = quality;
+    item->SrcTime = srcTime;
+    item->Dirty = true;
+}
+
+//---------------------------------------------------------------------------
+// 값/품질이 바뀌었거나 원본 시각만 바뀌었으면 새 샘플 (묶음 전송용)
+// 변경 수는 값/품질 기준 - 읽을 때마다 시각을 찍는 서버는 시각만 늘 바뀐다
+//---------------------------------------------------------------------------
+int CycleMerge(TCycleItem* item, LONGLONG nowMs)
+{
+    if (!item->Dirty)
+        return 0;
+
+    long value = item->RawValue;
+    BYTE qcode = CycleQualityCode(item->Quality);
+    LONGLONG t = (item->SrcTime > 0) ? CycleOleToUnixMs(item->SrcTime) : nowMs;
+
+    int r = 0;
+    if (value != item->Value || qcode != item->QCode)
+        r = CYCLE_CHANGED | CYCLE_SAMPLE;
+    else if (t != item->TimeMs)
+        r = CYCLE_SAMPLE;
+
+    item->Value = value;
+    item->QCode = qcode;
+    item->TimeMs = t;
+    item->Dirty = false;
+    return r;
+}
+
+//---------------------------------------------------------------------------
+// 새 샘플을 포트별 전송 대기열에 넣기
+// 일반 포트는 슬롯 한 칸 (값은 이미 프레임 이미지에 패치됨) - 대기 중이던 슬롯이면
+// 합친 것으로 센다. 묶음 포트는 슬롯이 가득 차면 가장 오래된 샘플을 버리고 센다.
+//---------------------------------------------------------------------------
+bool LinkCapture(TCycleLink* L, int slot, const TCycleItem* item, DWORD now)
+{
+    bool merged = (L->Batch <= 0 && L->Queued[slot] > 0) ||
+                  (L->Batch > 0 && L->SampleCount[slot] >= L->Batch);
+
+    if (L->Queued[slot] == 0)
+        L->QueueDepth++;
+    if (L->Queued[slot] < 0xFFFF)
+        L->Queued[slot]++;
+    if (merged)
+        L->Merged++;
+
+    if (L->Batch <= 0)
+        return merged;
+
+    TBatchSample* s = L->Samples[slot];
+    int n = L->SampleCount[slot];
+    if (n >= L->Batch)
+    {
+        memmove(&s[0], &s[1], (n - 1) * sizeof(TBatchSample));
+        n--;
+        L->SampleTotal--;
+    }
+
+    s[n].TimeMs = item->TimeMs;
+    s[n].Value = item->Value;
+    s[n].QCode = item->QCode;
+    L->SampleCount[slot] = (BYTE)(n + 1);
+
+    if (L->SampleTotal++ == 0)
+        L->BatchTick = now;
+    if (n + 1 >= L->Batch)
+        L->BatchFull = true;
+
+    return merged;
+}
+
+//---------------------------------------------------------------------------
+void LinkClearSamples(TCycleLink* L)
+{
+    memset(L->SampleCount, 0, sizeof(L->SampleCount));
+    L->SampleTotal = 0;
+    L->BatchFull = false;
+    LinkClearQueue(L);
+}
+
+void LinkClearQueue(TCycleLink* L)
+{
+    memset(L->Queued, 0, sizeof(L->Queued));
+    L->QueueDepth = 0;
+    L->Merged = 0;
+}
+
+//---------------------------------------------------------------------------
+// 프레임 이미지의 슬롯 Q / 값 (VAL 4바이트, Little Endian)
+// 프레임은 읽기마다 패치되므로 아이템 사본의 QCode / Value 와 같다.
+//---------------------------------------------------------------------------
+static BYTE FrameQCode(const TFrameImage* f, int slot)
+{
+    return f->Buf[f->ItemOfs + slot * f->Stride + f->QOfs];
+}
+
+static long FrameValue(const TFrameImage* f, int slot)
+{
+    const BYTE* p = f->Buf + f->ItemOfs + slot * f->Stride + f->QOfs + 1;
+    return (long)((DWORD)p[0] | ((DWORD)p[1] << 8) | ((DWORD)p[2] << 16) | ((DWORD)p[3] << 24));
+}
+
+//---------------------------------------------------------------------------
+// 값 변경 여부 확인 (포트별 마지막 ACK 기준, 프레임에 실리는 슬롯만)
+// 품질만 바뀐 슬롯 (통신 실패 표시 / 복구) 도 변경으로 센다 - 생존 확인
+// 다이제스트가 Q 까지 덮으므로 여기서 빠지면 ESP32 가 RESYNC 로 어긋남을 알린다.
+//---------------------------------------------------------------------------
+int LinkChanges(const TCycleLink* L)
+{
+    int changes = 0;
+    for (int k = 0; k < L->Frame.Count; k++)
+    {
+        if (FrameValue(&L->Frame, k) != L->AckValue[k] || FrameQCode(&L->Frame, k) != L->AckQCode[k])
+            changes++;
+    }
+    return changes;
+}
+
+//---------------------------------------------------------------------------
+// 다중 샘플 프레임 생성
+// payload 를 프레임 자리(EXT_HDR_LEN 뒤)에 바로 쓰고 헤더/체크섬만 붙인다.
+// 기준 시각은 각 아이템 첫 샘플 중 가장 이른 시각
+//---------------------------------------------------------------------------
+int LinkBuildBatch(TCycleLink* L, BYTE* frame, int* samples)
+{
+    BYTE* payload = frame + EXT_HDR_LEN;
+    LONGLONG baseMs = 0;
+    bool first = true;
+
+    for (int k = 0; k < L->SlotCount; k++)
+    {
+        if (L->SampleCount[k] > 0 && (first || L->Samples[k][0].TimeMs < baseMs))
+        {
+            baseMs = L->Samples[k][0].TimeMs;
+            first = false;
+        }
+    }
+
+    int pos = BATCH_HDR_LEN;
+    int items = 0;
+    *samples = 0;
+
+    for (int k = 0; k < L->SlotCount; k++)
+    {
+        int n = L->SampleCount[k];
+        if (n == 0)
+            continue;
+
+        pos += BatchPutItem(payload + pos, L->SlotID[k], n);
+
+        LONGLONG prev = baseMs;
+        for (int j = 0; j < n; j++)
+        {
+            TBatchSample* s = &L->Samples[k][j];
+            LONGLONG dt = s->TimeMs - prev;
+            if (dt < 0) dt = 0;                 // 서버 시각 역행은 0 으로
+            if (dt > 0xFFFFFFFF) dt = 0xFFFFFFFF;
+            if (s->TimeMs > prev) prev = s->TimeMs;
+
+            pos += BatchPutSample(payload + pos, (DWORD)dt, s->QCode, s->Value);
+        }
+
+        items++;
+        *samples += n;
+    }
+
+    BatchSeal(payload, baseMs, items);
+    return FrameBuildExt(frame, FRAME_BATCH, payload, pos);
+}
+
+//---------------------------------------------------------------------------
+void LinkSent(TCycleLink* L, int len, int rawLen, int changes, int samples,
+              bool heartbeat, bool keepalive, DWORD now)
+{
+    L->WaitingAck = true;
+    L->SendTick = now;
+    L->TxLen = len;
+    L->TxRawLen = rawLen;
+    L->TxChanges = changes;
+    L->TxMerged = keepalive ? 0 : L->Merged;
+    L->TxHeartbeat = heartbeat;
+    L->TxSamples = samples;
+    L->TxKeepalive = keepalive;
+    L->LastResp.Cmd = 0;
+    L->LastResp.Status = RESP_STATUS_TMO;
+}
+
+//---------------------------------------------------------------------------
+// 전송 성공 - 생존 확인이 아니면 보낸 값이 ESP32 에 있음
+//---------------------------------------------------------------------------
+void LinkAcked(TCycleLink* L)
+{
+    L->WaitingAck = false;
+    if (L->TxKeepalive)
+        return;
+
+    for (int k = 0; k < L->Frame.Count; k++)
+    {
+        L->AckValue[k] = FrameValue(&L->Frame, k);
+        L->AckQCode[k] = FrameQCode(&L->Frame, k);
+    }
+    if (L->TxSamples > 0)
+        LinkClearSamples(L);
+    else
+        L->Resync = false;      // 전체 데이터가 전달됨
+    if (L->Batch <= 0)
+        LinkClearQueue(L);      // 대기 슬롯의 최신 값이 모두 전달됨
+}
+
+//---------------------------------------------------------------------------
+// 컴팩트 로그 (주기마다 남으므로 String 임시 객체 없이 호출측 버퍼에)
+//---------------------------------------------------------------------------
+int LinkFormatResult(char* p, const TCycleLink* L, bool ok)
+{
+    int len = 0;
+    p[len++] = L->TxKeepalive ? 'K' : (L->TxSamples > 0 ? 'B' : 'D');
+    if (L->TxHeartbeat && !L->TxKeepalive) len += sprintf(p + len, "(HB)");
+    len += sprintf(p + len, ":%d", L->SlotCount);
+    if (L->TxChanges > 0) len += sprintf(p + len, "(C:%d)", L->TxChanges);
+    if (L->TxMerged > 0 && !L->TxKeepalive) len += sprintf(p + len, "(M:%d)", (int)L->TxMerged);
+    if (L->TxSamples > 0) len += sprintf(p + len, "(S:%d)", L->TxSamples);
+    len += sprintf(p + len, " TX:%d", L->TxLen);
+    if (L->TxRawLen > 0) len += sprintf(p + len, "(Z:%d)", L->TxRawLen);
+
+    if (ok)
+        len += sprintf(p + len, " OK");
+    else if (L->LastResp.Cmd == RESP_CMD_NAK)
+        len += sprintf(p + len, " FAIL(N:%d)", (int)L->LastResp.Status);
+    else
+        len += sprintf(p + len, " FAIL");
+    return len;
+}
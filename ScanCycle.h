@@ -0,0 +1,128 @@
+//---------------------------------------------------------------------------
+#ifndef ScanCycleH
+#define ScanCycleH
+//---------------------------------------------------------------------------
+// 정상 수집 주기 (VCL 비의존 - 리눅스에서도 단독 컴파일 가능)
+// 읽기 반영 -> 변경 감지 -> 프레임 패치 -> 전송 대기열/묶음 샘플 -> 응답 처리
+// -> 결과 로그 한 줄. 에이전트와 할당 검사 도구(CycleCheck)가 같은 함수를 쓴다.
+// 주기마다 도는 경로라 힙을 쓰지 않는다 (버퍼는 모두 구조체/호출측 소유).
+//---------------------------------------------------------------------------
+#include "PortTypes.h"
+#include "EspProto.h"
+
+#define MAX_OPC_ITEMS   500
+#define MAX_ESP_LINKS   8       // 출력 포트 최대 수 ([Communication] + [Port2]~[Port8])
+
+// 아이템 수집 상태 (TOPCItemInfo 의 주기 부분)
+struct TCycleItem
+{
+    // 작업자 스레드가 갱신 (호출측 잠금)
+    // 값은 읽은 자리에서 long 으로 바꿔 둔다 (VARIANT/BSTR 사본을 두지 않음)
+    long        RawValue;
+    long        Quality;
+    bool        Dirty;          // 메인 스레드 반영 대기
+    double      SrcTime;        // 원본 시각 (OPC 타임스탬프, OLE DATE UTC, 0 = 모름)
+
+    // 메인 스레드 사본 (CycleMerge 에서 갱신, 프레임/변경 감지용)
+    long        Value;
+    BYTE        QCode;
+    LONGLONG    TimeMs;         // 마지막 샘플 시각 (Unix ms)
+
+    short       LinkSlot[MAX_ESP_LINKS];    // 포트별 프레임 슬롯 (-1: 해당 포트로 보내지 않음)
+};
+
+// CycleMerge 결과
+#define CYCLE_CHANGED   0x01    // 값/품질이 바뀜 (변경 수 - 적응 주기/지표)
+#define CYCLE_SAMPLE    0x02    // 새 샘플 (값/품질 또는 원본 시각만 - 묶음 전송/기록)
+
+// 묶음 전송 대기 샘플
+struct TBatchSample
+{
+    LONGLONG    TimeMs;         // 원본 시각 (Unix ms)
+    long        Value;
+    BYTE        QCode;
+};
+
+// 포트 전송 상태 (TEspLink 의 주기 부분)
+struct TCycleLink
+{
+    // 아이템 부분집합 (슬롯 -> 아이템 테이블 인덱스)
+    int         SlotCount;
+    int         Slots[MAX_OPC_ITEMS];
+    WORD        SlotID[MAX_OPC_ITEMS];      // 슬롯의 ItemID (프레임 배치 때 기록)
+    long        AckValue[MAX_OPC_ITEMS];    // 마지막으로 ACK 받은 값 (변경 감지 기준)
+    BYTE        AckQCode[MAX_OPC_ITEMS];    // 마지막으로 ACK 받은 Q 코드 (품질만 바뀌어도 변경)
+
+    // 프레임
+    BYTE        FrameBuf[FRAME_SIZE(MAX_OPC_ITEMS)];
+    TFrameImage Frame;              // 미리 배치된 전송 프레임 (증분 패치)
+
+    // 다중 샘플 묶음 전송 (Batch > 0 인 포트)
+    // 새 샘플은 슬롯별로 쌓아 두었다가 Batch 개가 찬 슬롯이 생기거나 첫 샘플 후
+    // BatchMs 가 지나면 FRAME_BATCH 하나로 보낸다. ACK 전까지는 보관한다.
+    int         Batch;              // 아이템당 묶을 샘플 수 (0: 사용 안 함, 최대 BATCH_MAX)
+    DWORD       BatchMs;            // 최대 지연 (ms)
+    DWORD       BatchTick;          // 첫 샘플을 담은 시각
+    bool        BatchFull;
+    int         SampleTotal;
+    BYTE        SampleCount[MAX_OPC_ITEMS];
+    TBatchSample Samples[MAX_OPC_ITEMS][BATCH_MAX];
+
+    // 전송 대기열 (슬롯마다 한 칸, 최신 값 우선)
+    // ACK 전에 같은 슬롯에 새 샘플이 오면 프레임 이미지의 값을 덮어쓰고 (묶음 포트는
+    // 가장 오래된 샘플을 버리고) 합친 수만 센다. 칸 수가 슬롯 수로 정해지므로
+    // 링크가 느리거나 끊긴 시간이 길어도 메모리는 늘지 않는다.
+    WORD        Queued[MAX_OPC_ITEMS];  // 슬롯별 ACK 대기 샘플 수 (합친 것 포함, 0: 대기 없음)
+    int         QueueDepth;         // 대기 중인 슬롯 수
+    DWORD       Merged;             // 마지막 ACK 이후 합친 샘플 수
+
+    // 전송/응답 상태
+    bool        WaitingAck;
+    DWORD       SendTick;           // 응답 대기 시작 시간
+    int         TxLen;              // 대기 중인 전송 바이트 수 (로그용)
+    int         TxRawLen;           // 압축 전 길이 (압축 안 했으면 0)
+    int         TxChanges;
+    DWORD       TxMerged;           // 이 프레임에 합쳐진 샘플 수 (로그용)
+    bool        TxHeartbeat;
+    int         TxSamples;          // 묶음 전송의 샘플 수 (0: 일반 프레임)
+    bool        TxKeepalive;        // 생존 확인 프레임 (값 없음)
+    bool        Resync;             // ESP32 가 전체 데이터를 요청함 (다이제스트 불일치 / FRAME_RESYNC)
+    TRxDecoder  Rx;                 // 수신 스트림 디코더
+    TRxEvent    LastResp;           // 마지막 응답 (Cmd=0 이면 타임아웃)
+};
+
+// OPC 품질 -> 프레임 Q 코드 / OLE DATE -> Unix ms
+BYTE     CycleQualityCode(long quality);
+LONGLONG CycleOleToUnixMs(double date);
+
+// 작업자 읽기 기록 (hasValue 가 false 면 품질/시각만)
+void CyclePublish(TCycleItem* item, bool hasValue, long raw, long quality, double srcTime);
+
+// 읽기를 메인 스레드 사본에 반영 (CYCLE_xxx 반환, 0 이면 샘플 아님)
+// 프레임 패치(FramePatch)와 샘플(LinkCapture)은 포트마다 호출측에서
+int  CycleMerge(TCycleItem* item, LONGLONG nowMs);
+
+// 새 샘플을 포트 슬롯 대기열에 (합쳐졌으면 true)
+bool LinkCapture(TCycleLink* L, int slot, const TCycleItem* item, DWORD now);
+void LinkClearSamples(TCycleLink* L);
+void LinkClearQueue(TCycleLink* L);
+
+// 프레임의 값 또는 Q 코드가 마지막 ACK 와 다른 슬롯 수
+int  LinkChanges(const TCycleLink* L);
+
+// 묶음 프레임 생성 (frame 은 BATCH_SIZE(SlotCount) 이상, 전체 길이 반환)
+int  LinkBuildBatch(TCycleLink* L, BYTE* frame, int* samples);
+
+// 전송 직후 응답 대기로 (로그용 전송 정보 기록)
+void LinkSent(TCycleLink* L, int len, int rawLen, int changes, int samples,
+              bool heartbeat, bool keepalive, DWORD now);
+
+// 응답 처리: ACK 면 ACK 기준값/대기열 갱신
+void LinkAcked(TCycleLink* L);
+
+// 결과 로그 (포트 접두어 뒤, 길이 반환 - p 는 96바이트 이상)
+// 형식: D:5 TX:43 OK / D(HB):5 TX:43 OK / D:5(C:2) TX:43 FAIL / K:5 TX:12 FAIL(N:5)
+int  LinkFormatResult(char* p, const TCycleLink* L, bool ok);
+
+//---------------------------------------------------------------------------
+#endif
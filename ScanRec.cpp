@@ -0,0 +1,144 @@
+//---------------------------------------------------------------------------
+#include "ScanRec.h"
+#include <string.h>
+//---------------------------------------------------------------------------
+
+#ifdef _WIN32
+typedef unsigned __int64    TVarint;
+#else
+typedef unsigned long long  TVarint;
+#endif
+
+static int PutVarint(BYTE* p, TVarint v)
+{
+    int pos = 0;
+    while (v >= 0x80)
+    {
+        p[pos++] = (BYTE)((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    p[pos++] = (BYTE)v;
+    return pos;
+}
+
+static int PutZigzag(BYTE* p, LONGLONG v)
+{
+    return PutVarint(p, ((TVarint)v << 1) ^ (TVarint)(v >> 63));
+}
+
+// 읽은 바이트 수 (0: 데이터 부족 또는 10바이트 초과)
+static int GetVarint(const BYTE* p, int len, TVarint* v)
+{
+    TVarint r = 0;
+    for (int i = 0; i < len && i < 10; i++)
+    {
+        r |= (TVarint)(p[i] & 0x7F) << (7 * i);
+        if ((p[i] & 0x80) == 0)
+        {
+            *v = r;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+static int GetZigzag(const BYTE* p, int len, LONGLONG* v)
+{
+    TVarint u;
+    int n = GetVarint(p, len, &u);
+    *v = (LONGLONG)(u >> 1) ^ -(LONGLONG)(u & 1);
+    return n;
+}
+
+//---------------------------------------------------------------------------
+void ScanRecHeader(TScanRecHdr* h, LONGLONG startMs)
+{
+    h->Magic = SREC_MAGIC;
+    h->Version = SREC_VERSION;
+    h->Reserved = 0;
+    h->StartMs = startMs;
+}
+
+bool ScanRecCheck(const TScanRecHdr* h)
+{
+    return h->Magic == SREC_MAGIC && h->Version == SREC_VERSION;
+}
+
+//---------------------------------------------------------------------------
+// 주기 기록 - 길이 자리(5바이트)를 띄워 두고 본문을 쓴 뒤 실제 길이에 맞춰 당긴다
+//---------------------------------------------------------------------------
+int ScanRecPutCycle(BYTE* out, LONGLONG* clock, LONGLONG nowMs, const TScanSample* s, int n)
+{
+    BYTE* body = out + 5;
+    LONGLONG dt = nowMs - *clock;
+    if (dt < 0) dt = 0;     // 시계가 뒤로 가면 같은 시각으로
+
+    int pos = PutVarint(body, (TVarint)dt);
+    pos += PutVarint(body + pos, (TVarint)n);
+
+    for (int k = 0; k < n; k++)
+    {
+        pos += PutVarint(body + pos, (TVarint)(DWORD)s[k].ItemID);
+        pos += PutZigzag(body + pos, s[k].Value);
+        body[pos++] = s[k].QCode;
+        pos += PutZigzag(body + pos, s[k].TimeMs - nowMs);
+    }
+
+    *clock += dt;
+
+    BYTE lenBuf[5];
+    int head = PutVarint(lenBuf, (TVarint)pos);
+    memmove(out + head, body, pos);
+    memcpy(out, lenBuf, head);
+    return head + pos;
+}
+
+//---------------------------------------------------------------------------
+int ScanRecGetCycle(const BYTE* in, int len, LONGLONG* clock, DWORD* dt,
+                    TScanSample* s, int max, int* n)
+{
+    TVarint v;
+    int head = GetVarint(in, len, &v);
+    if (head == 0)
+        return (len < 5) ? 0 : -1;
+    if (v > (TVarint)(len - head))
+        return 0;
+
+    const BYTE* p = in + head;
+    int bodyLen = (int)v;
+    int pos = 0;
+    int r;
+
+    if ((r = GetVarint(p, bodyLen, &v)) == 0) return -1;
+    pos += r;
+    *dt = (DWORD)v;
+    LONGLONG cycleMs = *clock + (LONGLONG)v;
+
+    if ((r = GetVarint(p + pos, bodyLen - pos, &v)) == 0 || v > (TVarint)max) return -1;
+    pos += r;
+    int count = (int)v;
+
+    for (int k = 0; k < count; k++)
+    {
+        LONGLONG value, tofs;
+
+        if ((r = GetVarint(p + pos, bodyLen - pos, &v)) == 0) return -1;
+        pos += r;
+        s[k].ItemID = (long)(DWORD)v;
+
+        if ((r = GetZigzag(p + pos, bodyLen - pos, &value)) == 0) return -1;
+        pos += r;
+        s[k].Value = (long)value;
+
+        if (pos >= bodyLen) return -1;
+        s[k].QCode = p[pos++];
+
+        if ((r = GetZigzag(p + pos, bodyLen - pos, &tofs)) == 0) return -1;
+        pos += r;
+        s[k].TimeMs = cycleMs + tofs;
+    }
+
+    *clock = cycleMs;
+    *n = count;
+    return head + bodyLen;
+}
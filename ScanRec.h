@@ -0,0 +1,51 @@
+//---------------------------------------------------------------------------
+#ifndef ScanRecH
+#define ScanRecH
+//---------------------------------------------------------------------------
+// 수집 기록 (VCL 비의존 - 리눅스에서도 단독 컴파일 가능)
+// 매 주기 MergeItems 가 만든 샘플(값/품질/원본 시각)을 그대로 남겨 두었다가
+// 재생 모드에서 같은 순서/간격으로 변경 감지 -> 프레임 -> 시리얼 경로에 다시 넣는다.
+//
+// 파일: [HDR 16][주기][주기]...
+// 주기: [LEN varint][DT varint][N varint] N x [ID varint][VAL zigzag][Q 1B][TOFS zigzag]
+//   LEN  - 이 주기 나머지 바이트 수 (잘린 마지막 주기 확인용)
+//   DT   - 이전 주기부터 ms (첫 주기는 HDR StartMs 부터)
+//   TOFS - 원본 시각 - 주기 시각 (ms)
+//---------------------------------------------------------------------------
+#include "PortTypes.h"
+
+#define SREC_MAGIC      0x43455247      // "GREC"
+#define SREC_VERSION    1
+
+struct TScanRecHdr
+{
+    DWORD       Magic;
+    WORD        Version;
+    WORD        Reserved;
+    LONGLONG    StartMs;        // 기록 시작 시각 (Unix ms)
+};
+
+struct TScanSample
+{
+    long        ItemID;
+    long        Value;
+    BYTE        QCode;
+    LONGLONG    TimeMs;         // 원본 시각 (Unix ms)
+};
+
+// 주기 하나의 최대 길이 (샘플당 ID 5 + 값 5 + 품질 1 + 시각 10, 머리 LEN 5 + DT 10 + N 5)
+#define SREC_CYCLE_SIZE(n)  (20 + (n) * 21)
+
+void ScanRecHeader(TScanRecHdr* h, LONGLONG startMs);
+bool ScanRecCheck(const TScanRecHdr* h);
+
+// 주기 기록 - *clock 은 직전 주기 시각 (갱신됨), 기록한 바이트 수 반환
+int  ScanRecPutCycle(BYTE* out, LONGLONG* clock, LONGLONG nowMs, const TScanSample* s, int n);
+
+// 주기 읽기 - 읽은 바이트 수 반환 (0: 남은 데이터가 주기 하나에 못 미침, -1: 손상)
+// *dt 는 이전 주기부터 ms, 샘플이 max 를 넘으면 손상으로 본다
+int  ScanRecGetCycle(const BYTE* in, int len, LONGLONG* clock, DWORD* dt,
+                     TScanSample* s, int max, int* n);
+
+//---------------------------------------------------------------------------
+#endif
@@ -1,5 +1,9 @@
 //---------------------------------------------------------------------------
 #include "SvcController.h"
+#include "OpcWorker.h"
+#include "PortSupervisor.h"
+#include "CsvScan.h"
+#include "MetricsServer.h"
 #include <utilcls.h>
 #include <stdio.h>
 #include <objbase.h>
@@ -12,10 +16,10 @@
 
 
 //=============================================================================
-// α  
+// 로그 출력 비교
 //=============================================================================
 /*
-===   ( 200/) ===
+=== 변경 전 (약 200자/줄) ===
 [2026-01-18 10:00:00] Data: [1:0,100] [2:0,200] [3:0,300] [4:0,400] [5:0,500]
 [2026-01-18 10:00:00] TX[43]: 02 28 00 05 01 00 00 39 30 00 00 02 00 00 C8 ...
 [2026-01-18 10:00:00] Response: ACK OK
@@ -23,27 +27,62 @@
 [2026-01-18 10:00:05] TX[43]: 02 28 00 05 01 00 00 39 30 00 00 02 00 00 C8 ...
 [2026-01-18 10:00:05] Response: ACK OK
 
-===   ( 25/,  87% ) ===
+=== 변경 후 (약 25자/줄, 약 87% 감소) ===
 [10:00:00] D:5 TX:43 OK
 [10:00:05] D:5(C:2) TX:43 OK
 [10:01:00] D(HB):5 TX:43 OK
 [10:01:05] D:5 TX:43 FAIL
 [10:01:10] E:Serial not ready
 
-=== α   ===
-D:5         -  , 5 
-D(HB):5     - Heartbeat , 5   
-D:5(C:2)    -  , 5  2 
-TX:43       -  Ʈ 
-OK          -   (ACK )
-FAIL        -   (NAK Ǵ ŸӾƿ)
-E:޽    - 
+=== 이진 로그 ([Agent] BinLog=1) ===
+D/B/WR 줄은 logbin_YYYYMMDD.bin 에 16바이트 레코드로 남고 (BinLog.h),
+나머지 이벤트는 그대로 텍스트 로그에 남는다. 텍스트 변환:
+  BinLogDump logbin_20260118.bin                -> 아래와 같은 형식
+  BinLogDump -e -f 09:00 -t 18:00 logbin_*.bin  -> 시간대 안의 실패만
+
+=== 텍스트 로그 파일 ===
+logsave.ring - 고정 크기 링 ([Agent] LogSizeKB, 기본 4096) - 가득 차면 가장 오래된 줄부터 덮어씀
+  BinLogDump logsave.ring                       -> 오래된 줄부터 순서대로 출력
+
+=== 로그 형식 설명 ===
+D:5         - 데이터 전송, 5개 아이템
+D(HB):5     - Heartbeat 전송, 5개 아이템  
+K:5         - 생존 확인 (Keepalive 포트, 값이 그대로일 때 전체 프레임 대신 SEQ + 다이제스트 12바이트)
+K:5 TX:12 FAIL(N:5)     - ESP32 값과 다이제스트 불일치 -> 다음 주기에 전체 데이터
+RESYNC      - ESP32 가 전체 데이터 요청 (FRAME_RESYNC)
+D:5(C:2)    - 데이터 전송, 5개 중 2개 변경됨
+D:5(C:2)(M:7)           - ACK 전에 같은 아이템의 샘플 7개가 최신 값으로 합쳐짐 (링크가 느리거나 끊겼던 동안)
+A:2 TX:20 L:3.1ms       - 우선 전송 (CSV Priority=1 아이템 2개 변경, 작업자 읽기부터 송신까지 지연)
+WR 3 OK:3 T:14.2ms      - ESP32 쓰기 명령 (아이템 3개 중 3개 성공, 수신부터 OPC 쓰기 완료까지)
+B:5(S:23)   - 다중 샘플 묶음 전송 (Batch=n 포트), 5개 아이템의 샘플 23개
+TX:43       - 전송 바이트 수
+TX:31(Z:55) - 압축 전송 31바이트 (원본 55바이트)
+ZS:98 R:56.4% CPU:18us - 압축 통계 (100프레임마다: 압축 전송 수, 전송/원본 비율, 프레임당 압축 시간)
+OK          - 전송 성공 (ACK 수신)
+FAIL        - 전송 실패 (타임아웃)
+FAIL(N:1)   - 전송 실패 (NAK 수신, 상태 코드 1)
+E:메시지    - 에러
+P2 D:3 ...  - 2번 포트 ([Port2]) 로그, 포트가 둘 이상일 때만 접두어 표시
+COM LOST GONE           - 포트 끊김 (GONE:장치 분리, OPEN:열기 실패, WR:쓰기 오류, TMO:연속 무응답)
+COM RECOVER T:8123ms    - 포트 복구, 끊긴 시간 (끊긴 동안 수집은 계속, 복구 즉시 현재 값 전송)
+CFG RELOAD OK I:52 K:50 - 설정 재적재 완료, 전체 52개 중 50개 유지 (값/ACK 기준 승계)
+SCHEMA 52 H:1A2B3C4D OK - 스키마 사전 전송 (Schema=1 포트, 이후 데이터는 ID 없이 값만)
+CFG: cache 52 items     - CSV 가 그대로여서 oem_param.bin 캐시로 아이템 테이블 적재 (파싱 생략)
+OPC RELOAD X +2 -1 =30  - 서버 X 작업자: 2개 등록, 1개 해제, 담당 30개
+OPC LOST X  - OPC 서버 X 연결 끊김 (담당 아이템은 마지막 값 + Q:3 으로 계속 전송)
+OPC RETRY X 4000ms      - 재연결 실패, 다음 시도까지 대기 (1초부터 2배씩, 최대 60초)
+OPC RECONN X T:12034ms  - 재연결 성공, 끊긴 시간
+SCAN:500                - 적응 주기 변경 ([Agent] ScanMin/ScanMax, 변경이 이어지면 줄고 조용하면 늘어남)
+MET OK 9108             - 실시간 지표 서버 시작 (curl http://127.0.0.1:9108/metrics, Prometheus 형식)
+E:MET 9108              - 지표 포트를 열지 못함 (이미 사용 중 등) - 수집/전송은 그대로
+REC scanrec_20260118_100000.srec - 수집 기록 시작 ([Agent] Record=1, 주기마다 변경 샘플 추가)
+RPL scanrec_...srec X:4 - 기록 재생 시작 ([Agent] Replay=파일, 4배속 / X:MAX 최대 속도, OPC 연결 안 함)
+RPL END C:17280 T:21600123ms - 재생 끝, 주기 수와 소요 시간 (BAD: 파일 손상/잘림, 이후 마지막 값 유지)
 */
 
 TGa1Agent *Ga1Agent;
 
-// α    
-static int g_LogFileIndex = 0;
+// 로그 파일 관리용 전역 변수
 static bool g_bFirstRun = true;
 
 //---------------------------------------------------------------------------
@@ -52,25 +91,99 @@ __fastcall TGa1Agent::TGa1Agent(TComponent* Owner)
 {
     this->OnStart = ServiceStart;
     this->OnStop  = ServiceStop;
+    this->OnExecute = ServiceExecute;
     lstrcpy(gbuf, "[GabbianiAgent Service Log]\r\n");
 
+    m_Items = m_ItemBuf[0];
     m_ItemCount = 0;
-    m_bCommOpened = false;
-    m_bFirstSend = true;
-
-    //   ʱȭ
-    m_nRetryCount = 0;
+    m_nItemGen = 0;
+    m_nLinkCount = 0;
+    m_nWorkerCount = 0;
+    m_PortSup = NULL;
+
+    ZeroMemory(&m_Metrics, sizeof(m_Metrics));
+    m_MetricsSrv = NULL;
+    m_nMetricsPort = 0;
+
+    m_bRecord = false;
+    m_hRecord = INVALID_HANDLE_VALUE;
+    m_RecClock = 0;
+    m_nRecCount = 0;
+    m_bReplay = false;
+    m_dReplaySpeed = 1.0;
+    m_ReplayData = NULL;
+    m_nReplayLen = 0;
+    m_nReplayPos = 0;
+    m_ReplayClock = 0;
+    m_nReplayCycles = 0;
+    m_dwReplayTick = 0;
+    m_ReplayStartMs = 0;
+    m_nReplayPending = 0;
+
+    m_hCfgWatch = INVALID_HANDLE_VALUE;
+    m_nCfgAgeCsv = -1;
+    m_nCfgAgeIni = -1;
+    m_bCfgPending = false;
+    m_dwCfgTick = 0;
+
+    m_bCsvStamp = false;
+    m_dwCsvSize = 0;
+    m_dwCsvHash = 0;
+    m_bCacheDirty = false;
+
+    ZeroMemory(m_WriteCmds, sizeof(m_WriteCmds));
+    m_nWriteSerial = 0;
+
+    ZeroMemory(&m_Reactor, sizeof(m_Reactor));
+    m_nScanTimerId = -1;
+    m_nPollTimerId = -1;
+    m_nCfgWatchId = -1;
+    m_bCycleOpen = false;
+    m_dwCycleTick = 0;
+    m_nReplayWait = 0;
+
+    m_bBinLog = false;
+    m_nBinCount = 0;
+    ZeroMemory(&m_BinDate, sizeof(m_BinDate));
+
+    m_LogRing.hFile = INVALID_HANDLE_VALUE;
+    m_LogRing.hMap = NULL;
+    m_LogRing.Hdr = NULL;
+    m_LogRing.Data = NULL;
+    m_bLogOpened = false;
+    m_dwLogSize = 0;
+
+    InitializeCriticalSection(&m_csItems);
+    InitializeCriticalSection(&m_csLog);
+    InitializeCriticalSection(&m_csWrite);
+
+    // 응답 관련 초기화
     m_nMaxRetries = 3;
-    m_bWaitingResponse = false;
     
-    // === Heartbeat  ʱȭ ߰ ===
-    m_dwLastSendTick = 0;
-    m_dwHeartbeatInterval = 5000;  // 5 (ʿ )
+    // === Heartbeat 관련 초기화 추가 ===
+    m_dwHeartbeatInterval = 5000;  // 5초 (필요시 조정)
 
-    // === INI  ⺻ ===
-    m_nComPort = 3;
-    m_nBaudRate = 115200;
+    // === INI 설정 기본값 ===
     m_nTimeInterval = 5000;
+    m_bAdaptive = false;
+    m_nScanMin = 0;
+    m_nScanMax = 0;
+    m_nScanBusy = 1;
+    m_nScanInterval = m_nTimeInterval;
+    m_nBusyCycles = 0;
+    m_nQuietCycles = 0;
+
+    m_lPrioPending = 0;
+    m_nPrioLatRemUs = 0;
+}
+
+//---------------------------------------------------------------------------
+__fastcall TGa1Agent::~TGa1Agent()
+{
+    DeleteCriticalSection(&m_csItems);
+    DeleteCriticalSection(&m_csWrite);
+    RingLogClose(&m_LogRing);
+    DeleteCriticalSection(&m_csLog);
 }
 
 //---------------------------------------------------------------------------
@@ -86,81 +199,241 @@ void __stdcall ServiceController(unsigned CtrlCode)
 }
 
 //---------------------------------------------------------------------------
-// α ޽ 
+// 로그 메시지 기록
 //
-//  : [2026-01-18 10:00:00] Data: [1:0,100] [2:0,200] [3:0,300] ...
-//  : [10:00:00] D:5 TX:43 OK
+// 변경 전: [2026-01-18 10:00:00] Data: [1:0,100] [2:0,200] [3:0,300] ...
+// 변경 후: [10:00:00] D:5 TX:43 OK
 //          [10:00:05] D(HB):5 TX:43 OK
-//          [10:00:10] D:5(C:2) TX:43 OK    <- 2 ׸ 
-// 			LogMessage Լ  (¥ , ð)
+//          [10:00:10] D:5(C:2) TX:43 OK    <- 2개 항목 변경됨
+// 			LogMessage 함수 수정 (날짜 제거, 시간만)
 //---------------------------------------------------------------------------
 void __fastcall TGa1Agent::LogMessage(String msg)
 {
-    HANDLE hFile;
-    DWORD dwBytesWritten;
-    DWORD dwFileSize;
+    LogText(msg.c_str(), msg.Length());
+}
+
+//---------------------------------------------------------------------------
+// 문자 버퍼 그대로 기록 (주기마다 남는 전송 로그용 - 힙 할당 없음)
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::LogText(const char* msg, int len)
+{
+    // 작업자 스레드에서도 호출되므로 파일 접근 직렬화
+    EnterCriticalSection(&m_csLog);
+    try
+    {
+        WriteLogLine(msg, len);
+    }
+    __finally
+    {
+        LeaveCriticalSection(&m_csLog);
+    }
+}
+
+//---------------------------------------------------------------------------
+// 한 줄 기록 (m_csLog 안에서 호출)
+// 링 파일 (logsave.ring) 에 메모리 복사로 추가한다. 링을 열지 못했을 때만
+// logsave.txt 에 직접 쓰고, 링 크기를 넘으면 처음부터 다시 쓴다.
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::WriteLogLine(const char* msg, int len)
+{
     SYSTEMTIME st;
-    String logFileName;
-    
-    String exePath = ExtractFilePath(ParamStr(0));
-    String logBasePath = exePath + "logsave";
+    char line[LOG_LINE_MAX];
+    int pos = 0;
+
+    if (!m_bLogOpened)
+        OpenLogRing();
+
+    GetLocalTime(&st);
 
-    while (true)
+    // 서비스 시작마다 빈 줄로 구분
+    if (g_bFirstRun)
     {
-        if (g_LogFileIndex == 0)
-            logFileName = logBasePath + ".txt";
-        else
-            logFileName = logBasePath + "_" + IntToStr(g_LogFileIndex) + ".txt";
+        line[pos++] = '\r';
+        line[pos++] = '\n';
+        g_bFirstRun = false;
+    }
 
-        hFile = CreateFile(
-            logFileName.c_str(),
-            GENERIC_WRITE,
-            FILE_SHARE_READ,
-            NULL,
-            OPEN_ALWAYS,
-            FILE_ATTRIBUTE_NORMAL,
-            NULL
-        );
+    // === 변경: 날짜 제거, 시간만 출력 (HH:MM:SS) ===
+    pos += sprintf(line + pos, "[%02d:%02d:%02d] ", st.wHour, st.wMinute, st.wSecond);
 
-        if (hFile == INVALID_HANDLE_VALUE) return;
+    if (len > LOG_LINE_MAX - 2 - pos)
+        len = LOG_LINE_MAX - 2 - pos;
+    memcpy(line + pos, msg, len);
+    pos += len;
+    line[pos++] = '\r';
+    line[pos++] = '\n';
 
-        dwFileSize = GetFileSize(hFile, NULL);
+    if (m_LogRing.Hdr != NULL)
+    {
+        RingLogPut(m_LogRing.Hdr, m_LogRing.Data, line, pos);
+        return;
+    }
 
-        if (dwFileSize > 60000)
-        {
-            CloseHandle(hFile);
-            g_LogFileIndex++;
-            g_bFirstRun = false;
-            continue;
-        }
-        break;
+    String logFileName = ExtractFilePath(ParamStr(0)) + "logsave.txt";
+    HANDLE hFile = CreateFile(logFileName.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return;
+
+    if (GetFileSize(hFile, NULL) > m_dwLogSize)
+    {
+        SetFilePointer(hFile, 0, NULL, FILE_BEGIN);
+        SetEndOfFile(hFile);
     }
 
+    DWORD dwBytesWritten;
     SetFilePointer(hFile, 0, NULL, FILE_END);
+    WriteFile(hFile, line, pos, &dwBytesWritten, NULL);
+    CloseHandle(hFile);
+}
 
-    if (g_bFirstRun)
+//---------------------------------------------------------------------------
+// 링 로그 열기 (첫 로그 기록 때 한 번, 설정 적재 전이므로 INI 를 직접 읽음)
+// [Agent] LogSizeKB 가 바뀌면 다음 서비스 시작 때 새 크기로 다시 잡는다.
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::OpenLogRing()
+{
+    String exePath = ExtractFilePath(ParamStr(0));
+    int sizeKB = 4096;
+
+    m_bLogOpened = true;
+
+    TIniFile *ini = new TIniFile(exePath + "oem_setting.ini");
+    try
     {
-        if (dwFileSize > 0)
-        {
-            String blankLine = "\r\n";
-            WriteFile(hFile, blankLine.c_str(), blankLine.Length(), &dwBytesWritten, NULL);
-        }
-        g_bFirstRun = false;
+        sizeKB = ini->ReadInteger("Agent", "LogSizeKB", 4096);
+    }
+    __finally
+    {
+        delete ini;
+    }
+
+    m_dwLogSize = (DWORD)sizeKB * 1024;
+    if (m_dwLogSize < RLOG_MIN_SIZE) m_dwLogSize = RLOG_MIN_SIZE;
+
+    String ringName = exePath + "logsave.ring";
+    RingLogOpen(&m_LogRing, ringName.c_str(), m_dwLogSize);
+}
+
+//---------------------------------------------------------------------------
+// 작업자 지표 칸 잡기/놓기 (작업자 생성자/소멸자, 메인 스레드)
+// 칸은 해제하지 않고 재사용하므로 지표 서버가 읽는 중에 사라지지 않는다.
+//---------------------------------------------------------------------------
+TScanMetrics* __fastcall TGa1Agent::OpenScanMetrics(String progId)
+{
+    for (int w = 0; w < MAX_OPC_SERVERS; w++)
+    {
+        TScanMetrics* m = &m_Metrics.Server[w];
+        if (m->Active)
+            continue;
+
+        m->Connected = 0;
+        m->Scans = 0;
+        m->ScanMs = 0;
+        m->LastScanMs = 0;
+        m->ItemsRead = 0;
+        m->ReadErrors = 0;
+        lstrcpyn(m->Name, progId.c_str(), METRICS_NAME_LEN);
+        InterlockedExchange(&m->Active, 1);
+        return m;
+    }
+    return NULL;
+}
+
+void __fastcall TGa1Agent::CloseScanMetrics(TScanMetrics* m)
+{
+    if (m != NULL)
+        InterlockedExchange(&m->Active, 0);
+}
+
+//---------------------------------------------------------------------------
+// 주기마다 게이지 갱신 (포트 상태/속도, 묶음 대기, 쓰기 처리 중)
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::UpdateGaugeMetrics()
+{
+    for (int l = 0; l < m_nLinkCount; l++)
+    {
+        TEspLink* L = &m_Links[l];
+        TLinkMetrics* M = &m_Metrics.Link[l];
+        InterlockedExchange(&M->ComPort, L->ComPort);
+        InterlockedExchange(&M->BaudRate, L->BaudRate);
+        InterlockedExchange(&M->Up, (L->Opened && !L->Down) ? 1 : 0);
+        InterlockedExchange(&M->QueueDepth, (L->Batch > 0) ? L->SampleTotal : L->QueueDepth);
+    }
+
+    int writes = 0;
+    for (int s = 0; s < WRITE_QUEUE; s++)
+    {
+        if (m_WriteCmds[s].InUse)
+            writes++;
     }
 
+    InterlockedExchange(&m_Metrics.WriteQueue, writes);
+    InterlockedExchange(&m_Metrics.ItemCount, m_ItemCount);
+    InterlockedExchange(&m_Metrics.LinkCount, m_nLinkCount);
+    InterlockedExchange(&m_Metrics.ScanInterval, m_nScanInterval);
+}
+
+//---------------------------------------------------------------------------
+// 이진 이벤트 기록 (레코드 복사만, 파일 쓰기는 FlushBinLog)
+// 날짜가 바뀌면 이전 날짜 레코드를 먼저 내보내고 새 파일로 넘어간다.
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::BinLogEvent(TBinLogRec* r)
+{
+    SYSTEMTIME st;
     GetLocalTime(&st);
-    
-    // === : ¥ , ð  (HH:MM:SS) ===
-    String timeStr;
-    timeStr.printf("[%02d:%02d:%02d] ", st.wHour, st.wMinute, st.wSecond);
 
-    AnsiString finalMsg = timeStr + msg + "\r\n";
-    WriteFile(hFile, finalMsg.c_str(), finalMsg.Length(), &dwBytesWritten, NULL);
-    CloseHandle(hFile);
+    r->TimeMs = ((st.wHour * 60 + st.wMinute) * 60 + st.wSecond) * 1000 + st.wMilliseconds;
+
+    EnterCriticalSection(&m_csLog);
+    if (m_nBinCount > 0 && (st.wDay != m_BinDate.wDay || st.wMonth != m_BinDate.wMonth ||
+                            st.wYear != m_BinDate.wYear))
+    {
+        FlushBinLog();
+    }
+    if (m_nBinCount == 0)
+        m_BinDate = st;
+
+    m_BinBuf[m_nBinCount++] = *r;
+    if (m_nBinCount >= BLOG_BUF_RECS)
+        FlushBinLog();
+    LeaveCriticalSection(&m_csLog);
 }
 
 //---------------------------------------------------------------------------
-// VARIANT ڿ ȯ
+// 모아 둔 레코드를 날짜별 파일 끝에 추가 (logbin_YYYYMMDD.bin)
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::FlushBinLog()
+{
+    EnterCriticalSection(&m_csLog);
+    if (m_nBinCount > 0)
+    {
+        char name[32];
+        sprintf(name, "logbin_%04d%02d%02d.bin", m_BinDate.wYear, m_BinDate.wMonth, m_BinDate.wDay);
+        String fileName = ExtractFilePath(ParamStr(0)) + name;
+
+        HANDLE hFile = CreateFile(fileName.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                                  OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (hFile != INVALID_HANDLE_VALUE)
+        {
+            DWORD written;
+            if (GetFileSize(hFile, NULL) == 0)
+            {
+                TBinLogHdr hdr;
+                BinLogHeader(&hdr, m_BinDate.wYear, m_BinDate.wMonth, m_BinDate.wDay);
+                WriteFile(hFile, &hdr, sizeof(hdr), &written, NULL);
+            }
+
+            SetFilePointer(hFile, 0, NULL, FILE_END);
+            WriteFile(hFile, m_BinBuf, m_nBinCount * sizeof(TBinLogRec), &written, NULL);
+            CloseHandle(hFile);
+        }
+        m_nBinCount = 0;
+    }
+    LeaveCriticalSection(&m_csLog);
+}
+
+//---------------------------------------------------------------------------
+// VARIANT를 문자열로 변환
 //---------------------------------------------------------------------------
 String __fastcall TGa1Agent::VariantToString(const tagVARIANT &v)
 {
@@ -185,29 +458,29 @@ String __fastcall TGa1Agent::VariantToString(const tagVARIANT &v)
 }
 
 //---------------------------------------------------------------------------
-// Quality ڵ ȯ
+// Quality 코드 변환 (ScanCycle.cpp)
 //---------------------------------------------------------------------------
 int __fastcall TGa1Agent::GetQualityCode(long quality)
 {
-    int majorQuality = quality & 0xC0;
+    return CycleQualityCode(quality);
+}
 
-    if (majorQuality == 0xC0) return 0;   // Good
-    else if (majorQuality == 0x40) return 1;   // Uncertain
-    else
-    {
-        switch (quality)
-        {
-            case 0x08: return 2;    // Not Connected
-            case 0x18: return 3;    // Comm Failure
-            case 0x0C: return 4;    // Device Failure
-            case 0x10: return 5;    // Sensor Failure
-            default:   return 9;    // Other Error
-        }
-    }
+//---------------------------------------------------------------------------
+// 시각 변환 (Unix ms, UTC)
+//---------------------------------------------------------------------------
+static LONGLONG UnixNowMs()
+{
+    FILETIME ft;
+    GetSystemTimeAsFileTime(&ft);
+
+    ULARGE_INTEGER t;
+    t.LowPart = ft.dwLowDateTime;
+    t.HighPart = ft.dwHighDateTime;
+    return (LONGLONG)((t.QuadPart - 116444736000000000ui64) / 10000);
 }
 
 //---------------------------------------------------------------------------
-// VARIANT long ȯ (񱳿)
+// VARIANT를 long으로 변환 (비교용)
 //---------------------------------------------------------------------------
 long __fastcall TGa1Agent::VariantToLong(const VARIANT &v)
 {
@@ -224,13 +497,13 @@ long __fastcall TGa1Agent::VariantToLong(const VARIANT &v)
         case VT_R4:   return (long)(v.fltVal * 1000);
         case VT_R8:   return (long)(v.dblVal * 1000);
         case VT_BOOL: return v.boolVal ? 1 : 0;
-		case VT_DATE: return (long)((v.date - 25569.0) * 86400.0); // OLE DATE (1899-12-30 )  Unix timestamp (1970-01-01 )
+		case VT_DATE: return (long)((v.date - 25569.0) * 86400.0); // OLE DATE (1899-12-30 기준) → Unix timestamp (1970-01-01 기준)
         default:      return 0;
     }
 }
 
 //---------------------------------------------------------------------------
-// INI   ε
+// INI 설정 파일 로드
 //---------------------------------------------------------------------------
 void __fastcall TGa1Agent::LoadSettings()
 {
@@ -239,18 +512,42 @@ void __fastcall TGa1Agent::LoadSettings()
     TIniFile *ini = new TIniFile(IniPath);
     try
     {
-        // [Communication] 
-        String comStr = ini->ReadString("Communication", "COM_Port", "COM3");
+        // [Communication] 섹션 = 1번 포트 (MyComm)
+        m_nLinkCount = 0;
+        LoadLinkSettings(ini, "Communication");
+        m_Links[0].Comm = MyComm;
 
-        // "COM17" -> 17 
-        if (comStr.UpperCase().Pos("COM") == 1) m_nComPort = StrToIntDef(comStr.SubString(4, comStr.Length() - 3), 17);
-        else m_nComPort = StrToIntDef(comStr, 17);
-
-        m_nBaudRate = ini->ReadInteger("Communication", "BaudRate", 115200);
+        // [Port2] ~ [Port8] 섹션 = 추가 출력 포트
+        for (int i = 2; i <= MAX_ESP_LINKS; i++)
+        {
+            String section = "Port" + IntToStr(i);
+            if (ini->SectionExists(section))
+                LoadLinkSettings(ini, section);
+        }
 
-        // [Agent] 
+        // [Agent] 섹션
         m_nTimeInterval = ini->ReadInteger("Agent", "TimeInterval", 5000);
-        LogMessage("CFG: COM" + IntToStr(m_nComPort) + " " + IntToStr(m_nBaudRate) + " T:" + IntToStr(m_nTimeInterval));
+        m_nScanInterval = ReadScanBounds(ini, m_nTimeInterval);
+
+        // 주기마다 남는 전송/쓰기 결과는 이진 로그로 (BinLogDump 로 텍스트 변환)
+        m_bBinLog = ini->ReadBool("Agent", "BinLog", false);
+
+        // 실시간 지표 (127.0.0.1 에서만, 0 이면 끔) - 서비스 시작 때만 적용
+        m_nMetricsPort = ini->ReadInteger("Agent", "MetricsPort", 0);
+
+        // 수집 기록 / 기록 재생 (재생 중에는 OPC 에 연결하지 않고 기록하지도 않음)
+        m_bRecord = ini->ReadBool("Agent", "Record", false);
+        m_ReplayFile = ini->ReadString("Agent", "Replay", "");
+        m_dReplaySpeed = ini->ReadFloat("Agent", "ReplaySpeed", 1.0);
+        if (m_dReplaySpeed < 0) m_dReplaySpeed = 0;
+#if SERVER_SIMULATE
+        m_DefaultServer = ini->ReadString("Agent", "OPCServer", "Matrikon.OPC.Simulation.1");
+#else
+        m_DefaultServer = ini->ReadString("Agent", "OPCServer", "Schneider-Aut.OFS.2");
+#endif
+        LogMessage("CFG: T:" + IntToStr(m_nTimeInterval) + " P:" + IntToStr(m_nLinkCount) +
+                   (m_bAdaptive ? " S:" + IntToStr(m_nScanMin) + "-" + IntToStr(m_nScanMax) : String("")) +
+                   (m_bBinLog ? " BIN" : ""));
     }
     __finally
     {
@@ -259,368 +556,2649 @@ void __fastcall TGa1Agent::LoadSettings()
 }
 
 //---------------------------------------------------------------------------
-// CSV Ͽ   ε
+// 출력 포트 설정 로드 (섹션 하나 = 포트 하나)
 //---------------------------------------------------------------------------
-bool __fastcall TGa1Agent::LoadItemConfig(String filename)
+void __fastcall TGa1Agent::LoadLinkSettings(TIniFile *ini, String section)
 {
-    TStringList *lines = new TStringList();
-    m_ItemCount = 0;
-
-    try
-    {
-        if (!FileExists(filename))
-        {
-            LogMessage("Config file not found: " + filename);
-            delete lines;
-            return false;
-        }
-
-        lines->LoadFromFile(filename);
-        LogMessage("Loading config: " + filename + " (" + IntToStr(lines->Count) + " lines)");
+    TEspLink* L = &m_Links[m_nLinkCount];
+    ZeroMemory(L, sizeof(TEspLink));
+
+    m_LinkSection[m_nLinkCount] = section;
+    ReadLinkSettings(ini, section, L);
+
+    L->BaudRate = L->BaseBaud;
+    L->FirstSend = true;
+    L->LastResp.Status = RESP_STATUS_TMO;
+    RxReset(&L->Rx);
+    FrameLayout(&L->Frame, L->FrameBuf, 0);
+
+    m_nLinkCount++;
+
+    LogMessage("CFG: COM" + IntToStr(L->ComPort) + " " + IntToStr(L->BaseBaud) +
+               (L->AutoBaud ? "(AB:" + IntToStr(L->BaudStepCount) + ")" : String("")) +
+               (L->Compress ? " Z" : "") +
+               (L->Schema ? " S" : "") +
+               (L->Batch > 0 ? " B:" + IntToStr(L->Batch) : String("")) +
+               (L->KeepaliveMs > 0 ? " K:" + IntToStr((int)L->KeepaliveMs) : String("")) +
+               (m_LinkItems[m_nLinkCount - 1].IsEmpty() ? String("") : " I:" + m_LinkItems[m_nLinkCount - 1]));
+}
 
-        for (int i = 1; i < lines->Count && m_ItemCount < MAX_OPC_ITEMS; i++)
-        {
-            String line = lines->Strings[i].Trim();
-            if (line.IsEmpty() || line[1] == '#')
-                continue;
+//---------------------------------------------------------------------------
+// 포트 설정 키 읽기 (시작 시 + 재적재 시 공용)
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::ReadLinkSettings(TIniFile *ini, String section, TEspLink* L)
+{
+    String comStr = ini->ReadString(section, "COM_Port", "COM3");
 
-            //  CSV Ľ (StrictDelimiter )
-            String col0 = "";
-            String col1 = "";
-            String col2 = "";
-            String col3 = "";
-            int colIndex = 0;
-            String temp = "";
+    // "COM17" -> 17 추출
+    if (comStr.UpperCase().Pos("COM") == 1) L->ComPort = StrToIntDef(comStr.SubString(4, comStr.Length() - 3), 17);
+    else L->ComPort = StrToIntDef(comStr, 17);
 
-            for (int j = 1; j <= line.Length(); j++)
-            {
-                if (line[j] == ',')
-                {
-                    switch (colIndex)
-                    {
-                        case 0: col0 = temp.Trim(); break;
-                        case 1: col1 = temp.Trim(); break;
-                        case 2: col2 = temp.Trim(); break;
-                        case 3: col3 = temp.Trim(); break;
-                    }
-                    temp = "";
-                    colIndex++;
-                }
-                else
-                {
-                    temp += line[j];
-                }
-            }
-            //  ÷
-            switch (colIndex)
-            {
-                case 0: col0 = temp.Trim(); break;
-                case 1: col1 = temp.Trim(); break;
-                case 2: col2 = temp.Trim(); break;
-                case 3: col3 = temp.Trim(); break;
-            }
+    L->BaseBaud = ini->ReadInteger(section, "BaudRate", 115200);
 
-            if (!col0.IsEmpty() && !col1.IsEmpty() && !col2.IsEmpty())
-            {
-                m_Items[m_ItemCount].ItemID = StrToIntDef(col0, 0);
-                m_Items[m_ItemCount].TagName = col1;
-                m_Items[m_ItemCount].DataType = col2.UpperCase();
-                m_Items[m_ItemCount].Description = col3;  //  ڿ̸ ׳  ڿ
-                m_Items[m_ItemCount].pItem = NULL;
-                m_Items[m_ItemCount].Quality = 0;
-                m_Items[m_ItemCount].Changed = false;
-
-                VariantInit(&m_Items[m_ItemCount].varValue);
-                VariantInit(&m_Items[m_ItemCount].varPrevValue);
-
-                LogMessage("  Item[" + IntToStr(m_ItemCount) + "]: ID=" +
-                           IntToStr(m_Items[m_ItemCount].ItemID) +
-                           ", Tag=" + m_Items[m_ItemCount].TagName +
-                           ", Type=" + m_Items[m_ItemCount].DataType);
-
-                m_ItemCount++;
-            }
+    // 자동 보오레이트: AutoBaud=1, BaudSteps=921600,460800,230400 (높은 순)
+    L->AutoBaud = ini->ReadBool(section, "AutoBaud", false);
+    L->BaudStepCount = 0;
+    TStringList *steps = new TStringList();
+    try
+    {
+        steps->CommaText = ini->ReadString(section, "BaudSteps", "921600,460800,230400");
+        for (int i = 0; i < steps->Count && L->BaudStepCount < 8; i++)
+        {
+            int baud = StrToIntDef(steps->Strings[i].Trim(), 0);
+            if (baud > L->BaseBaud) L->BaudSteps[L->BaudStepCount++] = baud;
         }
-        LogMessage("Loaded " + IntToStr(m_ItemCount) + " items from config.");
     }
-    catch (Exception &ex)
+    __finally
     {
-        LogMessage("Error loading config: " + ex.Message);
-        delete lines;
-        return false;
+        delete steps;
     }
 
-    delete lines;
-    return (m_ItemCount > 0);
+    L->Compress = ini->ReadBool(section, "Compress", false);
+    L->Schema = ini->ReadBool(section, "Schema", false);
+
+    // 다중 샘플 묶음: Batch=8 (아이템당 샘플 수), BatchMs=5000 (최대 지연)
+    L->Batch = ini->ReadInteger(section, "Batch", 0);
+    if (L->Batch < 0) L->Batch = 0;
+    if (L->Batch > BATCH_MAX) L->Batch = BATCH_MAX;
+    L->BatchMs = ini->ReadInteger(section, "BatchMs", 5000);
+    L->HeartbeatMs = ini->ReadInteger(section, "Heartbeat", m_dwHeartbeatInterval);
+
+    // 생존 확인: Keepalive=1000 이면 값이 그대로인 동안 전체 프레임 대신 1초마다
+    // SEQ + 다이제스트만 보내고, 전체 데이터는 변경 / ESP32 요청 시에만 보낸다
+    L->KeepaliveMs = ini->ReadInteger(section, "Keepalive", 0);
+
+    // 보낼 아이템: Items=1-5,7 (ItemID 목록/범위, 비어 있으면 전체)
+    m_LinkItems[L - m_Links] = ini->ReadString(section, "Items", "");
 }
 
 //---------------------------------------------------------------------------
-// ø Ʈ ʱȭ
+// Items= 항목 검사 ("1-5" 범위 또는 단일 ItemID)
 //---------------------------------------------------------------------------
-bool __fastcall TGa1Agent::InitSerialPort(int portNum, int baudRate)
+static bool ItemInSpec(TStrings *spec, int itemId)
 {
-    try
+    for (int k = 0; k < spec->Count; k++)
     {
-        if (MyComm == NULL)
-        {
-            LogMessage("Error: MyComm component is NULL");
-            return false;
-        }
-
-        // ̹  ݱ
-        if (MyComm->Active()) MyComm->Close();
-
-        // Ʈ 
-        MyComm->PortNum = portNum;
-
-        // BaudRate enum Ÿ̹Ƿ ȯ ʿ
-        switch (baudRate)
+        String s = spec->Strings[k].Trim();
+        int dash = s.Pos("-");
+        if (dash > 1)
         {
-            case 9600:   MyComm->Baudrate = br9600;   break;
-            case 19200:  MyComm->Baudrate = br19200;  break;
-            case 38400:  MyComm->Baudrate = br38400;  break;
-            case 57600:  MyComm->Baudrate = br57600;  break;
-            case 115200: MyComm->Baudrate = br115200; break;
-            default:     MyComm->Baudrate = br115200; break;
+            int lo = StrToIntDef(s.SubString(1, dash - 1).Trim(), -1);
+            int hi = StrToIntDef(s.SubString(dash + 1, s.Length() - dash).Trim(), -2);
+            if (itemId >= lo && itemId <= hi) return true;
         }
-
-        MyComm->Databits = db8;
-        MyComm->Stopbits = sb1;
-        MyComm->Parity = paNone;
-
-        // Ʈ 
-        MyComm->Open();
-
-        if (MyComm->Active())
+        else if (StrToIntDef(s, -1) == itemId)
         {
-            m_bCommOpened = true;
-            LogMessage("Serial port COM" + IntToStr(portNum) +
-                       " opened at " + IntToStr(baudRate) + " bps");
             return true;
         }
-        else
-        {
-            LogMessage("Failed to open COM" + IntToStr(portNum));
-            return false;
-        }
-    }
-    catch (Exception &ex)
-    {
-        LogMessage("Serial port error: " + ex.Message);
-        return false;
     }
+    return false;
 }
 
 //---------------------------------------------------------------------------
-// ø Ʈ ݱ
+// 포트별 아이템 부분집합 배정 (아이템 테이블 확정 후 호출)
 //---------------------------------------------------------------------------
-void __fastcall TGa1Agent::CloseSerialPort()
+void __fastcall TGa1Agent::AssignLinkItems()
 {
+    TStringList *spec = new TStringList();
     try
     {
-        if (MyComm && MyComm->Active())
-        {
-            MyComm->Close();
-            m_bCommOpened = false;
-            LogMessage("Serial port closed.");
-        }
+        for (int l = 0; l < m_nLinkCount; l++)
+            AssignLink(l, spec);
     }
-    catch (Exception &ex)
+    __finally
     {
-        LogMessage("Error closing serial port: " + ex.Message);
+        delete spec;
     }
 }
 
 //---------------------------------------------------------------------------
-// üũ  (XOR)
+// 포트 하나의 슬롯 배정 (spec 은 작업용 목록)
 //---------------------------------------------------------------------------
-BYTE __fastcall TGa1Agent::CalcChecksum(BYTE* data, int len)
+void __fastcall TGa1Agent::AssignLink(int l, TStrings *spec)
 {
-    BYTE checksum = 0;
-    for (int i = 0; i < len; i++)
+    TEspLink* L = &m_Links[l];
+    spec->CommaText = m_LinkItems[l];
+
+    L->SlotCount = 0;
+    for (int i = 0; i < m_ItemCount; i++)
     {
-        checksum ^= data[i];
+        m_Items[i].LinkSlot[l] = -1;
+        if (spec->Count > 0 && !ItemInSpec(spec, m_Items[i].ItemID))
+            continue;
+
+        m_Items[i].LinkSlot[l] = (short)L->SlotCount;
+        L->Slots[L->SlotCount++] = i;
     }
-    return checksum;
+
+    if (m_nLinkCount > 1)
+        LogMessage(LinkTag(L) + "ITEM:" + IntToStr(L->SlotCount));
 }
 
 //---------------------------------------------------------------------------
-//    Ȯ
+// 포트 로그 접두어 (포트가 하나면 기존 로그 형식 그대로)
 //---------------------------------------------------------------------------
-bool __fastcall TGa1Agent::IsValueChanged(int index)
+String __fastcall TGa1Agent::LinkTag(TEspLink* L)
 {
-    if (index < 0 || index >= m_ItemCount)
-        return false;
-
-    long currVal = VariantToLong(m_Items[index].varValue);
-    long prevVal = VariantToLong(m_Items[index].varPrevValue);
-
-    return (currVal != prevVal);
+    if (m_nLinkCount <= 1)
+        return "";
+    return "P" + IntToStr((int)(L - m_Links) + 1) + " ";
 }
 
-//---------------------------------------------------------------------------
-//   ִ Ȯ
-//---------------------------------------------------------------------------
-bool __fastcall TGa1Agent::HasAnyChanges()
+// 같은 접두어를 문자 버퍼에 (주기마다 남는 로그용, 길이 반환)
+int __fastcall TGa1Agent::PutLinkTag(char* p, TEspLink* L)
 {
-    bool hasChange = false;
-    for (int i = 0; i < m_ItemCount; i++)
-    {
-        if (IsValueChanged(i))
-        {
-            m_Items[i].Changed = true;
-            hasChange = true;
-        }
-    }
-    return hasChange;
+    *p = 0;
+    if (m_nLinkCount <= 1)
+        return 0;
+    return sprintf(p, "P%d ", (int)(L - m_Links) + 1);
 }
 
 //---------------------------------------------------------------------------
-// Ŷ 
-// : [STX][LEN_L][LEN_H][CNT][ID_L][ID_H][Q][VAL0][VAL1][VAL2][VAL3]...[CHK][ETX]
+// CSV 파일에서 아이템 설정 로드
 //---------------------------------------------------------------------------
-int __fastcall TGa1Agent::BuildPacket(BYTE* buffer)
+bool __fastcall TGa1Agent::LoadItemConfig(String filename, TOPCItemInfo* items, int &count)
 {
-    int pos = 0;
+    count = 0;
+
+    HANDLE hFile = CreateFile(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        LogMessage("Config file not found: " + filename);
+        return false;
+    }
 
-    // STX
-    buffer[pos++] = PROTO_STX;
+    // 파일을 통째로 매핑해서 토크나이저가 바로 훑음 (행/필드 복사 없음)
+    DWORD size = GetFileSize(hFile, NULL);
+    HANDLE hMap = NULL;
+    const char* data = NULL;
 
-    // Length (߿ ä)
-    int lenPos = pos;
-    pos += 2;
+    if (size > 0 && size != INVALID_FILE_SIZE)
+        hMap = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (hMap != NULL)
+        data = (const char*)MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
 
-    // Item Count
-    buffer[pos++] = (BYTE)m_ItemCount;
+    int rows = 0;
+    int errors = 0;
 
-    //   
-    for (int i = 0; i < m_ItemCount; i++)
+    if (data != NULL)
     {
-        // Item ID (2 bytes, Little Endian)
-        WORD itemId = (WORD)m_Items[i].ItemID;
-        buffer[pos++] = (BYTE)(itemId & 0xFF);
-        buffer[pos++] = (BYTE)((itemId >> 8) & 0xFF);
+        LARGE_INTEGER freq, t0, t1;
+        QueryPerformanceFrequency(&freq);
+        QueryPerformanceCounter(&t0);
 
-        // Quality (1 byte)
-        buffer[pos++] = (BYTE)GetQualityCode(m_Items[i].Quality);
+        try
+        {
+            rows = ParseItemRows(data, (int)size, items, count, errors);
+        }
+        catch (Exception &ex)
+        {
+            LogMessage("Error loading config: " + ex.Message);
+            count = 0;
+        }
 
-        // Value (4 bytes, Little Endian)
-        long value = VariantToLong(m_Items[i].varValue);
-        buffer[pos++] = (BYTE)(value & 0xFF);
-        buffer[pos++] = (BYTE)((value >> 8) & 0xFF);
-        buffer[pos++] = (BYTE)((value >> 16) & 0xFF);
-        buffer[pos++] = (BYTE)((value >> 24) & 0xFF);
-    }
+        // 이 내용으로 만든 테이블을 캐시에 기록할 수 있도록 표식 보관
+        if (count > 0)
+        {
+            m_bCsvStamp = true;
+            m_dwCsvSize = size;
+            GetFileTime(hFile, NULL, NULL, &m_ftCsvTime);
+            m_dwCsvHash = CsvHash(data, (int)size, CSV_HASH_SEED);
+            m_bCacheDirty = true;
+        }
+
+        QueryPerformanceCounter(&t1);
+        double ms = (double)(t1.QuadPart - t0.QuadPart) * 1000.0 / freq.QuadPart;
 
-    // Length ä (STX , Checksum/ETX   )
-    WORD dataLen = pos - 3;
-    buffer[lenPos] = (BYTE)(dataLen & 0xFF);
-    buffer[lenPos + 1] = (BYTE)((dataLen >> 8) & 0xFF);
+        LogMessage("CFG: " + IntToStr(count) + "/" + IntToStr(rows) + " items E:" + IntToStr(errors) +
+                   " " + FormatFloat("0.0", ms) + "ms");
+        if (rows - errors > MAX_OPC_ITEMS)
+            LogMessage("CFG: item limit " + IntToStr(MAX_OPC_ITEMS));
 
-    // Checksum (STX   )
-    buffer[pos] = CalcChecksum(&buffer[1], pos - 1);
-    pos++;
+        UnmapViewOfFile(data);
+    }
+    else
+    {
+        LogMessage("Error loading config: " + filename);
+    }
 
-    // ETX
-    buffer[pos++] = PROTO_ETX;
+    if (hMap != NULL)
+        CloseHandle(hMap);
+    CloseHandle(hFile);
 
-    return pos;
+    return (count > 0);
 }
 
-
 //---------------------------------------------------------------------------
-// ESP32   (ü ü - ó + Ʈ α)
+// ItemID 색인 (세대 테이블을 채운 뒤, 작업자에게 넘기기 전에 만든다)
+// ItemID 는 0..65535 로 검증되어 있고 중복이 없다.
 //---------------------------------------------------------------------------
-void __fastcall TGa1Agent::SendToESP32(int changeCount, bool isHeartbeat)
+static inline int ItemIndexHash(int itemId)
 {
-    if (!m_bCommOpened || MyComm == NULL || !MyComm->Active())
-    {
-        LogMessage("E:COM not ready");
-        return;
-    }
+    return (int)(((unsigned long)itemId * 2654435761UL) >> (32 - ITEM_INDEX_BITS)) & (ITEM_INDEX_SIZE - 1);
+}
 
-    try
-    {
-        // Ŷ 
-        int packetLen = BuildPacket(m_SendBuffer);
+void __fastcall TGa1Agent::BuildItemIndex(int gen, int count)
+{
+    TItemIndex* index = m_ItemIndex[gen & 1];
+    TOPCItemInfo* table = ItemTable(gen);
 
-        //   
-        while (MyComm->ReadBufUsed() > 0)
-        {
-            BYTE dummy;
-            MyComm->ReadBuf(&dummy, 1);
-        }
-    
-		// α  
-#if	HK_DEBUG
-	    //  α (HEX  )
-    	String hexDump = "TX: ";
-	    for (int i = 0; i < packetLen; i++) hexDump += IntToHex(m_SendBuffer[i], 2) + " ";
-	    LogMessage(hexDump);
-#endif
-        // 
-        MyComm->WriteBuf(m_SendBuffer, packetLen);
-
-        // Ʈ α 
-        // : D:5 TX:43 OK / D(HB):5 TX:43 OK / D:5(C:2) TX:43 FAIL
-        String logMsg = "D";
-        if (isHeartbeat) logMsg += "(HB)";
-        logMsg += ":" + IntToStr(m_ItemCount);
-        if (changeCount > 0) logMsg += "(C:" + IntToStr(changeCount) + ")";
-        logMsg += " TX:" + IntToStr(packetLen);
-
-        //  
-        if (WaitForResponse(RESP_TIMEOUT_MS))
-        {
-            // 
-            logMsg += " OK";
-            for (int i = 0; i < m_ItemCount; i++)
-            {
-                VariantCopy(&m_Items[i].varPrevValue, &m_Items[i].varValue);
-                m_Items[i].Changed = false;
-            }
-            m_nRetryCount = 0;
-        }
-        else
-        {
-            // 
-            logMsg += " FAIL";
-//            HandleSendFailure();
-        }
-        
-        LogMessage(logMsg);
-    }
-    catch (Exception &ex)
+    for (int h = 0; h < ITEM_INDEX_SIZE; h++)
+        index[h].Slot = -1;
+
+    for (int i = 0; i < count; i++)
     {
-        LogMessage("E:" + ex.Message);
-//        HandleSendFailure();
+        int h = ItemIndexHash(table[i].ItemID);
+        while (index[h].Slot >= 0)
+            h = (h + 1) & (ITEM_INDEX_SIZE - 1);
+
+        index[h].ItemID = (WORD)table[i].ItemID;
+        index[h].Slot = (short)i;
     }
 }
 
 //---------------------------------------------------------------------------
-//   (α ȭ - ش κи )
+// ItemID -> 테이블 인덱스 (-1: 없음)
 //---------------------------------------------------------------------------
-/*
-ServiceStart Լ  LogMessage ȣ κ Ʒ  ȭ:
-
-  
-"=== Service Starting ==="  "SVC START"
-"Step 1: Opening Serial Port..."  ()
-"Serial port COM17 opened at 115200 bps"  "COM17 OK 115200"
-"Success: OPC Server Connected."  "OPC OK"
-"Step 3: Registering OPC Items..."  ()
-"  Registered: Random.Int1"  ( Ǵ "+" + TagName)
-"Step 4: Timer Started (5 sec interval)."  "TMR OK"
-"=== Service Started Successfully ==="  "SVC READY"
+int __fastcall TGa1Agent::FindItem(int gen, int itemId)
+{
+    if (itemId < 0 || itemId > 0xFFFF)
+        return -1;
+
+    TItemIndex* index = m_ItemIndex[gen & 1];
+    int h = ItemIndexHash(itemId);
+    while (index[h].Slot >= 0)
+    {
+        if (index[h].ItemID == itemId)
+            return index[h].Slot;
+        h = (h + 1) & (ITEM_INDEX_SIZE - 1);
+    }
+    return -1;
+}
+
+//---------------------------------------------------------------------------
+// 파일 내용 해시 (매핑해서 계산)
+//---------------------------------------------------------------------------
+static bool HashFile(String filename, DWORD* hash)
+{
+    HANDLE hFile = CreateFile(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    bool ok = false;
+    DWORD size = GetFileSize(hFile, NULL);
+    HANDLE hMap = NULL;
+
+    if (size > 0 && size != INVALID_FILE_SIZE)
+        hMap = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (hMap != NULL)
+    {
+        const char* data = (const char*)MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+        if (data != NULL)
+        {
+            *hash = CsvHash(data, (int)size, CSV_HASH_SEED);
+            UnmapViewOfFile(data);
+            ok = true;
+        }
+        CloseHandle(hMap);
+    }
+    CloseHandle(hFile);
+    return ok;
+}
+
+//---------------------------------------------------------------------------
+// 캐시 이미지로 아이템 테이블 채우기
+// 크기/수정 시각이 같으면 CSV 는 열지 않는다. 시각만 다르면 내용 해시로
+// 확인하고(다시 저장만 한 경우), 기본 서버가 바뀌었으면 쓰지 않는다.
+//---------------------------------------------------------------------------
+bool __fastcall TGa1Agent::LoadItemCache(String csvFile, TOPCItemInfo* items, int &count)
+{
+    count = 0;
+
+    WIN32_FILE_ATTRIBUTE_DATA csv;
+    if (!GetFileAttributesEx(csvFile.c_str(), GetFileExInfoStandard, &csv))
+        return false;
+
+    String binFile = ChangeFileExt(csvFile, ".bin");
+    HANDLE hFile = CreateFile(binFile.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    DWORD size = GetFileSize(hFile, NULL);
+    HANDLE hMap = NULL;
+    const BYTE* data = NULL;
+
+    if (size >= sizeof(TItemCacheHdr) && size != INVALID_FILE_SIZE)
+        hMap = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (hMap != NULL)
+        data = (const BYTE*)MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+
+    bool ok = false;
+    if (data != NULL)
+    {
+        const TItemCacheHdr* hdr = (const TItemCacheHdr*)data;
+        const TItemCacheRec* rec = (const TItemCacheRec*)(hdr + 1);
+        const char* pool = (const char*)(rec + hdr->Count);
+        DWORD srvHash = CsvHash(m_DefaultServer.c_str(), m_DefaultServer.Length(), CSV_HASH_SEED);
+
+        ok = (hdr->Magic == ITEM_CACHE_MAGIC && hdr->Version == ITEM_CACHE_VERSION &&
+              hdr->Count > 0 && hdr->Count <= MAX_OPC_ITEMS && hdr->PoolSize > 0 &&
+              sizeof(TItemCacheHdr) + hdr->Count * sizeof(TItemCacheRec) + hdr->PoolSize == size &&
+              pool[hdr->PoolSize - 1] == 0 &&
+              hdr->SrvHash == srvHash &&
+              hdr->CsvSize == csv.nFileSizeLow && csv.nFileSizeHigh == 0);
+
+        m_dwCsvSize = hdr->CsvSize;
+        m_ftCsvTime = hdr->CsvTime;
+        m_dwCsvHash = hdr->CsvHash;
+
+        if (ok && CompareFileTime(&hdr->CsvTime, &csv.ftLastWriteTime) != 0)
+        {
+            DWORD hash;
+            ok = (HashFile(csvFile, &hash) && hash == hdr->CsvHash);
+            if (ok)
+            {
+                m_ftCsvTime = csv.ftLastWriteTime;
+                m_bCacheDirty = true;
+            }
+        }
+
+        for (int i = 0; ok && i < hdr->Count; i++)
+        {
+            const TItemCacheRec* r = &rec[i];
+            if (r->Tag >= hdr->PoolSize || r->Type >= hdr->PoolSize ||
+                r->Desc >= hdr->PoolSize || r->Server >= hdr->PoolSize)
+            {
+                ok = false;
+                break;
+            }
+
+            items[i].ItemID = r->ItemID;
+            items[i].TagName = pool + r->Tag;
+            items[i].DataType = pool + r->Type;
+            items[i].Description = pool + r->Desc;
+            items[i].Server = pool + r->Server;
+            items[i].Priority = r->Priority;
+            items[i].PrioArmed = false;
+            items[i].PrioPending = false;
+            items[i].ServerHandle = r->ServerHandle;
+            items[i].AddError = r->AddError;
+            items[i].Quality = 0;
+            items[i].SrcTime = 0;
+            items[i].TimeMs = 0;
+            items[i].Dirty = false;
+            items[i].Value = 0;
+            items[i].QCode = 0;
+            items[i].RawValue = 0;
+        }
+
+        if (ok)
+            count = hdr->Count;
+        UnmapViewOfFile(data);
+    }
+
+    if (hMap != NULL)
+        CloseHandle(hMap);
+    CloseHandle(hFile);
+
+    m_bCsvStamp = ok;
+    if (ok)
+        LogMessage("CFG: cache " + IntToStr(count) + " items");
+    return ok;
+}
+
+//---------------------------------------------------------------------------
+// 사용 중인 테이블을 캐시 이미지로 저장 (임시 파일에 쓰고 교체)
+// CSV 로 만든 테이블이 아니면(기본 아이템) 저장하지 않는다.
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::SaveItemCache(String csvFile)
+{
+    m_bCacheDirty = false;
+    if (!m_bCsvStamp || m_ItemCount <= 0)
+        return;
+
+    DWORD poolSize = 0;
+    for (int i = 0; i < m_ItemCount; i++)
+    {
+        poolSize += m_Items[i].TagName.Length() + m_Items[i].DataType.Length() +
+                    m_Items[i].Description.Length() + m_Items[i].Server.Length() + 4;
+    }
+
+    DWORD total = sizeof(TItemCacheHdr) + m_ItemCount * sizeof(TItemCacheRec) + poolSize;
+    BYTE* buf = new BYTE[total];
+    ZeroMemory(buf, total);
+
+    TItemCacheHdr* hdr = (TItemCacheHdr*)buf;
+    TItemCacheRec* rec = (TItemCacheRec*)(hdr + 1);
+    char* pool = (char*)(rec + m_ItemCount);
+
+    hdr->Magic = ITEM_CACHE_MAGIC;
+    hdr->Version = ITEM_CACHE_VERSION;
+    hdr->Count = (WORD)m_ItemCount;
+    hdr->CsvSize = m_dwCsvSize;
+    hdr->CsvTime = m_ftCsvTime;
+    hdr->CsvHash = m_dwCsvHash;
+    hdr->SrvHash = CsvHash(m_DefaultServer.c_str(), m_DefaultServer.Length(), CSV_HASH_SEED);
+    hdr->PoolSize = poolSize;
+
+    DWORD ofs = 0;
+    for (int i = 0; i < m_ItemCount; i++)
+    {
+        TOPCItemInfo* item = &m_Items[i];
+        String* strs[4] = { &item->TagName, &item->DataType, &item->Description, &item->Server };
+        DWORD* offs[4] = { &rec[i].Tag, &rec[i].Type, &rec[i].Desc, &rec[i].Server };
+
+        for (int s = 0; s < 4; s++)
+        {
+            *offs[s] = ofs;
+            int len = strs[s]->Length();
+            if (len > 0)
+                memcpy(pool + ofs, strs[s]->c_str(), len);
+            ofs += len + 1;
+        }
+
+        rec[i].ItemID = item->ItemID;
+        rec[i].ServerHandle = item->ServerHandle;
+        rec[i].AddError = item->AddError;
+        rec[i].Priority = item->Priority;
+    }
+
+    String binFile = ChangeFileExt(csvFile, ".bin");
+    String tmpFile = binFile + ".tmp";
+
+    DWORD written = 0;
+    HANDLE hFile = CreateFile(tmpFile.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile != INVALID_HANDLE_VALUE)
+    {
+        WriteFile(hFile, buf, total, &written, NULL);
+        CloseHandle(hFile);
+    }
+    delete[] buf;
+
+    if (written == total && MoveFileEx(tmpFile.c_str(), binFile.c_str(), MOVEFILE_REPLACE_EXISTING))
+        return;
+
+    DeleteFile(tmpFile.c_str());
+    LogMessage("CFG: cache write fail");
+}
+
+//---------------------------------------------------------------------------
+// CSV 필드 -> String (인용 해제, UTF-8 이면 시스템 코드 페이지로 변환)
+//---------------------------------------------------------------------------
+static String CsvText(TCsvReader* r, const TCsvField* f)
+{
+    String s;
+    if (f->Len == 0)
+        return s;
+
+    s.SetLength(f->Len);
+    s.SetLength(CsvCopy(f, s.c_str(), f->Len));
+
+    if (CsvFieldEncoding(r, f) == CSV_ENC_UTF8)
+    {
+        int wlen = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), s.Length(), NULL, 0);
+        WideString w;
+        w.SetLength(wlen);
+        MultiByteToWideChar(CP_UTF8, 0, s.c_str(), s.Length(), w.c_bstr(), wlen);
+        s = w;
+    }
+    return s;
+}
+
+//---------------------------------------------------------------------------
+// 아이템 행 파싱 + 검증 (버퍼를 한 번만 훑음)
+// 헤더(첫 행), 빈 행, '#' 주석 행은 건너뜀. 테이블이 가득 차도 나머지 행은
+// 검증만 계속해서 오류 수를 정확히 센다. 반환값은 데이터 행 수.
+// CSV: ItemID,TagName,DataType[,Description[,Server[,Priority]]]
+//---------------------------------------------------------------------------
+int __fastcall TGa1Agent::ParseItemRows(const char* data, int len, TOPCItemInfo* items, int &count, int &errors)
+{
+    TCsvReader r;
+    TCsvField f[CSV_MAX_FIELDS];
+    BYTE seen[0x10000 / 8];         // ItemID 중복 검사 (프레임 ID 는 16비트)
+    ZeroMemory(seen, sizeof(seen));
+
+    count = 0;
+    errors = 0;
+    int rows = 0;
+
+    CsvInit(&r, data, len);
+    CsvNextRow(&r, f, CSV_MAX_FIELDS);      // 헤더
+
+    int n;
+    while ((n = CsvNextRow(&r, f, CSV_MAX_FIELDS)) >= 0)
+    {
+        if (n == 1 && f[0].Len == 0)
+            continue;
+        if (f[0].Len > 0 && !f[0].Quoted && f[0].Ptr[0] == '#')
+            continue;
+        rows++;
+
+        long id = 0;
+        long priority = 0;
+        const char* err = NULL;
+        if (r.BadQuote)
+            err = "unclosed quote";
+        else if (n < 3 || f[1].Len == 0 || f[2].Len == 0)
+            err = "missing column";
+        else if (!CsvToInt(&f[0], &id) || id < 0 || id > 0xFFFF)
+            err = "bad ItemID";
+        else if (seen[id >> 3] & (1 << (id & 7)))
+            err = "duplicate ItemID";
+        else if (n > 5 && f[5].Len > 0 && (!CsvToInt(&f[5], &priority) || priority < 0))
+            err = "bad Priority";
+
+        if (err != NULL)
+        {
+            if (errors < CFG_MAX_ERR_LOG)
+                LogMessage("CFG ERR L" + IntToStr(r.RowLine) + ": " + err);
+            errors++;
+            continue;
+        }
+        seen[id >> 3] |= (BYTE)(1 << (id & 7));
+
+        if (count >= MAX_OPC_ITEMS)
+            continue;
+
+        TOPCItemInfo* item = &items[count];
+        item->ItemID = (int)id;
+        item->TagName = CsvText(&r, &f[1]);
+        item->DataType = CsvText(&r, &f[2]).UpperCase();
+        item->Description = (n > 3) ? CsvText(&r, &f[3]) : String();
+        item->Server = (n > 4 && f[4].Len > 0) ? CsvText(&r, &f[4]) : m_DefaultServer;
+        item->Priority = (int)priority;
+        item->PrioArmed = false;
+        item->PrioPending = false;
+        item->ServerHandle = 0;
+        item->AddError = S_OK;
+        item->Quality = 0;
+        item->SrcTime = 0;
+        item->TimeMs = 0;
+        item->Dirty = false;
+        item->Value = 0;
+        item->QCode = 0;
+        item->RawValue = 0;
+
+#if HK_DEBUG
+        LogMessage("  Item[" + IntToStr(count) + "]: ID=" + IntToStr(item->ItemID) +
+                   ", Tag=" + item->TagName + ", Type=" + item->DataType + ", Srv=" + item->Server);
+#endif
+        count++;
+    }
+
+    return rows;
+}
+
+//---------------------------------------------------------------------------
+// 설정 파일 감시 시작 (실행 폴더 쓰기 알림 + 파일 시간 비교)
+// 같은 폴더에 로그도 쓰므로 알림만으로는 판단하지 않고 두 파일의 시간을 본다.
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::WatchConfig()
+{
+    String exePath = ExtractFilePath(ParamStr(0));
+
+    m_nCfgAgeCsv = FileAge(exePath + "oem_param.csv");
+    m_nCfgAgeIni = FileAge(exePath + "oem_setting.ini");
+
+    m_hCfgWatch = FindFirstChangeNotification(exePath.c_str(), FALSE,
+                                              FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+    if (m_hCfgWatch == INVALID_HANDLE_VALUE)
+        LogMessage("CFG WATCH FAIL");
+    else
+        m_nCfgWatchId = ReactorAddHandle(&m_Reactor, m_hCfgWatch, CfgWatchProc, this);
+}
+
+//---------------------------------------------------------------------------
+// 폴더 변경 알림 (이벤트 루프) - 두 파일 시간이 바뀌었으면 재적재 예약
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::ConfigNotify()
+{
+    FindNextChangeNotification(m_hCfgWatch);
+
+    String exePath = ExtractFilePath(ParamStr(0));
+    int ageCsv = FileAge(exePath + "oem_param.csv");
+    int ageIni = FileAge(exePath + "oem_setting.ini");
+
+    if (ageCsv != m_nCfgAgeCsv || ageIni != m_nCfgAgeIni)
+    {
+        m_nCfgAgeCsv = ageCsv;
+        m_nCfgAgeIni = ageIni;
+        m_bCfgPending = true;
+        m_dwCfgTick = GetTickCount();
+    }
+}
+
+//---------------------------------------------------------------------------
+// 예약된 재적재 처리 (수집 주기 시작마다, 대기 없음)
+// 알림은 ConfigNotify 가 받고, 파일 쓰기가 끝나도록 CFG_SETTLE_MS 뒤에 읽는다.
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::CheckConfigChange()
+{
+    if (m_hCfgWatch == INVALID_HANDLE_VALUE)
+        return;
+
+    if (m_bCfgPending && GetTickCount() - m_dwCfgTick >= CFG_SETTLE_MS)
+    {
+        if (ReloadConfig())
+            m_bCfgPending = false;
+    }
+
+    // 재적재 후 모든 작업자가 새 테이블로 등록을 마치면 캐시 갱신
+    if (m_bCacheDirty)
+    {
+        for (int w = 0; w < m_nWorkerCount; w++)
+        {
+            if (m_Workers[w]->AppliedGen != m_nItemGen)
+                return;
+        }
+        SaveItemCache(ExtractFilePath(ParamStr(0)) + "oem_param.csv");
+    }
+}
+
+//---------------------------------------------------------------------------
+// 설정 재적재 (타이머 스레드, 주기 사이)
+// 1. INI 재적재 (주기, 기본 서버, 포트별 키)
+// 2. 대기 테이블에 CSV 적재 -> 기존 아이템과 매칭 (Server + TagName)
+// 3. 유지 아이템의 값/품질 승계 후 m_csItems 안에서 테이블 교체
+// 4. 작업자에게 바뀐 부분만 등록/해제하도록 계획 전달
+// 5. 포트 슬롯 재배정 (유지 아이템은 ACK 기준값도 승계)
+// 이전 재적재를 아직 적용하지 않은 작업자가 있으면 false (다음 주기에 다시)
+//---------------------------------------------------------------------------
+bool __fastcall TGa1Agent::ReloadConfig()
+{
+    for (int w = 0; w < m_nWorkerCount; w++)
+    {
+        if (m_Workers[w]->AppliedGen != m_nItemGen)
+            return false;
+    }
+
+    LogMessage("CFG RELOAD");
+    ReloadSettings();
+
+    int nextGen = m_nItemGen + 1;
+    TOPCItemInfo* next = ItemTable(nextGen);
+    int nextCount = 0;
+
+    String configFile = ExtractFilePath(ParamStr(0)) + "oem_param.csv";
+    if (!LoadItemConfig(configFile, next, nextCount))
+    {
+        // 아이템 목록은 그대로 (INI 변경만 반영)
+        LogMessage("CFG RELOAD: items kept");
+        return true;
+    }
+
+    BuildItemIndex(nextGen, nextCount);
+
+    // 기존 아이템 매칭 + 상태 승계 후 교체
+    // 대부분 ItemID 가 그대로이므로 색인으로 먼저 찾고, 번호가 바뀐 아이템만 전체 검색
+    int oldIndex[MAX_OPC_ITEMS];
+    TOPCItemInfo* prev = m_Items;
+    int kept = 0;
+
+    EnterCriticalSection(&m_csItems);
+    for (int i = 0; i < nextCount; i++)
+    {
+        oldIndex[i] = -1;
+        int o = FindItem(m_nItemGen, next[i].ItemID);
+        if (o >= 0 && prev[o].TagName == next[i].TagName &&
+            prev[o].Server.AnsiCompareIC(next[i].Server) == 0)
+        {
+            oldIndex[i] = o;
+        }
+
+        for (o = 0; oldIndex[i] < 0 && o < m_ItemCount; o++)
+        {
+            if (prev[o].TagName == next[i].TagName &&
+                prev[o].Server.AnsiCompareIC(next[i].Server) == 0)
+            {
+                oldIndex[i] = o;
+            }
+        }
+
+        o = oldIndex[i];
+        if (o < 0)
+            continue;
+
+        next[i].RawValue = prev[o].RawValue;
+        next[i].Quality = prev[o].Quality;
+        next[i].Dirty = prev[o].Dirty;
+        next[i].Value = prev[o].Value;
+        next[i].QCode = prev[o].QCode;
+        next[i].SrcTime = prev[o].SrcTime;
+        next[i].TimeMs = prev[o].TimeMs;
+        next[i].ServerHandle = prev[o].ServerHandle;
+        next[i].AddError = prev[o].AddError;
+        next[i].PrioArmed = prev[o].PrioArmed;
+        next[i].PrioPending = prev[o].PrioPending && next[i].Priority > 0;
+        next[i].PrioValue = prev[o].PrioValue;
+        next[i].PrioQCode = prev[o].PrioQCode;
+        next[i].PrioTime = prev[o].PrioTime;
+        kept++;
+    }
+
+    m_Items = next;
+    m_ItemCount = nextCount;
+    m_nItemGen = nextGen;
+    LeaveCriticalSection(&m_csItems);
+
+    ReloadWorkers(oldIndex);
+    RebuildLinks(oldIndex, prev);
+
+    LogMessage("CFG RELOAD OK I:" + IntToStr(m_ItemCount) + " K:" + IntToStr(kept));
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// INI 재적재 - 주기 / 기본 서버 / 포트별 키
+// 포트 번호나 기본 속도가 바뀐 포트는 닫고 감시자가 새 설정으로 다시 연다.
+// 포트 섹션 추가/삭제는 재시작해야 반영된다.
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::ReloadSettings()
+{
+    String IniPath = ExtractFilePath(ParamStr(0)) + "oem_setting.ini";
+
+    TIniFile *ini = new TIniFile(IniPath);
+    try
+    {
+        // TimeInterval 이 바뀌면 그 주기부터, 아니면 현재 적응 주기를 새 범위 안으로
+        int interval = ini->ReadInteger("Agent", "TimeInterval", 5000);
+        bool restart = (interval != m_nTimeInterval);
+        m_nTimeInterval = interval;
+        SetScanInterval(ReadScanBounds(ini, restart ? m_nTimeInterval : m_nScanInterval));
+#if SERVER_SIMULATE
+        m_DefaultServer = ini->ReadString("Agent", "OPCServer", "Matrikon.OPC.Simulation.1");
+#else
+        m_DefaultServer = ini->ReadString("Agent", "OPCServer", "Schneider-Aut.OFS.2");
+#endif
+
+        int sections = 1;
+        for (int i = 2; i <= MAX_ESP_LINKS; i++)
+        {
+            if (ini->SectionExists("Port" + IntToStr(i)))
+                sections++;
+        }
+        if (sections != m_nLinkCount)
+            LogMessage("CFG: port list changed, restart required");
+
+        for (int l = 0; l < m_nLinkCount; l++)
+        {
+            TEspLink* L = &m_Links[l];
+            int comPort = L->ComPort;
+            int baseBaud = L->BaseBaud;
+            bool autoBaud = L->AutoBaud;
+            bool schema = L->Schema;
+            int batch = L->Batch;
+            DWORD batchMs = L->BatchMs;
+
+            ReadLinkSettings(ini, m_LinkSection[l], L);
+
+            // 묶음 크기/지연이 바뀌면 이전 설정으로 쌓인 샘플은 버리고 전체 전송
+            if (L->Batch != batch || L->BatchMs != batchMs)
+            {
+                LinkClearSamples(L);
+                L->FirstSend = true;
+            }
+
+            // 프레임 형식이 바뀌면 이미지 재배치 후 전체 전송
+            if (L->Schema != schema)
+            {
+                BuildPacket(L);
+                L->SchemaPending = L->Schema;
+                L->FirstSend = true;
+            }
+
+            if (L->ComPort == comPort && L->BaseBaud == baseBaud && L->AutoBaud == autoBaud)
+                continue;
+
+            if (L->Down)
+            {
+                if (m_PortSup) m_PortSup->Watch(l, L->ComPort, true);
+            }
+            else
+            {
+                LinkDown(L, "CFG");
+            }
+        }
+
+        LogMessage("CFG: T:" + IntToStr(m_nTimeInterval) + " P:" + IntToStr(m_nLinkCount) +
+                   (m_bAdaptive ? " S:" + IntToStr(m_nScanMin) + "-" + IntToStr(m_nScanMax) : String("")));
+    }
+    __finally
+    {
+        delete ini;
+    }
+}
+
+//---------------------------------------------------------------------------
+// 적응 주기 범위 읽기 - 적용할 주기 반환 (고정 주기면 TimeInterval)
+// ScanMin=500, ScanMax=5000 이면 변경이 이어지는 동안 0.5초까지 줄이고
+// 조용하면 5초까지 늘린다. ScanBusy 는 "변경 있음"으로 볼 최소 변경 수
+// (계속 바뀌는 시계 태그 등이 있으면 그보다 크게).
+//---------------------------------------------------------------------------
+int __fastcall TGa1Agent::ReadScanBounds(TIniFile *ini, int interval)
+{
+    m_nScanMin = ini->ReadInteger("Agent", "ScanMin", 0);
+    m_nScanMax = ini->ReadInteger("Agent", "ScanMax", 0);
+    m_nScanBusy = ini->ReadInteger("Agent", "ScanBusy", 1);
+    if (m_nScanBusy < 1) m_nScanBusy = 1;
+    if (m_nScanMin > 0 && m_nScanMin < SCAN_MIN_FLOOR) m_nScanMin = SCAN_MIN_FLOOR;
+
+    m_bAdaptive = (m_nScanMin > 0 && m_nScanMin < m_nScanMax);
+    m_nBusyCycles = 0;
+    m_nQuietCycles = 0;
+
+    if (!m_bAdaptive)
+        return m_nTimeInterval;
+    if (interval < m_nScanMin) return m_nScanMin;
+    if (interval > m_nScanMax) return m_nScanMax;
+    return interval;
+}
+
+//---------------------------------------------------------------------------
+// 수집 주기 적용 (메인 타이머 + 모든 작업자, 재생 중에는 타이머를 재생이 관리)
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::SetScanInterval(int interval)
+{
+    if (interval == m_nScanInterval)
+        return;
+
+    m_nScanInterval = interval;
+    for (int w = 0; w < m_nWorkerCount; w++)
+        m_Workers[w]->SetInterval(m_nScanInterval);
+    InterlockedExchange(&m_Metrics.ScanInterval, m_nScanInterval);
+}
+
+//---------------------------------------------------------------------------
+// 적응 주기 (MergeItems 직후, 이번 주기 변경 수 기준)
+// 한쪽 방향 주기가 연속으로 쌓여야 움직이고 반대 주기가 오면 처음부터 다시
+// 세므로, 변경이 드문드문 섞인 구간에서는 주기가 오르내리지 않는다.
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::AdaptScanRate(int changes)
+{
+    if (!m_bAdaptive)
+        return;
+
+    int next;
+    if (changes >= m_nScanBusy)
+    {
+        m_nQuietCycles = 0;
+        if (++m_nBusyCycles < SCAN_TIGHTEN_CYCLES)
+            return;
+        m_nBusyCycles = 0;
+        next = m_nScanInterval / 2;
+        if (next < m_nScanMin) next = m_nScanMin;
+    }
+    else
+    {
+        m_nBusyCycles = 0;
+        if (++m_nQuietCycles < SCAN_RELAX_CYCLES)
+            return;
+        m_nQuietCycles = 0;
+        next = m_nScanInterval + m_nScanInterval / 2;
+        if (next > m_nScanMax) next = m_nScanMax;
+    }
+
+    if (next != m_nScanInterval)
+    {
+        LogMessage("SCAN:" + IntToStr(next));
+        SetScanInterval(next);
+    }
+}
+
+//---------------------------------------------------------------------------
+// 작업자별 재적재 계획 전달 (서버가 없어진 작업자는 종료, 새 서버는 작업자 추가)
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::ReloadWorkers(const int* oldIndex)
+{
+    int planIndex[MAX_OPC_ITEMS];
+    int planOld[MAX_OPC_ITEMS];
+
+    int w = 0;
+    while (w < m_nWorkerCount)
+    {
+        TOpcWorker* worker = m_Workers[w];
+
+        int count = 0;
+        for (int i = 0; i < m_ItemCount; i++)
+        {
+            if (worker->ProgID.AnsiCompareIC(m_Items[i].Server) != 0)
+                continue;
+
+            int old = -1;
+            if (oldIndex[i] >= 0)
+            {
+                for (int k = 0; k < worker->ItemCount; k++)
+                {
+                    if (worker->IndexAt(k) == oldIndex[i])
+                    {
+                        old = k;
+                        break;
+                    }
+                }
+            }
+            planIndex[count] = i;
+            planOld[count] = old;
+            count++;
+        }
+
+        if (count == 0)
+        {
+            LogMessage("OPC STOP " + worker->ProgID);
+            worker->Stop();
+            delete worker;
+            for (int k = w; k < m_nWorkerCount - 1; k++)
+                m_Workers[k] = m_Workers[k + 1];
+            m_Workers[--m_nWorkerCount] = NULL;
+            continue;
+        }
+
+        worker->PostPlan(m_nItemGen, planIndex, planOld, count);
+        w++;
+    }
+
+    // 새 서버 (기존 작업자의 아이템은 위 계획으로 처리됨)
+    int firstNew = m_nWorkerCount;
+    for (int i = 0; i < m_ItemCount; i++)
+    {
+        int found = -1;
+        for (int k = 0; k < m_nWorkerCount; k++)
+        {
+            if (m_Workers[k]->ProgID.AnsiCompareIC(m_Items[i].Server) == 0)
+            {
+                found = k;
+                break;
+            }
+        }
+
+        if (found >= 0 && found < firstNew)
+            continue;
+
+        if (found < 0)
+        {
+            if (m_nWorkerCount >= MAX_OPC_SERVERS)
+            {
+                LogMessage("  [" + IntToStr(i) + "] OPC server limit: " + m_Items[i].Server);
+                continue;
+            }
+            found = m_nWorkerCount;
+            m_Workers[m_nWorkerCount++] = new TOpcWorker(this, m_Items[i].Server, m_nScanInterval, m_nItemGen);
+        }
+
+        m_Workers[found]->AddItem(i);
+    }
+
+    for (int k = firstNew; k < m_nWorkerCount; k++)
+        m_Workers[k]->Resume();
+}
+
+//---------------------------------------------------------------------------
+// 포트 슬롯 재배정 + 프레임 재배치
+// 유지 아이템은 이전 ACK 기준값을 그대로 써서 불필요한 전송이 없고,
+// 슬롯 배치(ItemID 순서)가 바뀐 포트만 다음 주기에 전체 프레임을 보낸다.
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::RebuildLinks(const int* oldIndex, TOPCItemInfo* oldItems)
+{
+    long ack[MAX_OPC_ITEMS];
+    BYTE ackQ[MAX_OPC_ITEMS];
+    int ids[MAX_OPC_ITEMS];
+
+    TStringList *spec = new TStringList();
+    try
+    {
+        for (int l = 0; l < m_nLinkCount; l++)
+        {
+            TEspLink* L = &m_Links[l];
+
+            int oldSlots = L->SlotCount;
+            for (int k = 0; k < oldSlots; k++)
+            {
+                ack[k] = L->AckValue[k];
+                ackQ[k] = L->AckQCode[k];
+                ids[k] = oldItems[L->Slots[k]].ItemID;
+            }
+
+            AssignLink(l, spec);
+            BuildPacket(L);
+
+            bool layoutChanged = (L->SlotCount != oldSlots);
+            for (int k = 0; k < L->SlotCount; k++)
+            {
+                int i = L->Slots[k];
+                int o = oldIndex[i];
+                int oldSlot = (o >= 0) ? oldItems[o].LinkSlot[l] : -1;
+
+                L->AckValue[k] = (oldSlot >= 0) ? ack[oldSlot] : m_Items[i].Value;
+                L->AckQCode[k] = (oldSlot >= 0) ? ackQ[oldSlot] : m_Items[i].QCode;
+
+                if (k >= oldSlots || ids[k] != m_Items[i].ItemID)
+                    layoutChanged = true;
+            }
+
+            if (layoutChanged)
+                L->FirstSend = true;
+        }
+    }
+    __finally
+    {
+        delete spec;
+    }
+}
+
+//---------------------------------------------------------------------------
+// OPC 서버별 작업자 생성 및 시작 (아이템의 Server 컬럼 기준으로 분배)
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::StartWorkers()
+{
+    m_nWorkerCount = 0;
+
+    for (int i = 0; i < m_ItemCount; i++)
+    {
+        TOpcWorker* worker = NULL;
+        for (int w = 0; w < m_nWorkerCount; w++)
+        {
+            if (m_Workers[w]->ProgID.AnsiCompareIC(m_Items[i].Server) == 0)
+            {
+                worker = m_Workers[w];
+                break;
+            }
+        }
+
+        if (worker == NULL)
+        {
+            if (m_nWorkerCount >= MAX_OPC_SERVERS)
+            {
+                LogMessage("  [" + IntToStr(i) + "] OPC server limit: " + m_Items[i].Server);
+                continue;
+            }
+            worker = new TOpcWorker(this, m_Items[i].Server, m_nScanInterval, m_nItemGen);
+            m_Workers[m_nWorkerCount++] = worker;
+        }
+
+        worker->AddItem(i);
+    }
+
+    for (int w = 0; w < m_nWorkerCount; w++)
+        m_Workers[w]->Resume();
+
+    LogMessage("OPC:" + IntToStr(m_nWorkerCount));
+}
+
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::StopWorkers()
+{
+    for (int w = 0; w < m_nWorkerCount; w++)
+    {
+        m_Workers[w]->Stop();
+        delete m_Workers[w];
+        m_Workers[w] = NULL;
+    }
+    m_nWorkerCount = 0;
+}
+
+//---------------------------------------------------------------------------
+// 작업자 -> 공용 아이템 테이블 (value == NULL 이면 Quality만 갱신)
+// 작업자는 자기가 쓰는 테이블 세대에 기록한다. 재적재 직후 아직 이전 세대인
+// 작업자의 기록은 교체된 테이블로 가므로 반영되지 않고 다음 주기에 다시 읽힌다.
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::PublishItem(int gen, int index, VARIANT* value, long quality, double srcTime)
+{
+    TOPCItemInfo* item = &ItemTable(gen)[index];
+
+    // 잠금 밖에서 변환 (문자열 태그도 사본 없이 - 프레임에는 long 만 실림)
+    long raw = (value != NULL) ? VariantToLong(*value) : 0;
+
+    EnterCriticalSection(&m_csItems);
+    CyclePublish(item, value != NULL, raw, quality, srcTime);
+    if (item->Priority > 0)
+        MarkPriority(item, item->RawValue, (BYTE)GetQualityCode(quality));
+    LeaveCriticalSection(&m_csItems);
+}
+
+//---------------------------------------------------------------------------
+// 우선 전송 아이템 변경 표시 (m_csItems 안, 작업자 또는 재생)
+// 값/품질이 직전 읽기와 다르면 표시하고 메인 스레드가 다음 확인 때 바로 보낸다.
+// 보내기 전에 다시 바뀌면 마지막 값만 가지만 지연은 처음 변경부터 잰다.
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::MarkPriority(TOPCItemInfo* item, long value, BYTE qcode)
+{
+    bool changed = item->PrioArmed && (value != item->PrioValue || qcode != item->PrioQCode);
+
+    item->PrioArmed = true;
+    item->PrioValue = value;
+    item->PrioQCode = qcode;
+
+    if (!changed)
+        return;
+
+    if (!item->PrioPending)
+    {
+        QueryPerformanceCounter(&item->PrioTime);
+        item->PrioPending = true;
+    }
+    InterlockedIncrement(&m_Metrics.PrioEdges);
+    InterlockedExchange(&m_lPrioPending, 1);
+}
+
+//---------------------------------------------------------------------------
+// 공용 아이템 테이블 -> 메인 스레드 사본 + 프레임 패치
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::MergeItems()
+{
+    LONGLONG nowMs = UnixNowMs();
+    int changes = 0;
+
+    EnterCriticalSection(&m_csItems);
+    for (int i = 0; i < m_ItemCount; i++)
+    {
+        TOPCItemInfo* item = &m_Items[i];
+        if (!item->Dirty)
+            continue;
+
+        int r = CycleMerge(item, nowMs);
+
+        UpdateFrameItem(i);
+        if (r & CYCLE_CHANGED)
+            changes++;
+        if (r & CYCLE_SAMPLE)
+        {
+            CaptureSample(i);
+
+            if (m_hRecord != INVALID_HANDLE_VALUE)
+            {
+                TScanSample* s = &m_RecSamples[m_nRecCount++];
+                s->ItemID = item->ItemID;
+                s->Value = item->Value;
+                s->QCode = item->QCode;
+                s->TimeMs = item->TimeMs;
+            }
+        }
+    }
+    LeaveCriticalSection(&m_csItems);
+
+    if (m_hRecord != INVALID_HANDLE_VALUE)
+        RecordCycle(nowMs);
+
+    InterlockedExchangeAdd(&m_Metrics.Changes, changes);
+    InterlockedExchange(&m_Metrics.LastChanges, changes);
+}
+
+//---------------------------------------------------------------------------
+// 수집 기록 시작 (실행 파일 폴더에 시작 시각 이름으로 새 파일)
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::OpenRecord()
+{
+    SYSTEMTIME st;
+    GetLocalTime(&st);
+
+    char name[40];
+    sprintf(name, "scanrec_%04d%02d%02d_%02d%02d%02d.srec",
+            st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute, st.wSecond);
+    String fileName = ExtractFilePath(ParamStr(0)) + name;
+
+    m_hRecord = CreateFile(fileName.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                           CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (m_hRecord == INVALID_HANDLE_VALUE)
+    {
+        LogMessage("E:REC " + String(name));
+        return;
+    }
+
+    TScanRecHdr hdr;
+    DWORD written;
+    m_RecClock = UnixNowMs();
+    ScanRecHeader(&hdr, m_RecClock);
+    WriteFile(m_hRecord, &hdr, sizeof(hdr), &written, NULL);
+    m_nRecCount = 0;
+
+    LogMessage("REC " + String(name));
+}
+
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::CloseRecord()
+{
+    if (m_hRecord != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_hRecord);
+        m_hRecord = INVALID_HANDLE_VALUE;
+    }
+}
+
+//---------------------------------------------------------------------------
+// 주기 하나 기록 (변경이 없는 주기도 간격 보존을 위해 남김, 약 3바이트)
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::RecordCycle(LONGLONG nowMs)
+{
+    int len = ScanRecPutCycle(m_RecBuf, &m_RecClock, nowMs, m_RecSamples, m_nRecCount);
+    m_nRecCount = 0;
+
+    DWORD written;
+    if (!WriteFile(m_hRecord, m_RecBuf, len, &written, NULL) || (int)written != len)
+    {
+        LogMessage("E:REC WR");
+        CloseRecord();
+    }
+}
+
+//---------------------------------------------------------------------------
+// 기록 재생 준비 - 파일 전체를 읽고 첫 주기를 미리 해석해 둔다
+// 실패하면 false (서비스는 평소처럼 OPC 에서 수집)
+//---------------------------------------------------------------------------
+bool __fastcall TGa1Agent::OpenReplay()
+{
+    String fileName = m_ReplayFile;
+    if (ExtractFileDrive(fileName).IsEmpty())
+        fileName = ExtractFilePath(ParamStr(0)) + fileName;
+
+    HANDLE hFile = CreateFile(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        LogMessage("E:RPL OPEN " + m_ReplayFile);
+        return false;
+    }
+
+    TScanRecHdr hdr;
+    DWORD got = 0;
+    DWORD size = GetFileSize(hFile, NULL);
+    if (size < sizeof(hdr) || !ReadFile(hFile, &hdr, sizeof(hdr), &got, NULL) ||
+        got != sizeof(hdr) || !ScanRecCheck(&hdr))
+    {
+        CloseHandle(hFile);
+        LogMessage("E:RPL HDR " + m_ReplayFile);
+        return false;
+    }
+
+    m_nReplayLen = (int)(size - sizeof(hdr));
+    m_ReplayData = new BYTE[m_nReplayLen + 1];
+    ReadFile(hFile, m_ReplayData, m_nReplayLen, &got, NULL);
+    CloseHandle(hFile);
+    m_nReplayLen = (int)got;
+
+    m_nReplayPos = 0;
+    m_ReplayClock = hdr.StartMs;
+    m_nReplayCycles = 0;
+    m_nReplayPending = -1;
+
+    LogMessage("RPL " + ExtractFileName(fileName) + " X:" +
+               (m_dReplaySpeed > 0 ? FloatToStrF(m_dReplaySpeed, ffGeneral, 4, 0) : String("MAX")));
+
+    ReplayStep();       // 첫 주기 해석만 (반영할 것이 없음)
+    m_ReplayStartMs = m_ReplayClock;
+    return (m_ReplayData != NULL);
+}
+
+//---------------------------------------------------------------------------
+// 대기 중인 주기를 아이템 테이블에 반영하고 다음 주기를 해석
+// 반영은 MergeItems 와 같은 경로 (프레임 패치 + 묶음 샘플)
+// 파일 끝이나 손상을 만나면 재생을 끝내고 false
+//---------------------------------------------------------------------------
+bool __fastcall TGa1Agent::ReplayStep()
+{
+    if (m_nReplayPending >= 0)
+    {
+        int changes = 0;
+
+        EnterCriticalSection(&m_csItems);
+        for (int k = 0; k < m_nReplayPending; k++)
+        {
+            const TScanSample* s = &m_RecSamples[k];
+            int i = FindItem(m_nItemGen, s->ItemID);
+            if (i < 0)
+                continue;       // 현재 CSV 에 없는 아이템
+
+            TOPCItemInfo* item = &m_Items[i];
+            item->Value = s->Value;
+            item->QCode = s->QCode;
+            item->TimeMs = s->TimeMs;
+            item->Dirty = false;
+            if (item->Priority > 0)
+                MarkPriority(item, s->Value, s->QCode);
+
+            UpdateFrameItem(i);
+            CaptureSample(i);
+            changes++;
+        }
+        LeaveCriticalSection(&m_csItems);
+
+        InterlockedExchangeAdd(&m_Metrics.Changes, changes);
+        InterlockedExchange(&m_Metrics.LastChanges, changes);
+        m_nReplayCycles++;
+    }
+
+    DWORD dt;
+    int r = ScanRecGetCycle(m_ReplayData + m_nReplayPos, m_nReplayLen - m_nReplayPos,
+                            &m_ReplayClock, &dt, m_RecSamples, MAX_OPC_ITEMS, &m_nReplayPending);
+    if (r > 0)
+    {
+        m_nReplayPos += r;
+        return true;
+    }
+
+    LogMessage("RPL END C:" + IntToStr(m_nReplayCycles) +
+               " T:" + IntToStr((int)(GetTickCount() - m_dwReplayTick)) + "ms" +
+               (r < 0 || m_nReplayPos < m_nReplayLen ? String(" BAD") : String("")));
+
+    delete[] m_ReplayData;
+    m_ReplayData = NULL;
+    m_nReplayPending = -1;
+    return false;
+}
+
+//---------------------------------------------------------------------------
+// 재생 주기 (타이머) - 기록된 주기 하나를 반영하고 평소 경로로 전송만
+// 응답은 PollTick 이 받고 EndCycle 이 m_nReplayWait 뒤로 다음 주기를 예약한다
+// (실시간 경로와 같음 - 응답을 기다리며 이벤트 루프를 멈추지 않는다).
+// 배속이면 다음 주기의 기록 시각에 맞춰 간격을 잡고 (전송 시간만큼 밀리지 않도록
+// 재생 시작 기준), 최대 속도면 응답이 끝나는 대로 다음 주기.
+// 재생이 끝나면 마지막 값으로 평소 주기 (Heartbeat) 를 계속한다.
+// 응답 대기 중인 포트가 있으면 true (StartSends)
+//---------------------------------------------------------------------------
+bool __fastcall TGa1Agent::ReplayCycle()
+{
+    if (m_ReplayData == NULL)
+    {
+        m_nReplayWait = m_nScanInterval;
+        return StartSends();
+    }
+
+    if (m_nReplayCycles == 0)
+        m_dwReplayTick = GetTickCount();
+
+    bool more = ReplayStep();
+    bool open = StartSends();
+
+    if (!more)
+    {
+        m_nReplayWait = m_nScanInterval;
+        return open;
+    }
+
+    int interval = 1;
+    if (m_dReplaySpeed > 0)
+    {
+        double due = (double)(m_ReplayClock - m_ReplayStartMs) / m_dReplaySpeed;
+        double wait = due - (double)(GetTickCount() - m_dwReplayTick);
+        if (wait > 1)
+            interval = (wait > 3600000) ? 3600000 : (int)wait;
+    }
+    m_nReplayWait = interval;
+    return open;
+}
+
+//---------------------------------------------------------------------------
+// 추가 포트용 TVaComm 생성 (MyComm 폼 설정과 동일)
+//---------------------------------------------------------------------------
+TVaComm* __fastcall TGa1Agent::CreateComm()
+{
+    TVaComm* comm = new TVaComm(this);
+
+    comm->DeviceName = MyComm ? MyComm->DeviceName : String("COM%d");
+    comm->FlowControl->OutCtsFlow = false;
+    comm->FlowControl->OutDsrFlow = false;
+    comm->FlowControl->ControlDtr = dtrDisabled;
+    comm->FlowControl->ControlRts = rtsDisabled;
+    comm->FlowControl->XonXoffOut = false;
+    comm->FlowControl->XonXoffIn = false;
+    comm->FlowControl->DsrSensitivity = false;
+    comm->FlowControl->TxContinueOnXoff = false;
+
+    return comm;
+}
+
+//---------------------------------------------------------------------------
+// 시리얼 포트 초기화
+//---------------------------------------------------------------------------
+bool __fastcall TGa1Agent::InitSerialPort(TEspLink* L, int baudRate)
+{
+    int portNum = L->ComPort;
+
+    try
+    {
+        if (L->Comm == NULL)
+            L->Comm = CreateComm();
+
+        TVaComm* comm = L->Comm;
+
+        // 이미 열려있으면 닫기
+        if (comm->Active()) comm->Close();
+
+        // 포트 설정
+        comm->PortNum = portNum;
+
+        // BaudRate는 enum 타입이므로 변환 필요
+        // enum에 없는 속도(230400, 921600, 2M 등)는 열고 난 뒤 DCB로 직접 설정
+        bool userBaud = false;
+        switch (baudRate)
+        {
+            case 9600:   comm->Baudrate = br9600;   break;
+            case 19200:  comm->Baudrate = br19200;  break;
+            case 38400:  comm->Baudrate = br38400;  break;
+            case 57600:  comm->Baudrate = br57600;  break;
+            case 115200: comm->Baudrate = br115200; break;
+            default:     comm->Baudrate = br115200; userBaud = true; break;
+        }
+
+        comm->Databits = db8;
+        comm->Stopbits = sb1;
+        comm->Parity = paNone;
+
+        // 포트 열기
+        comm->Open();
+
+        if (comm->Active() && userBaud && !SetLinkBaud(L, baudRate))
+        {
+            LogMessage("COM" + IntToStr(portNum) + " baud " + IntToStr(baudRate) + " not supported");
+            comm->Close();
+            return false;
+        }
+
+        if (comm->Active())
+        {
+            L->Opened = true;
+            L->BaudRate = baudRate;
+            L->WaitingAck = false;
+            L->WinSends = 0;
+            L->WinFails = 0;
+            RxReset(&L->Rx);
+            LogMessage("Serial port COM" + IntToStr(portNum) +
+                       " opened at " + IntToStr(baudRate) + " bps");
+            return true;
+        }
+        else
+        {
+            LogMessage("Failed to open COM" + IntToStr(portNum));
+            return false;
+        }
+    }
+    catch (Exception &ex)
+    {
+        LogMessage("Serial port error: " + ex.Message);
+        return false;
+    }
+}
+
+//---------------------------------------------------------------------------
+// 시리얼 포트 닫기
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::CloseSerialPort(TEspLink* L)
+{
+    try
+    {
+        if (L->Comm && L->Comm->Active())
+        {
+            L->Comm->Close();
+            L->Opened = false;
+            L->WaitingAck = false;
+            LogMessage(LinkTag(L) + "Serial port closed.");
+        }
+    }
+    catch (Exception &ex)
+    {
+        LogMessage("Error closing serial port: " + ex.Message);
+    }
+}
+
+//---------------------------------------------------------------------------
+// 링크 속도 변경 (포트를 닫지 않고 DCB만 교체)
+// VaComm의 Baudrate enum에 없는 속도도 드라이버가 지원하면 그대로 설정된다.
+//---------------------------------------------------------------------------
+bool __fastcall TGa1Agent::SetLinkBaud(TEspLink* L, int baudRate)
+{
+    HANDLE hPort = (HANDLE)L->Comm->Handle;
+    if (hPort == NULL || hPort == INVALID_HANDLE_VALUE)
+        return false;
+
+    DCB dcb;
+    ZeroMemory(&dcb, sizeof(dcb));
+    dcb.DCBlength = sizeof(dcb);
+
+    if (!GetCommState(hPort, &dcb))
+        return false;
+
+    dcb.BaudRate = (DWORD)baudRate;
+    if (!SetCommState(hPort, &dcb))
+        return false;
+
+    // 이전 속도로 받은 잔여 바이트는 의미가 없으므로 폐기
+    PurgeComm(hPort, PURGE_RXCLEAR);
+    RxReset(&L->Rx);
+
+    L->BaudRate = baudRate;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// 확장 프레임 전송만 (응답은 호출한 쪽에서 확인)
+//---------------------------------------------------------------------------
+bool __fastcall TGa1Agent::PostControlFrame(TEspLink* L, BYTE type, const BYTE* payload, int len)
+{
+    if (!L->Opened || L->Comm == NULL || !L->Comm->Active())
+        return false;
+
+    int frameLen = FrameBuildExt(L->CtrlBuf, type, payload, len);
+
+    TRxEvent stale;
+    PumpReceive(L);
+    while (RxNext(&L->Rx, &stale));
+
+    try
+    {
+        L->Comm->WriteBuf(L->CtrlBuf, frameLen);
+    }
+    catch (Exception &ex)
+    {
+        LogMessage(LinkTag(L) + "E:" + ex.Message);
+        return false;
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// 보오레이트 협상 시작 (현재 속도에서 요청 -> 전환 -> 무오류 프로브)
+// step 부터 낮은 후보 순으로 시도한다. 실패한 후보는 ESP32 의 복귀 시간만큼
+// 조용히 기다린 뒤 기본 속도로 돌아가 다음 후보로 넘어간다.
+// 응답/대기는 ServiceBaud 가 응답 확인 타이머마다 진행한다.
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::BeginBaud(TEspLink* L, int step)
+{
+    L->BaudState = BAUD_ST_IDLE;
+
+    for (; step < L->BaudStepCount; step++)
+    {
+        int baudRate = L->BaudSteps[step];
+        if (baudRate == L->BaudRate)
+            break;                      // 이미 그 속도
+
+        BYTE payload[4];
+        payload[0] = (BYTE)(baudRate & 0xFF);
+        payload[1] = (BYTE)((baudRate >> 8) & 0xFF);
+        payload[2] = (BYTE)((baudRate >> 16) & 0xFF);
+        payload[3] = (BYTE)((baudRate >> 24) & 0xFF);
+
+        if (!PostControlFrame(L, FRAME_BAUD, payload, 4))
+            return;
+
+        L->BaudStep = step;
+        L->BaudState = BAUD_ST_REQ;
+        L->BaudTick = GetTickCount();
+        return;
+    }
+
+    if (L->BaudRate != L->BaseBaud && step >= L->BaudStepCount)
+    {
+        // 더 낮은 후보가 없으면 기본 속도로 (ESP32는 복귀 시간 후 기본 속도)
+        L->BaudStep = step;
+        L->BaudState = BAUD_ST_REVERT;
+        L->BaudTick = GetTickCount();
+        return;
+    }
+
+    LogMessage(LinkTag(L) + "BAUD " + IntToStr(L->BaudRate) +
+               (L->BaudRate == L->BaseBaud ? " (base)" : ""));
+}
+
+//---------------------------------------------------------------------------
+// 프로브 하나 전송: 모든 바이트 값이 섞인 패턴
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::SendBaudProbe(TEspLink* L)
+{
+    BYTE payload[BAUD_PROBE_LEN];
+    int k = L->BaudProbe;
+
+    payload[0] = (BYTE)k;
+    for (int i = 1; i < BAUD_PROBE_LEN; i++)
+        payload[i] = (BYTE)(i * 37 + k);
+
+    if (!PostControlFrame(L, FRAME_PROBE, payload, BAUD_PROBE_LEN))
+    {
+        FailBaud(L, true);
+        return;
+    }
+    L->BaudState = BAUD_ST_PROBE;
+    L->BaudTick = GetTickCount();
+}
+
+//---------------------------------------------------------------------------
+// 후보 하나 실패 - 전환했으면 복귀 대기, 아니면 바로 다음 후보
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::FailBaud(TEspLink* L, bool switched)
+{
+    LogMessage(LinkTag(L) + "BAUD " + IntToStr(L->BaudSteps[L->BaudStep]) + " FAIL");
+
+    if (switched)
+    {
+        L->BaudState = BAUD_ST_REVERT;
+        L->BaudTick = GetTickCount();
+    }
+    else
+    {
+        BeginBaud(L, L->BaudStep + 1);
+    }
+}
+
+//---------------------------------------------------------------------------
+// 협상 한 단계 진행 (PollResponses - 대기 없음)
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::ServiceBaud(TEspLink* L)
+{
+    bool got = false;
+    if (L->BaudState == BAUD_ST_REQ || L->BaudState == BAUD_ST_PROBE)
+    {
+        PumpReceive(L);
+        got = RxNext(&L->Rx, &L->LastResp);
+    }
+    bool ok = got && L->LastResp.Cmd == RESP_CMD_ACK && L->LastResp.Status == RESP_STATUS_OK;
+    DWORD elapsed = GetTickCount() - L->BaudTick;
+
+    switch (L->BaudState)
+    {
+    case BAUD_ST_REQ:
+        if (!got && elapsed < BAUD_REQ_TMO_MS)
+            break;
+        if (!ok)
+            FailBaud(L, false);
+        else if (!SetLinkBaud(L, L->BaudSteps[L->BaudStep]))
+            FailBaud(L, true);
+        else
+        {
+            L->BaudState = BAUD_ST_SETTLE;
+            L->BaudTick = GetTickCount();
+        }
+        break;
+
+    case BAUD_ST_SETTLE:
+        if (elapsed < BAUD_SETTLE_MS)
+            break;
+        L->BaudProbe = 0;
+        SendBaudProbe(L);
+        break;
+
+    case BAUD_ST_PROBE:
+        if (!got && elapsed < BAUD_PROBE_TMO_MS)
+            break;
+        if (!ok)
+        {
+            FailBaud(L, true);
+        }
+        else if (++L->BaudProbe < BAUD_PROBE_COUNT)
+        {
+            SendBaudProbe(L);
+        }
+        else
+        {
+            L->BaudState = BAUD_ST_IDLE;
+            LogMessage(LinkTag(L) + "BAUD " + IntToStr(L->BaudRate) + " OK");
+        }
+        break;
+
+    case BAUD_ST_REVERT:
+        if (elapsed < BAUD_REVERT_MS)
+            break;
+        SetLinkBaud(L, L->BaseBaud);
+        BeginBaud(L, L->BaudStep + 1);
+        break;
+    }
+
+    // 협상 중에 들어온 쓰기 명령도 작업자에 넘김 (응답은 협상이 끝난 뒤)
+    ServiceCommands(L);
+}
+
+//---------------------------------------------------------------------------
+// 자동 보오레이트: 후보를 높은 순으로 시도해 처음 통과한 속도로 확정
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::AutoBaud(TEspLink* L)
+{
+    BeginBaud(L, 0);
+}
+
+//---------------------------------------------------------------------------
+// 전송 결과 누적 - 최근 20회 중 25% 이상 실패하면 한 단계 낮춤
+// 낮추는 협상은 시작만 하고 이후 단계는 ServiceBaud 가 진행한다.
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::TrackLinkErrors(TEspLink* L, bool ok)
+{
+    L->WinSends++;
+    if (!ok) L->WinFails++;
+
+    bool elevated = (L->WinSends >= 8 && L->WinFails * 4 >= L->WinSends);
+    if (!elevated)
+    {
+        if (L->WinSends >= 20)
+        {
+            L->WinSends = 0;
+            L->WinFails = 0;
+        }
+        return;
+    }
+
+    L->WinSends = 0;
+    L->WinFails = 0;
+
+    if (!L->AutoBaud || L->BaudRate == L->BaseBaud || L->BaudState != BAUD_ST_IDLE)
+        return;
+
+    LogMessage(LinkTag(L) + "BAUD ERR " + IntToStr(L->BaudRate));
+
+    int step = 0;
+    while (step < L->BaudStepCount && L->BaudSteps[step] >= L->BaudRate)
+        step++;
+    BeginBaud(L, step);
+}
+
+//---------------------------------------------------------------------------
+// 체크섬 계산 (XOR)
+//---------------------------------------------------------------------------
+BYTE __fastcall TGa1Agent::CalcChecksum(BYTE* data, int len)
+{
+    return ProtoChecksum(data, len);
+}
+
+// 패킷 생성 (프레임 이미지 전체 재구성)
+// 프로토콜: [STX][LEN_L][LEN_H][CNT][ID_L][ID_H][Q][VAL0][VAL1][VAL2][VAL3]...[CHK][ETX]
+// 스키마 포트는 FRAME_VALUES (ID 없이 스키마 해시 + 슬롯 순서의 Q/VAL)
+// 아이템 테이블이 확정될 때 한 번만 호출하고, 이후에는 UpdateFrameItem이
+// 바뀐 Q/VAL 바이트만 패치한다.
+//---------------------------------------------------------------------------
+int __fastcall TGa1Agent::BuildPacket(TEspLink* L)
+{
+    if (L->Schema)
+    {
+        // 슬롯 배치/타입이 바뀌었으면 다음 전송 전에 사전부터
+        DWORD hash;
+        BuildSchema(L, m_SchemaBuf, &hash);
+        if (hash != L->SchemaHash)
+        {
+            L->SchemaHash = hash;
+            L->SchemaPending = true;
+        }
+        FrameLayoutValues(&L->Frame, L->FrameBuf, L->SlotCount, hash);
+    }
+    else
+    {
+        // 데이터 프레임은 CNT 1바이트 - 넘는 슬롯은 프레임에 실리지 않음
+        if (L->SlotCount > FRAME_ITEMS_MAX)
+            LogMessage(LinkTag(L) + "ITEM:" + IntToStr(L->SlotCount) + " > " +
+                       IntToStr(FRAME_ITEMS_MAX) + " (Schema=1)");
+        FrameLayout(&L->Frame, L->FrameBuf, L->SlotCount);
+    }
+
+    // 슬롯 배치가 바뀌면 쌓인 샘플은 의미가 없음
+    LinkClearSamples(L);
+
+    for (int k = 0; k < L->SlotCount; k++)
+    {
+        TOPCItemInfo* item = &m_Items[L->Slots[k]];
+        L->SlotID[k] = (WORD)item->ItemID;
+        FrameSetItem(&L->Frame, k, (WORD)item->ItemID, item->QCode, item->Value);
+    }
+
+    FrameSeal(&L->Frame);
+    return L->Frame.Length;
+}
+
+//---------------------------------------------------------------------------
+// 스키마 타입 (CSV DataType -> SCHEMA_TYPE_xxx, VariantToLong 의 변환 배율)
+//---------------------------------------------------------------------------
+static BYTE SchemaTypeOf(const String &dataType, signed char* scale)
+{
+    *scale = 0;
+    if (dataType == "REAL" || dataType == "FLOAT" || dataType == "LREAL" || dataType == "DOUBLE")
+    {
+        *scale = -3;                    // VT_R4/VT_R8 는 x1000 고정소수점
+        return SCHEMA_TYPE_REAL;
+    }
+    if (dataType == "BOOL" || dataType == "EBOOL")
+        return SCHEMA_TYPE_BOOL;
+    if (dataType == "DATE" || dataType == "DT" || dataType == "TIME")
+        return SCHEMA_TYPE_TIME;
+    return SCHEMA_TYPE_INT;
+}
+
+//---------------------------------------------------------------------------
+// 스키마 payload 작성 (슬롯 순서, payload 길이 반환)
+// 짧은 이름은 태그의 장치 접두어("Gabbiani!")를 뺀 부분
+//---------------------------------------------------------------------------
+int __fastcall TGa1Agent::BuildSchema(TEspLink* L, BYTE* payload, DWORD* hash)
+{
+    int pos = SCHEMA_HDR_LEN;
+
+    for (int k = 0; k < L->SlotCount; k++)
+    {
+        TOPCItemInfo* item = &m_Items[L->Slots[k]];
+        signed char scale;
+        BYTE type = SchemaTypeOf(item->DataType, &scale);
+
+        const char* tag = item->TagName.c_str();
+        int bang = item->TagName.Pos("!");
+        const char* name = tag + bang;
+        int nameLen = item->TagName.Length() - bang;
+
+        pos += SchemaPutEntry(payload + pos, (WORD)item->ItemID, type, scale, name, nameLen);
+    }
+
+    return SchemaSeal(payload, L->SlotCount, pos - SCHEMA_HDR_LEN, hash);
+}
+
+//---------------------------------------------------------------------------
+// 스키마 사전 전송 (링크가 올라올 때 / 해시가 바뀔 때 / ESP32 가 요청할 때)
+// 보내기만 하고 응답은 ServiceSchema 가 응답 확인 타이머마다 확인한다.
+//---------------------------------------------------------------------------
+bool __fastcall TGa1Agent::PostSchema(TEspLink* L)
+{
+    if (!L->Opened || L->Comm == NULL || !L->Comm->Active())
+        return false;
+
+    DWORD hash;
+    int len = BuildSchema(L, m_SchemaBuf, &hash);
+    int frameLen = FrameBuildExt(m_SchemaFrame, FRAME_SCHEMA, m_SchemaBuf, len);
+
+    TRxEvent stale;
+    PumpReceive(L);
+    while (RxNext(&L->Rx, &stale));
+
+    try
+    {
+        L->Comm->WriteBuf(m_SchemaFrame, frameLen);
+    }
+    catch (Exception &ex)
+    {
+        LogMessage(LinkTag(L) + "E:" + ex.Message);
+        return false;
+    }
+
+    L->SchemaWait = true;
+    L->SchemaTick = GetTickCount();
+    L->SchemaTxHash = hash;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// 사전 응답 확인 (PollResponses - 대기 없음)
+// ACK 면 보류했던 데이터 프레임을 바로 보낸다 (주기는 응답까지 열려 있음).
+// 형식: SCHEMA 52 H:1A2B3C4D OK
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::ServiceSchema(TEspLink* L)
+{
+    PumpReceive(L);
+    bool got = RxNext(&L->Rx, &L->LastResp);
+    ServiceCommands(L);
+
+    if (!got && GetTickCount() - L->SchemaTick < SCHEMA_TMO_MS)
+        return;
+
+    bool ok = got && L->LastResp.Cmd == RESP_CMD_ACK && L->LastResp.Status == RESP_STATUS_OK;
+    L->SchemaWait = false;
+
+    LogMessage(LinkTag(L) + "SCHEMA " + IntToStr(L->SlotCount) + " H:" + IntToHex((int)L->SchemaTxHash, 8) +
+               (ok ? " OK" : " FAIL"));
+
+    if (!ok)
+    {
+        TrackLinkErrors(L, false);
+        HandleSendFailure(L);
+        return;
+    }
+
+    // 기다리는 동안 슬롯 배치가 바뀌었으면 새 사전부터 다시
+    if (L->SchemaTxHash == L->SchemaHash)
+        L->SchemaPending = false;
+    ScheduleLink(L);
+}
+
+//---------------------------------------------------------------------------
+// 포트 전송 준비 (프레임 배치 + 현재 값을 변경 감지 기준으로)
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::PrepareLink(TEspLink* L)
+{
+    BuildPacket(L);
+    L->SchemaPending = L->Schema;
+
+    for (int k = 0; k < L->SlotCount; k++)
+    {
+        L->AckValue[k] = m_Items[L->Slots[k]].Value;
+        L->AckQCode[k] = m_Items[L->Slots[k]].QCode;
+    }
+
+    L->FirstSend = true;
+    L->LastSendTick = 0;
+}
+
+//---------------------------------------------------------------------------
+// 프레임 이미지 증분 패치 (읽기 직후 호출, 바뀐 바이트만 기록 + 체크섬 갱신)
+// 이 아이템을 보내는 모든 포트의 프레임에 반영
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::UpdateFrameItem(int index)
+{
+    if (index < 0 || index >= m_ItemCount)
+        return;
+
+    BYTE quality = m_Items[index].QCode;
+    long value = m_Items[index].Value;
+
+    for (int l = 0; l < m_nLinkCount; l++)
+    {
+        int slot = m_Items[index].LinkSlot[l];
+        if (slot >= 0 && slot < m_Links[l].Frame.Count)
+            FramePatch(&m_Links[l].Frame, slot, quality, value);
+    }
+}
+
+//---------------------------------------------------------------------------
+// 새 샘플을 포트별 전송 대기열에 넣기
+// 일반 포트는 슬롯 한 칸 (값은 이미 프레임 이미지에 패치됨) - 대기 중이던 슬롯이면
+// 합친 것으로 센다. 묶음 포트는 슬롯이 가득 차면 가장 오래된 샘플을 버리고 센다.
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::CaptureSample(int index)
+{
+    TOPCItemInfo* item = &m_Items[index];
+
+    for (int l = 0; l < m_nLinkCount; l++)
+    {
+        TEspLink* L = &m_Links[l];
+        int slot = item->LinkSlot[l];
+        if (slot < 0 || slot >= L->SlotCount)
+            continue;
+
+        if (LinkCapture(L, slot, item, GetTickCount()))
+            InterlockedIncrement(&m_Metrics.Link[l].Coalesced);
+    }
+}
+
+//---------------------------------------------------------------------------
+// 키프레임 압축 (원본보다 작을 때만 m_ZBuf 길이 반환, 아니면 0)
+//---------------------------------------------------------------------------
+int __fastcall TGa1Agent::CompressFrame(TEspLink* L)
+{
+    LARGE_INTEGER freq, t0, t1;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&t0);
+
+    int zLen = FrameBuildLz(&m_Lz, &L->Frame, m_ZScratch, m_ZBuf);
+
+    QueryPerformanceCounter(&t1);
+    L->Stats.ZCpuUs += (double)(t1.QuadPart - t0.QuadPart) * 1000000.0 / freq.QuadPart;
+    L->Stats.ZRawBytes += L->Frame.Length;
+    L->Stats.ZOutBytes += (zLen > 0) ? zLen : L->Frame.Length;
+    if (zLen > 0) L->Stats.ZFrames++;
+
+    return zLen;
+}
+
+//---------------------------------------------------------------------------
+// 압축 통계 요약 (형식: ZS:100 R:56.4% CPU:18us)
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::LogLinkStats(TEspLink* L)
+{
+    if (L->Stats.ZRawBytes == 0 || L->Stats.Frames == 0)
+        return;
+
+    double ratio = 100.0 * L->Stats.ZOutBytes / L->Stats.ZRawBytes;
+    double cpu = L->Stats.ZCpuUs / L->Stats.Frames;
+
+    char msg[64];
+    int len = PutLinkTag(msg, L);
+    len += sprintf(msg + len, "ZS:%d R:%.1f%% CPU:%dus", (int)L->Stats.ZFrames, ratio, (int)cpu);
+    LogText(msg, len);
+
+    ZeroMemory(&L->Stats, sizeof(L->Stats));
+}
+
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::ServiceCommands(TEspLink* L)
+{
+    TRxCommand cmd;
+    while (RxNextCommand(&L->Rx, &cmd))
+    {
+        if (cmd.Type == FRAME_RESYNC)
+        {
+            // 다음 주기에 전체 데이터 (변경/생존 확인과 무관하게)
+            if (!L->Resync)
+                LogMessage(LinkTag(L) + "RESYNC");
+            L->Resync = true;
+        }
+        else
+        {
+            StartWrite(L, &cmd);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+TOpcWorker* __fastcall TGa1Agent::WorkerFor(const String &server)
+{
+    for (int w = 0; w < m_nWorkerCount; w++)
+    {
+        if (m_Workers[w]->ProgID.AnsiCompareIC(server) == 0)
+            return m_Workers[w];
+    }
+    return NULL;
+}
+
+//---------------------------------------------------------------------------
+// 쓰기 값 변환 (프레임의 long -> 아이템 타입, VariantToLong 의 역변환)
+//---------------------------------------------------------------------------
+static void WriteVariant(const TOPCItemInfo* item, long value, VARIANT* v)
+{
+    VariantInit(v);
+    if (item->DataType == "REAL" || item->DataType == "FLOAT" ||
+        item->DataType == "LREAL" || item->DataType == "DOUBLE")
+    {
+        v->vt = VT_R8;
+        v->dblVal = value / 1000.0;
+    }
+    else if (item->DataType == "BOOL" || item->DataType == "EBOOL")
+    {
+        v->vt = VT_BOOL;
+        v->boolVal = value ? VARIANT_TRUE : VARIANT_FALSE;
+    }
+    else
+    {
+        v->vt = VT_I4;
+        v->lVal = value;
+    }
+}
+
+//---------------------------------------------------------------------------
+// 쓰기 명령 시작 - 아이템을 담당 작업자 대기열에 넣음
+// 명령 번호 = (일련번호 << 4) | 슬롯
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::StartWrite(TEspLink* L, const TRxCommand* cmd)
+{
+    BYTE seq;
+    TWriteItem items[WRITE_MAX];
+    int count = WriteParse(cmd, &seq, items);
+    if (count < 0)
+    {
+        LogMessage(LinkTag(L) + "WR BAD");
+        return;
+    }
+
+    int slot = -1;
+    for (int s = 0; s < WRITE_QUEUE; s++)
+    {
+        if (!m_WriteCmds[s].InUse)
+        {
+            slot = s;
+            break;
+        }
+    }
+
+    if (slot < 0)
+    {
+        // 처리 중인 명령이 너무 많음 - 바로 거절
+        BYTE busy[WRITE_MAX];
+        for (int n = 0; n < count; n++)
+            busy[n] = WRITE_ERR_BUSY;
+        LogMessage(LinkTag(L) + "WR " + IntToStr(count) + " BUSY");
+        if (L->Down || !L->Opened || L->Comm == NULL || !L->Comm->Active() ||
+            L->BaudState != BAUD_ST_IDLE)
+            return;
+
+        int len = WriteBuildAck(m_WriteAck, seq, 0, busy, count);
+        try
+        {
+            L->Comm->WriteBuf(m_WriteAck, len);
+        }
+        catch (Exception &ex)
+        {
+            LogMessage(LinkTag(L) + "E:" + ex.Message);
+            LinkDown(L, "WR");
+        }
+        return;
+    }
+
+    TWriteCmd* c = &m_WriteCmds[slot];
+    int id = (++m_nWriteSerial << 4) | slot;
+
+    InterlockedIncrement(&m_Metrics.WriteCmds);
+
+    EnterCriticalSection(&m_csWrite);
+    c->InUse = true;
+    c->Serial = m_nWriteSerial;
+    c->Link = (int)(L - m_Links);
+    c->Seq = seq;
+    c->Count = count;
+    c->Pending = count;
+    c->RecvTick = GetTickCount();
+    QueryPerformanceCounter(&c->RecvTime);
+    c->DoneTime = c->RecvTime;
+    for (int n = 0; n < count; n++)
+        c->Result[n] = WRITE_ERR_TMO;
+    LeaveCriticalSection(&m_csWrite);
+
+    for (int n = 0; n < count; n++)
+    {
+        BYTE result = WRITE_OK;
+        int i = FindItem(m_nItemGen, items[n].ID);
+        TOpcWorker* worker = (i >= 0) ? WorkerFor(m_Items[i].Server) : NULL;
+
+        if (i < 0)
+        {
+            result = WRITE_ERR_ID;
+        }
+        else if (worker == NULL)
+        {
+            result = WRITE_ERR_COMM;
+        }
+        else
+        {
+            VARIANT v;
+            WriteVariant(&m_Items[i], items[n].Value, &v);
+            if (!worker->PostWrite(id, n, m_nItemGen, i, v))
+                result = WRITE_ERR_BUSY;
+            VariantClear(&v);
+        }
+
+        if (result != WRITE_OK)
+            CompleteWrite(id, n, result);
+    }
+}
+
+//---------------------------------------------------------------------------
+// 아이템 하나의 쓰기 결과 (작업자 스레드 또는 메인 스레드)
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::CompleteWrite(int cmd, int pos, BYTE result)
+{
+    TWriteCmd* c = &m_WriteCmds[cmd & (WRITE_QUEUE - 1)];
+
+    EnterCriticalSection(&m_csWrite);
+    if (c->InUse && c->Serial == (cmd >> 4) && pos < c->Count && c->Pending > 0)
+    {
+        c->Result[pos] = result;
+        if (--c->Pending == 0)
+            QueryPerformanceCounter(&c->DoneTime);
+    }
+    LeaveCriticalSection(&m_csWrite);
+}
+
+//---------------------------------------------------------------------------
+// 결과가 다 모였거나 제한 시간이 지난 명령에 응답
+// 형식: WR 3 OK:3 T:14.2ms
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::FinishWrites()
+{
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+
+    for (int s = 0; s < WRITE_QUEUE; s++)
+    {
+        TWriteCmd* c = &m_WriteCmds[s];
+        if (!c->InUse)
+            continue;
+
+        // 속도 협상 중인 포트는 끝난 뒤에 응답 (ESP32 쪽은 제한 시간으로 처리)
+        if (m_Links[c->Link].BaudState != BAUD_ST_IDLE)
+            continue;
+
+        EnterCriticalSection(&m_csWrite);
+        bool done = (c->Pending == 0);
+        bool expired = !done && (GetTickCount() - c->RecvTick >= WRITE_TIMEOUT_MS);
+        if (done || expired)
+            c->InUse = false;       // 이후 늦은 결과 보고는 무시됨
+        LeaveCriticalSection(&m_csWrite);
+
+        if (!done && !expired)
+            continue;
+
+        double ms = done ? (double)(c->DoneTime.QuadPart - c->RecvTime.QuadPart) * 1000.0 / freq.QuadPart
+                         : (double)WRITE_TIMEOUT_MS;
+        int ok = 0;
+        for (int n = 0; n < c->Count; n++)
+        {
+            if (c->Result[n] == WRITE_OK)
+                ok++;
+        }
+
+        TEspLink* L = &m_Links[c->Link];
+        if (!L->Down && L->Opened && L->Comm != NULL && L->Comm->Active())
+        {
+            int len = WriteBuildAck(m_WriteAck, c->Seq, (int)(ms + 0.5), c->Result, c->Count);
+            try
+            {
+                L->Comm->WriteBuf(m_WriteAck, len);
+            }
+            catch (Exception &ex)
+            {
+                LogMessage(LinkTag(L) + "E:" + ex.Message);
+                LinkDown(L, "WR");
+            }
+        }
+
+        if (m_bBinLog)
+        {
+            TBinLogRec r;
+            ZeroMemory(&r, sizeof(r));
+            r.Code = BLOG_WRITE;
+            r.Link = (m_nLinkCount > 1) ? (BYTE)(c->Link + 1) : 0;
+            r.Result = expired ? BLOG_RES_TMO : BLOG_RES_OK;
+            r.Items = (WORD)c->Count;
+            r.Changes = (WORD)ok;
+            r.Extra = (WORD)((ms < 65535) ? ms + 0.5 : 65535);
+            BinLogEvent(&r);
+        }
+        else
+        {
+            LogMessage(LinkTag(L) + "WR " + IntToStr(c->Count) + " OK:" + IntToStr(ok) +
+                       (expired ? String(" TMO") : " T:" + FloatToStrF(ms, ffFixed, 7, 1) + "ms"));
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+// 우선 전송 (주기 시작 / PollResponses - 모두 메인 스레드 이벤트 루프)
+// 표시된 변경을 모아 포트마다 그 포트가 보내는 아이템만 골라 FRAME_PRIORITY 로
+// 바로 쓴다. ACK 기준값(AckValue)은 건드리지 않으므로 같은 변경이 다음 데이터
+// 프레임에도 실린다. 지연은 프레임 안에서 가장 먼저 표시된 변경 기준.
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::SendPriority()
+{
+    if (InterlockedExchange(&m_lPrioPending, 0) == 0)
+        return;
+
+    int n = 0;
+    EnterCriticalSection(&m_csItems);
+    for (int i = 0; i < m_ItemCount; i++)
+    {
+        TOPCItemInfo* item = &m_Items[i];
+        if (!item->PrioPending)
+            continue;
+
+        TPrioEdge* e = &m_PrioEdges[n++];
+        e->Index = i;
+        e->Value = item->PrioValue;
+        e->QCode = item->PrioQCode;
+        e->Time = item->PrioTime;
+        item->PrioPending = false;
+    }
+    LeaveCriticalSection(&m_csItems);
+
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+
+    for (int l = 0; l < m_nLinkCount; l++)
+    {
+        TEspLink* L = &m_Links[l];
+        if (L->Down || !L->Opened || L->Comm == NULL || !L->Comm->Active() ||
+            L->BaudState != BAUD_ST_IDLE)
+            continue;
+
+        int k = 0;
+        while (k < n)
+        {
+            int count = 0;
+            int len = PRIO_HDR_LEN;
+            LONGLONG first = 0;
+
+            for (; k < n && count < PRIO_MAX; k++)
+            {
+                const TPrioEdge* e = &m_PrioEdges[k];
+                const TOPCItemInfo* item = &m_Items[e->Index];
+                if (item->LinkSlot[l] < 0)
+                    continue;
+
+                len += PriorityPutItem(m_PrioPayload + len, (WORD)item->ItemID, e->QCode, e->Value);
+                if (count == 0 || e->Time.QuadPart < first)
+                    first = e->Time.QuadPart;
+                count++;
+            }
+            if (count == 0)
+                break;
+
+            PrioritySeal(m_PrioPayload, ++L->PrioSeq, count);
+            int frameLen = FrameBuildExt(m_PrioFrame, FRAME_PRIORITY, m_PrioPayload, len);
+
+            try
+            {
+                L->Comm->WriteBuf(m_PrioFrame, frameLen);
+            }
+            catch (Exception &ex)
+            {
+                LogMessage(LinkTag(L) + "E:" + ex.Message);
+                LinkDown(L, "WR");
+                break;
+            }
+
+            LARGE_INTEGER now;
+            QueryPerformanceCounter(&now);
+            double ms = (double)(now.QuadPart - first) * 1000.0 / freq.QuadPart;
+            LONG us = (LONG)(ms * 1000.0 + 0.5);
+
+            TLinkMetrics* M = &m_Metrics.Link[l];
+            InterlockedIncrement(&M->PrioFrames);
+            InterlockedExchangeAdd(&M->TxBytes, frameLen);
+            InterlockedExchange(&m_Metrics.PrioLatencyUs, us);
+            // 누적은 ms 단위 (us 로 쌓으면 약 2147초에 음수로 넘어감) - 1ms 미만은
+            // 다음 프레임으로 넘겨 짧은 지연도 평균에서 빠지지 않게 한다
+            m_nPrioLatRemUs += us;
+            InterlockedExchangeAdd(&m_Metrics.PrioLatencyMsSum, m_nPrioLatRemUs / 1000);
+            m_nPrioLatRemUs %= 1000;
+
+            if (m_bBinLog)
+            {
+                TBinLogRec r;
+                ZeroMemory(&r, sizeof(r));
+                r.Code = BLOG_PRIO;
+                r.Link = (m_nLinkCount > 1) ? (BYTE)(l + 1) : 0;
+                r.Result = BLOG_RES_OK;
+                r.Items = (WORD)count;
+                r.Bytes = (WORD)frameLen;
+                r.Extra = (WORD)((ms < 6553.5) ? ms * 10 + 0.5 : 65535);
+                BinLogEvent(&r);
+            }
+            else
+            {
+                char msg[64];
+                int msgLen = PutLinkTag(msg, L);
+                msgLen += sprintf(msg + msgLen, "A:%d TX:%d L:%.1fms", count, frameLen, ms);
+                LogText(msg, msgLen);
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+// 포트별 전송 판단: 최초 OR 변경 OR Heartbeat
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::ScheduleLink(TEspLink* L)
+{
+    //------------------------------------------------------------------
+    // 1. 변경 여부 확인 및 변경 개수 카운트
+    //------------------------------------------------------------------
+    int changeCount = LinkChanges(L);
+    bool hasChanges = (changeCount > 0);
+
+    //------------------------------------------------------------------
+    // 2. Heartbeat 타임아웃 확인 (생존 확인 포트는 Keepalive 주기)
+    //------------------------------------------------------------------
+    DWORD dwNow = GetTickCount();
+    DWORD idleMs = (L->KeepaliveMs > 0) ? L->KeepaliveMs : L->HeartbeatMs;
+    bool heartbeatTimeout = false;
+
+    if (L->LastSendTick == 0)
+    {
+        heartbeatTimeout = true;
+    }
+    else
+    {
+        DWORD elapsed;
+        if (dwNow >= L->LastSendTick)
+            elapsed = dwNow - L->LastSendTick;
+        else
+            elapsed = (0xFFFFFFFF - L->LastSendTick) + dwNow + 1;
+
+        if (elapsed >= idleMs)
+            heartbeatTimeout = true;
+    }
+
+    //------------------------------------------------------------------
+    // 3. 묶음 전송 포트: 값 변경은 샘플로만 전달 (샘플이 차거나 최대 지연 시 전송)
+    //    쌓인 샘플이 없을 때만 Heartbeat 로 일반 프레임
+    //------------------------------------------------------------------
+    if (L->Batch > 0 && !L->FirstSend && !L->Resync)
+    {
+        if (L->SampleTotal > 0)
+        {
+            // 묶음 프레임은 아이템마다 ID 를 실으므로 스키마 사전이 필요 없다
+            if (L->BatchFull || dwNow - L->BatchTick >= L->BatchMs)
+            {
+                SendToESP32(L, 0, false, true);
+                L->LastSendTick = GetTickCount();
+            }
+            return;
+        }
+        hasChanges = false;
+        changeCount = 0;
+    }
+
+    //------------------------------------------------------------------
+    // 4. 생존 확인 포트: 값이 그대로이면 SEQ + 다이제스트만
+    //------------------------------------------------------------------
+    if (L->KeepaliveMs > 0 && heartbeatTimeout && !hasChanges && !L->FirstSend && !L->Resync)
+    {
+        SendKeepalive(L);
+        L->LastSendTick = GetTickCount();
+        return;
+    }
+
+    //------------------------------------------------------------------
+    // 5. 전송 조건: 최초 OR 재동기 요청 OR 변경 OR Heartbeat
+    //------------------------------------------------------------------
+    if (L->FirstSend || L->Resync || hasChanges || heartbeatTimeout)
+    {
+        // 사전이 없으면 ESP32 가 위치 기반 프레임을 해석할 수 없으므로 보류
+        // (사전 ACK 를 받으면 ServiceSchema 가 이 함수를 다시 부른다)
+        if (L->SchemaPending && L->Opened)
+        {
+            if (!L->SchemaWait && !PostSchema(L))
+            {
+                TrackLinkErrors(L, false);
+                HandleSendFailure(L);
+            }
+            return;
+        }
+
+        bool isHB = heartbeatTimeout && !hasChanges && !L->FirstSend && !L->Resync;
+
+        SendToESP32(L, changeCount, isHB);
+        L->LastSendTick = GetTickCount();
+
+        L->FirstSend = false;
+    }
+}
+
+//---------------------------------------------------------------------------
+// ESP32로 데이터 전송 (전송만 하고 응답은 PollResponses에서 처리)
+// 포트마다 독립된 응답 대기 상태를 가지므로 한 포트의 타임아웃이
+// 다른 포트의 전송을 막지 않는다.
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::SendToESP32(TEspLink* L, int changeCount, bool isHeartbeat, bool batch)
+{
+    if (!L->Opened || L->Comm == NULL || !L->Comm->Active())
+    {
+        LinkDown(L, "GONE");
+        return;
+    }
+
+    try
+    {
+        // 프레임 이미지는 읽기 시점에 이미 패치되어 있음
+        BYTE* txBuf = L->Frame.Buf;
+        int packetLen = L->Frame.Length;
+
+        // 압축해서 더 작아질 때만 압축 프레임 사용
+        int samples = 0;
+        int zLen = (L->Compress && !batch) ? CompressFrame(L) : 0;
+        if (zLen > 0)
+        {
+            txBuf = m_ZBuf;
+            packetLen = zLen;
+        }
+        else if (batch)
+        {
+            packetLen = LinkBuildBatch(L, m_BatchFrame, &samples);
+            txBuf = m_BatchFrame;
+        }
+
+        // 이전 주기의 늦은 응답 정리 (일괄 읽기 후 디코드해서 버림)
+        TRxEvent stale;
+        PumpReceive(L);
+        while (RxNext(&L->Rx, &stale));
+    
+		// 로그 출력 시
+#if	HK_DEBUG
+	    // 상세 로그 (HEX 덤프 등)
+    	String hexDump = LinkTag(L) + "TX: ";
+	    for (int i = 0; i < packetLen; i++) hexDump += IntToHex(txBuf[i], 2) + " ";
+	    LogMessage(hexDump);
+#endif
+        // 전송
+        L->Comm->WriteBuf(txBuf, packetLen);
+
+        // 응답 대기 상태로 (로그는 응답 시 완성)
+        LinkSent(L, packetLen, (zLen > 0) ? L->Frame.Length : 0, changeCount, samples,
+                 isHeartbeat, false, GetTickCount());
+    }
+    catch (Exception &ex)
+    {
+        LogMessage(LinkTag(L) + "E:" + ex.Message);
+        LinkDown(L, "WR");
+    }
+}
+
+//---------------------------------------------------------------------------
+// 생존 확인 전송 (응답은 데이터 프레임과 같이 PollResponses 에서)
+// 다이제스트는 현재 프레임 이미지 기준 - 변경이 없을 때만 보내므로 ESP32 가
+// 마지막으로 받은 값과 같아야 한다.
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::SendKeepalive(TEspLink* L)
+{
+    if (!L->Opened || L->Comm == NULL || !L->Comm->Active())
+    {
+        LinkDown(L, "GONE");
+        return;
+    }
+
+    try
+    {
+        int len = KeepaliveBuild(L->CtrlBuf, ++L->KeepaliveSeq, FrameDigest(&L->Frame));
+
+        TRxEvent stale;
+        PumpReceive(L);
+        while (RxNext(&L->Rx, &stale));
+
+        L->Comm->WriteBuf(L->CtrlBuf, len);
+
+        LinkSent(L, len, 0, 0, 0, true, true, GetTickCount());
+    }
+    catch (Exception &ex)
+    {
+        LogMessage(LinkTag(L) + "E:" + ex.Message);
+        LinkDown(L, "WR");
+    }
+}
+
+//---------------------------------------------------------------------------
+// 전송 완료 처리 (ACK / NAK / 타임아웃) + 컴팩트 로그
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::CompleteSend(TEspLink* L, bool ok)
+{
+    L->WaitingAck = false;
+
+    TLinkMetrics* M = &m_Metrics.Link[L - m_Links];
+    InterlockedIncrement(&M->Frames);
+    InterlockedExchangeAdd(&M->TxBytes, L->TxLen);
+    if (ok)
+        InterlockedIncrement(&M->Acks);
+    else if (L->LastResp.Cmd == RESP_CMD_NAK)
+        InterlockedIncrement(&M->Naks);
+    else
+        InterlockedIncrement(&M->Timeouts);
+
+    if (m_bBinLog)
+    {
+        TBinLogRec r;
+        r.Code = BLOG_DATA;
+        r.Link = (m_nLinkCount > 1) ? (BYTE)(L - m_Links + 1) : 0;
+        r.Flags = (L->TxHeartbeat ? BLOG_F_HB : 0) | (L->TxRawLen > 0 ? BLOG_F_Z : 0) |
+                  (L->TxSamples > 0 ? BLOG_F_BATCH : 0) | (L->TxKeepalive ? BLOG_F_KA : 0);
+        r.Items = (WORD)L->SlotCount;
+        r.Changes = (WORD)L->TxChanges;
+        r.Bytes = (WORD)L->TxLen;
+        r.Extra = (WORD)((L->TxSamples > 0) ? L->TxSamples : L->TxRawLen);
+        if (ok)
+            r.Result = BLOG_RES_OK;
+        else if (L->LastResp.Cmd == RESP_CMD_NAK)
+            r.Result = (BYTE)(BLOG_RES_NAK | (L->LastResp.Status & 0x7F));
+        else
+            r.Result = BLOG_RES_TMO;
+        BinLogEvent(&r);
+    }
+
+    // 컴팩트 로그 (ScanCycle.cpp, 스택 버퍼)
+    char logMsg[128];
+    int len = PutLinkTag(logMsg, L);
+    len += LinkFormatResult(logMsg + len, L, ok);
+
+    if (ok)
+    {
+        // 성공 - ACK 기준값/대기열 갱신
+        TrackLinkErrors(L, true);
+        LinkAcked(L);
+        L->RetryCount = 0;
+    }
+    else if (L->TxKeepalive && L->LastResp.Cmd == RESP_CMD_NAK && L->LastResp.Status == RESP_STATUS_RESYNC)
+    {
+        // 링크는 살아 있고 ESP32 의 값만 어긋남 - 다음 주기에 전체 데이터
+        TrackLinkErrors(L, true);
+        L->RetryCount = 0;
+        L->Resync = true;
+    }
+    else
+    {
+        // 실패
+        if (L->Schema && L->LastResp.Cmd == RESP_CMD_NAK && L->LastResp.Status == RESP_STATUS_SCHEMA)
+            L->SchemaPending = true;
+        TrackLinkErrors(L, false);
+        HandleSendFailure(L);
+    }
+
+    if (!m_bBinLog)
+        LogText(logMsg, len);
+
+    L->Stats.Frames++;
+    if (L->Compress && (L->Stats.Frames % 100) == 0) LogLinkStats(L);
+}
+
+//---------------------------------------------------------------------------
+// 서비스 시작 (로그 간소화 - 해당 부분만 수정)
+//---------------------------------------------------------------------------
+/*
+ServiceStart 함수 내 LogMessage 호출 부분을 아래와 같이 간소화:
+
+기존 → 변경
+"=== Service Starting ===" → "SVC START"
+"Step 1: Opening Serial Port..." → (삭제)
+"Serial port COM17 opened at 115200 bps" → "COM17 OK 115200"
+"Success: OPC Server Connected." → "OPC OK"
+"Step 3: Registering OPC Items..." → (삭제)
+"  Registered: Random.Int1" → (삭제 또는 "+" + TagName)
+"Step 4: Timer Started (5 sec interval)." → "TMR OK"
+"=== Service Started Successfully ===" → "SVC READY"
 */
 //---------------------------------------------------------------------------
-//  
+// 서비스 시작
 //---------------------------------------------------------------------------
 void __fastcall TGa1Agent::ServiceStart(TService *Sender, bool &Started)
 {
+    // 수집 주기는 이벤트 루프 타이머 (Timer1 은 폼에만 남아 있고 쓰지 않음)
     if (Timer1) Timer1->Enabled = false;
+    ReactorInit(&m_Reactor);
+    m_Reactor.MsgMask = QS_ALLINPUT;    // 서비스 제어 요청/포트 창 메시지에도 깨어남
 
-    // STA  COM ʱȭ (OPC Automation STA ʿ)
+    // STA 모드로 COM 초기화 (OPC Automation은 STA 필요)
     CoInitialize(NULL);
 
     LogMessage("SVC START");
@@ -628,14 +3206,16 @@ void __fastcall TGa1Agent::ServiceStart(TService *Sender, bool &Started)
 
     try
     {
-        // 0. INI  ε
+        // 0. INI 설정 로드
         LoadSettings();
 
-        // 1. CSV   ε
+        // 1. CSV 설정 파일 로드
         String exePath = ExtractFilePath(ParamStr(0));
         String configFile = exePath + "oem_param.csv";
 
-        if (!LoadItemConfig(configFile))
+        // CSV 가 그대로면 캐시 이미지로 (파싱 생략)
+        if (!LoadItemCache(configFile, m_Items, m_ItemCount) &&
+            !LoadItemConfig(configFile, m_Items, m_ItemCount))
         {
             LogMessage("CFG: default");
 
@@ -648,127 +3228,99 @@ void __fastcall TGa1Agent::ServiceStart(TService *Sender, bool &Started)
 
             for (int i = 0; i < m_ItemCount; i++)
             {
-                m_Items[i].pItem = NULL;
+                m_Items[i].Server = m_DefaultServer;
+                m_Items[i].Priority = 0;
+                m_Items[i].PrioArmed = false;
+                m_Items[i].PrioPending = false;
                 m_Items[i].Quality = 0;
-                m_Items[i].Changed = false;
-                VariantInit(&m_Items[i].varValue);
-                VariantInit(&m_Items[i].varPrevValue);
+                m_Items[i].SrcTime = 0;
+                m_Items[i].TimeMs = 0;
+                m_Items[i].Dirty = false;
+                m_Items[i].Value = 0;
+                m_Items[i].QCode = 0;
+                m_Items[i].ServerHandle = 0;
+                m_Items[i].AddError = S_OK;
+                m_Items[i].RawValue = 0;
             }
         }
 
-        // 2. ø Ʈ ʱȭ
-        if (!InitSerialPort(m_nComPort, m_nBaudRate))
-        {
-            LogMessage("COM FAIL");
-        }
-
-        // 3. OPC  
-        OPCServer = CoOPCServer::Create();
-#if SERVER_SIMULATE
-        OPCServer->Connect(WideString("Matrikon.OPC.Simulation.1"), TNoParam());
-#else
-        OPCServer->Connect(WideString("Schneider-Aut.OFS.2"), TNoParam());
-#endif
-        LogMessage("OPC OK");
+        BuildItemIndex(m_nItemGen, m_ItemCount);
 
-        // 4. ׷ 
-        OPCGroups = OPCServer->OPCGroups;
-        OPCGroups->DefaultGroupIsActive = true;
-        OPCGroups->DefaultGroupUpdateRate = 1000;
+        // 포트별 아이템 부분집합
+        AssignLinkItems();
 
-        IOPCGroup *tempGroup = NULL;
-        OPCGroups->Add(TVariant(WideString("TestGroup")), &tempGroup);
-        MyGroup = tempGroup;
+        // 재생 모드는 OPC 대신 기록 파일에서 값을 받는다
+        if (!m_ReplayFile.IsEmpty())
+            m_bReplay = OpenReplay();
+        else if (m_bRecord)
+            OpenRecord();
 
-        MyGroup->IsActive = true;
-        MyGroup->IsSubscribed = true;
-        MyGroup->set_IsActive(VARIANT_TRUE);
-        MyGroup->set_IsSubscribed(VARIANT_TRUE);
-        MyGroup->set_UpdateRate(1000);
+        // 3~7. OPC 서버별 작업자 시작 (연결 / 아이템 등록 / 초기 읽기는 각 작업자 스레드에서,
+        //      시리얼 초기화와 병렬로 진행)
+        if (!m_bReplay)
+            StartWorkers();
 
-        MyItems = MyGroup->OPCItems;
+        // 2. 시리얼 포트 초기화 (포트마다, 실패한 포트는 감시자가 재연결)
+        m_PortSup = new TPortSupervisor();
+        m_PortSup->Resume();
 
-        // 5.  
-        int regCount = 0;
-        for (int i = 0; i < m_ItemCount; i++)
+        for (int l = 0; l < m_nLinkCount; l++)
         {
-            OPCItem *tempItem = NULL;
-            try
+            TEspLink* L = &m_Links[l];
+            if (!InitSerialPort(L, L->BaseBaud))
             {
-                MyItems->AddItem(WideString(m_Items[i].TagName),
-                                 m_Items[i].ItemID, &tempItem);
-                m_Items[i].pItem = tempItem;
-
-                if (tempItem != NULL)
-                {
-                    long serverHandle = tempItem->get_ServerHandle();
-                    long clientHandle = tempItem->get_ClientHandle();
-                    LogMessage("  [" + IntToStr(i) + "] SH=" + IntToStr(serverHandle) + " CH=" + IntToStr(clientHandle));
-                }
-                regCount++;
+                LinkDown(L, "OPEN");
             }
-            catch (Exception &e)
+            else if (L->AutoBaud)
             {
-                LogMessage("  [" + IntToStr(i) + "] AddItem FAIL: " + e.Message);
-                m_Items[i].pItem = NULL;
+                AutoBaud(L);
             }
         }
-        LogMessage("ITEM:" + IntToStr(regCount) + "/" + IntToStr(m_ItemCount));
-
-        // 6. ʱ  б  (OPC   غ ð)
-        Sleep(2000);
 
-        // 7. ʱ  б ׽Ʈ ( 忡)
-        for (int i = 0; i < m_ItemCount; i++)
+        // 초기 읽기 대기 - 늦은 서버는 기다리지 않고 이후 주기에 반영
+        HANDLE readyEvents[MAX_OPC_SERVERS];
+        for (int w = 0; w < m_nWorkerCount; w++)
+            readyEvents[w] = m_Workers[w]->ReadyEvent;
+        if (m_nWorkerCount > 0 &&
+            WaitForMultipleObjects(m_nWorkerCount, readyEvents, TRUE, 15000) == WAIT_TIMEOUT)
         {
-            if (m_Items[i].pItem != NULL)
-            {
-                OPCItem* pItem = (OPCItem*)m_Items[i].pItem;
-                
-                VARIANT varValue, varQuality, varTimestamp;
-                VariantInit(&varValue);
-                VariantInit(&varQuality);
-                VariantInit(&varTimestamp);
-                
-                try
-                {
-                    HRESULT hr = pItem->Read(2, &varValue, &varQuality, &varTimestamp);
-                    LogMessage("INIT RD[" + IntToStr(i) + "] hr=" + IntToHex((int)hr, 8) +
-                               " vt=" + IntToStr(varValue.vt) +
-                               " V=" + VariantToString(varValue));
-
-                    if (SUCCEEDED(hr))
-                    {
-                        VariantCopy(&m_Items[i].varValue, &varValue);
-                        VariantCopy(&m_Items[i].varPrevValue, &varValue);
-                        
-                        if (varQuality.vt == VT_I2)
-                            m_Items[i].Quality = varQuality.iVal;
-                        else if (varQuality.vt == VT_I4)
-                            m_Items[i].Quality = varQuality.lVal;
-                        else
-                            m_Items[i].Quality = 192;
-                    }
-                }
-                catch (Exception &e)
-                {
-                    LogMessage("INIT RD ERR[" + IntToStr(i) + "]: " + e.Message);
-                }
-                
-                VariantClear(&varValue);
-                VariantClear(&varQuality);
-                VariantClear(&varTimestamp);
-            }
+            LogMessage("OPC INIT TMO");
         }
+        MergeItems();
+
+        // 등록 결과까지 포함해 캐시 갱신
+        if (m_bCacheDirty)
+            SaveItemCache(configFile);
+
+        // 초기 값으로 포트별 프레임 이미지 배치
+        for (int l = 0; l < m_nLinkCount; l++)
+            PrepareLink(&m_Links[l]);
 
-        m_bFirstSend = true;
-        m_dwLastSendTick = 0;
+        // 8. 타이머 시작 (수집 주기 / 응답 및 ESP32 쓰기 명령 수신)
+        m_nScanTimerId = ReactorAddTimer(&m_Reactor, ScanTimerProc, this);
+        m_nPollTimerId = ReactorAddTimer(&m_Reactor, PollTimerProc, this);
+        ReactorArmTimer(&m_Reactor, m_nScanTimerId, m_nScanInterval, 0);
+        ReactorArmTimer(&m_Reactor, m_nPollTimerId, WRITE_POLL_MS, WRITE_POLL_MS);
 
-        // 8. Ÿ̸ 
-        if (Timer1)
+        // 설정 파일 변경 감시 시작
+        WatchConfig();
+
+        // 실시간 지표 서버
+        UpdateGaugeMetrics();
+        if (m_nMetricsPort > 0)
         {
-            Timer1->Interval = m_nTimeInterval;
-            Timer1->Enabled = true;
+            m_MetricsSrv = new TMetricsServer(&m_Metrics, m_nMetricsPort);
+            if (m_MetricsSrv->Listen())
+            {
+                m_MetricsSrv->Resume();
+                LogMessage("MET OK " + IntToStr(m_nMetricsPort));
+            }
+            else
+            {
+                LogMessage("E:MET " + IntToStr(m_nMetricsPort));
+                delete m_MetricsSrv;
+                m_MetricsSrv = NULL;
+            }
         }
 
         LogMessage("SVC READY");
@@ -781,34 +3333,54 @@ void __fastcall TGa1Agent::ServiceStart(TService *Sender, bool &Started)
 
 
 //---------------------------------------------------------------------------
-//  
+// 서비스 종료
 //---------------------------------------------------------------------------
 void __fastcall TGa1Agent::ServiceStop(TService *Sender, bool &Stopped)
 {
     LogMessage("SVC STOP");
 
-    if (Timer1) Timer1->Enabled = false;
+    // 타이머/감시 핸들 해제 (이후 루프는 돌지 않음)
+    ReactorClose(&m_Reactor);
+    m_nScanTimerId = -1;
+    m_nPollTimerId = -1;
+    m_nCfgWatchId = -1;
+    m_bCycleOpen = false;
+    FlushBinLog();
 
-    for (int i = 0; i < m_ItemCount; i++)
+    // 작업자 종료 (각자 자기 아파트에서 서버 연결 해제)
+    StopWorkers();
+
+    // 마지막 등록 결과 보존
+    SaveItemCache(ExtractFilePath(ParamStr(0)) + "oem_param.csv");
+
+    if (m_hCfgWatch != INVALID_HANDLE_VALUE)
     {
-        VariantClear(&m_Items[i].varValue);
-        VariantClear(&m_Items[i].varPrevValue);
+        FindCloseChangeNotification(m_hCfgWatch);
+        m_hCfgWatch = INVALID_HANDLE_VALUE;
     }
 
-    CloseSerialPort();
-
-    try
+    if (m_PortSup)
     {
-        if (OPCServer)
-        {
-            OPCServer->Disconnect();
-        }
+        m_PortSup->Stop();
+        delete m_PortSup;
+        m_PortSup = NULL;
     }
-    catch (Exception &ex)
+
+    if (m_MetricsSrv)
     {
-        LogMessage("E:" + ex.Message);
+        m_MetricsSrv->Stop();
+        delete m_MetricsSrv;
+        m_MetricsSrv = NULL;
     }
 
+    CloseRecord();
+    delete[] m_ReplayData;
+    m_ReplayData = NULL;
+    m_bReplay = false;
+
+    for (int l = 0; l < m_nLinkCount; l++)
+        CloseSerialPort(&m_Links[l]);
+
     CoUninitialize();
 
     Stopped = true;
@@ -816,213 +3388,322 @@ void __fastcall TGa1Agent::ServiceStop(TService *Sender, bool &Stopped)
 }
 
 ///---------------------------------------------------------------------------
-// Ÿ̸ ̺Ʈ (ü ü - Heartbeat + Ʈ α + COM 翬)
+// 타이머 이벤트 (전체 교체 - Heartbeat + 컴팩트 로그 + COM 재연결)
 //---------------------------------------------------------------------------
 //---------------------------------------------------------------------------
-// Ÿ̸ ̺Ʈ - SyncRead  
+// 타이머 이벤트 - SyncRead 사용 버전
 //---------------------------------------------------------------------------
 //---------------------------------------------------------------------------
-// Ÿ̸ ̺Ʈ - OPCItem.Read()  
+// 타이머 이벤트 - OPCItem.Read() 사용 버전
 //---------------------------------------------------------------------------
 void __fastcall TGa1Agent::Timer1Timer(TObject *Sender)
 {
-    Timer1->Enabled = false;
+    bool open = false;
+    m_dwCycleTick = GetTickCount();
 
     try
     {
         //------------------------------------------------------------------
-        // 1. OPC  б
+        // 0. 설정 파일이 바뀌었으면 주기 사이에 재적재
+        //------------------------------------------------------------------
+        if (!m_bReplay)
+            CheckConfigChange();
+
+        //------------------------------------------------------------------
+        // 1. 작업자들이 읽은 OPC 데이터 반영 (서버별로 병렬 수집됨)
+        //    재생 모드는 기록된 주기를 반영 (배속에 맞춰 다음 주기 간격 설정)
         //------------------------------------------------------------------
-        if ((IUnknown*)OPCServer != NULL && m_ItemCount > 0)
+        if (m_bReplay)
         {
-            for (int i = 0; i < m_ItemCount; i++)
-            {
-                if (m_Items[i].pItem != NULL)
-                {
-                    OPCItem* pItem = (OPCItem*)m_Items[i].pItem;
-                    
-                    try
-                    {
-                        //  1: Read() 
-                        VARIANT varValue, varQuality, varTimestamp;
-                        VariantInit(&varValue);
-                        VariantInit(&varQuality);
-                        VariantInit(&varTimestamp);
-                        
-                        HRESULT hr = pItem->Read(2, &varValue, &varQuality, &varTimestamp);
-                        
-                        if (SUCCEEDED(hr))
-                        {
-                            VariantCopy(&m_Items[i].varValue, &varValue);
-                            
-                            if (varQuality.vt == VT_I2) m_Items[i].Quality = varQuality.iVal;
-                            else if (varQuality.vt == VT_I4) m_Items[i].Quality = varQuality.lVal;
-                            else m_Items[i].Quality = 192;
-
-                            //  α (ʿ ּ )
-                            // LogMessage("RD[" + IntToStr(i) + "] V=" + VariantToString(varValue));
-                        }
-                        else
-                        {
-                            // Read   get_Value õ
-                            pItem->get_Value(&m_Items[i].varValue);
-                            pItem->get_Quality(&m_Items[i].Quality);
-
-                            //  α
-                            // LogMessage("GV[" + IntToStr(i) + "] vt=" + IntToStr(m_Items[i].varValue.vt));
-                        }
-                        
-                        VariantClear(&varValue);
-                        VariantClear(&varQuality);
-                        VariantClear(&varTimestamp);
-                    }
-                    catch (Exception &e)
-                    {
-                        LogMessage("RD ERR[" + IntToStr(i) + "]: " + e.Message);
-                        m_Items[i].Quality = 0;
-                    }
-                }
-            }
+            open = ReplayCycle();
+        }
+        else if (m_nWorkerCount > 0 && m_ItemCount > 0)
+        {
+            MergeItems();
+            AdaptScanRate(m_Metrics.LastChanges);
+            open = StartSends();
+        }
+    }
+    catch (Exception &e)
+    {
+        LogMessage("E:" + e.Message);
+    }
 
-            //------------------------------------------------------------------
-            // 2.   Ȯ    īƮ
-            //------------------------------------------------------------------
-            int changeCount = 0;
-            for (int i = 0; i < m_ItemCount; i++)
-            {
-                if (IsValueChanged(i))
-                {
-                    m_Items[i].Changed = true;
-                    changeCount++;
-                }
-            }
-            bool hasChanges = (changeCount > 0);
-            
-            //------------------------------------------------------------------
-            // 3. Heartbeat ŸӾƿ Ȯ
-            //------------------------------------------------------------------
-            DWORD dwNow = GetTickCount();
-            bool heartbeatTimeout = false;
-            
-            if (m_dwLastSendTick == 0)
-            {
-                heartbeatTimeout = true;
-            }
-            else
-            {
-                DWORD elapsed;
-                if (dwNow >= m_dwLastSendTick)
-                    elapsed = dwNow - m_dwLastSendTick;
-                else
-                    elapsed = (0xFFFFFFFF - m_dwLastSendTick) + dwNow + 1;
-                
-                if (elapsed >= m_dwHeartbeatInterval)
-                    heartbeatTimeout = true;
-            }
+    // 응답은 기다리지 않고 루프로 - PollTick 이 모두 받으면 주기를 닫는다
+    if (open)
+        m_bCycleOpen = true;
+    else
+        EndCycle();
+}
 
-            //------------------------------------------------------------------
-            // 4.  :  OR  OR Heartbeat
-            //------------------------------------------------------------------
-            if (m_bFirstSend || hasChanges || heartbeatTimeout)
-            {
-                bool isHB = heartbeatTimeout && !hasChanges && !m_bFirstSend;
-                
-                SendToESP32(changeCount, isHB);
-                m_dwLastSendTick = GetTickCount();
+//---------------------------------------------------------------------------
+// 주기 마감 (응답까지 끝난 뒤) - 지표 기록 후 다음 주기 예약
+// 다음 주기는 이번 주기가 끝난 시점부터 (전송이 밀려도 주기가 겹치지 않음)
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::EndCycle()
+{
+    m_bCycleOpen = false;
 
-                m_bFirstSend = false;
-            }
-        }
+    InterlockedIncrement(&m_Metrics.Cycles);
+    InterlockedExchange(&m_Metrics.CycleMs, (LONG)(GetTickCount() - m_dwCycleTick));
+    UpdateGaugeMetrics();
+
+    FlushBinLog();
+    ReactorArmTimer(&m_Reactor, m_nScanTimerId, m_bReplay ? m_nReplayWait : m_nScanInterval, 0);
+}
+
+//---------------------------------------------------------------------------
+// 응답/명령 수신 (WRITE_POLL_MS) - 응답 대기 중인 주기가 다 받으면 마감
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::PollTick()
+{
+    int waiting = 0;
+    try
+    {
+        waiting = PollResponses(RESP_TIMEOUT_MS);
     }
     catch (Exception &e)
     {
         LogMessage("E:" + e.Message);
     }
 
-    Timer1->Enabled = true;
+    if (m_bCycleOpen && waiting == 0)
+        EndCycle();
 }
 
 //---------------------------------------------------------------------------
-// WaitForResponse Լ (α )
+// 이벤트 루프 처리 함수 (Reactor 콜백 -> 멤버)
 //---------------------------------------------------------------------------
-bool __fastcall TGa1Agent::WaitForResponse(int timeoutMs)
+void TGa1Agent::ScanTimerProc(void* self)
 {
-    if (!m_bCommOpened || MyComm == NULL || !MyComm->Active())
-        return false;
+    ((TGa1Agent*)self)->Timer1Timer(NULL);
+}
+
+void TGa1Agent::PollTimerProc(void* self)
+{
+    ((TGa1Agent*)self)->PollTick();
+}
+
+void TGa1Agent::CfgWatchProc(void* self)
+{
+    ((TGa1Agent*)self)->ConfigNotify();
+}
+
+//---------------------------------------------------------------------------
+// 서비스 스레드 루프 - 타이머/감시 핸들과 서비스 제어 요청을 함께 기다린다
+// 모든 처리가 이 스레드 하나에서 차례로 일어난다 (OPC 작업자/지표 서버 제외).
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::ServiceExecute(TService *Sender)
+{
+    while (!Terminated)
+    {
+        if (ReactorRunOnce(&m_Reactor, 1000) < 0)
+            Sleep(10);
+        ServiceThread->ProcessRequests(false);
+    }
+}
 
-    BYTE respBuffer[5];
-    int respIndex = 0;
-    DWORD startTick = GetTickCount();
+//---------------------------------------------------------------------------
+// 포트별 전송만 (응답 대기 중인 포트가 있으면 true)
+//---------------------------------------------------------------------------
+bool __fastcall TGa1Agent::StartSends()
+{
+    // 우선 전송 변경은 이번 주기 데이터 프레임보다 먼저
+    SendPriority();
+
+    //------------------------------------------------------------------
+    // 2. 포트별 전송 (한 번 읽은 값으로 모든 포트에 공급)
+    //    끊긴 포트는 건너뛰고, 감시자가 장치를 찾았으면 다시 연다
+    //------------------------------------------------------------------
+    for (int l = 0; l < m_nLinkCount; l++)
+    {
+        TEspLink* L = &m_Links[l];
 
-    m_bWaitingResponse = true;
+        if (L->Down)
+            RecoverLink(L);
+        else if (!IsPortAlive(L))
+            LinkDown(L, "GONE");
 
-    while (GetTickCount() - startTick < (DWORD)timeoutMs)
+        // 속도 협상 중인 포트는 끝날 때까지 데이터 프레임을 쉰다
+        if (!L->Down && L->BaudState == BAUD_ST_IDLE)
+            ScheduleLink(L);
+    }
+
+    for (int l = 0; l < m_nLinkCount; l++)
     {
-        if (MyComm->ReadBufUsed() > 0)
-        {
-            BYTE b;
-            if (MyComm->ReadBuf(&b, 1) == 1)
-            {
-                // STX 
-                if (b == PROTO_STX && respIndex == 0)
-                {
-                    respBuffer[respIndex++] = b;
-                }
-                else if (respIndex > 0 && respIndex < 5)
-                {
-                    respBuffer[respIndex++] = b;
-                    
-                    // 5Ʈ  Ϸ
-                    if (respIndex == 5)
-                    {
-                        m_bWaitingResponse = false;
-                        
-                        // ETX Ȯ
-                        if (respBuffer[4] != PROTO_ETX)
-                            return false;
-                        
-                        // üũ Ȯ
-                        BYTE calcChk = respBuffer[1] ^ respBuffer[2];
-                        if (calcChk != respBuffer[3])
-                            return false;
-                        
-                        //  ڵ Ȯ
-                        BYTE cmd = respBuffer[1];
-                        BYTE status = respBuffer[2];
-                        
-                        return (cmd == RESP_CMD_ACK && status == RESP_STATUS_OK);
-                    }
-                }
-            }
-        }
-        Sleep(10);
+        if (m_Links[l].WaitingAck || m_Links[l].SchemaWait)
+            return true;
     }
-    
-    m_bWaitingResponse = false;
     return false;
 }
 
 //---------------------------------------------------------------------------
-void __fastcall TGa1Agent::HandleSendFailure()
+// 수신 버퍼 일괄 읽기 (가용 바이트를 링버퍼 빈 공간으로 바로 읽음)
+//---------------------------------------------------------------------------
+int __fastcall TGa1Agent::PumpReceive(TEspLink* L)
 {
-    m_nRetryCount++;
-    
-    if (m_nRetryCount >= m_nMaxRetries)
+    int total = 0;
+    int avail = L->Comm->ReadBufUsed();
+
+    while (avail > 0)
+    {
+        BYTE* p;
+        int span = RxWriteSpan(&L->Rx, &p);
+        if (span <= 0) break;       // 링 가득 참 - RxNext로 비운 뒤 다음 호출에서
+
+        int n = L->Comm->ReadBuf(p, (avail < span) ? avail : span);
+        if (n <= 0) break;
+
+        RxCommit(&L->Rx, n);
+        total += n;
+        avail -= n;
+    }
+    return total;
+}
+
+//---------------------------------------------------------------------------
+// 모든 포트 수신 한 번 (대기 없음) - 아직 응답을 기다리는 포트 수 반환
+// 응답 대기 중인 포트는 응답/타임아웃을 처리하고, 나머지 포트는 늦은 응답을 버린다.
+// 어느 쪽이든 들어온 쓰기 명령은 바로 처리하므로 쓰기가 주기를 기다리지 않는다.
+//---------------------------------------------------------------------------
+int __fastcall TGa1Agent::PollResponses(int timeoutMs)
+{
+    int waiting = 0;
+
+    for (int l = 0; l < m_nLinkCount; l++)
     {
-        LogMessage("Reconn...");
-        
-        CloseSerialPort();
-        Sleep(1000);
-        
-        if (InitSerialPort(m_nComPort, m_nBaudRate))
+        TEspLink* L = &m_Links[l];
+        if (!L->WaitingAck)
+        {
+            if (L->Down || !L->Opened || L->Comm == NULL || !L->Comm->Active())
+                continue;
+
+            if (L->BaudState != BAUD_ST_IDLE)
+            {
+                ServiceBaud(L);
+                continue;
+            }
+
+            if (L->SchemaWait)
+            {
+                ServiceSchema(L);
+                if (L->SchemaWait || L->WaitingAck)
+                    waiting++;
+                continue;
+            }
+
+            // 주기 밖에서 온 응답은 늦은 응답이므로 버림 (명령은 대기열에 남음)
+            TRxEvent stale;
+            PumpReceive(L);
+            while (RxNext(&L->Rx, &stale));
+
+            ServiceCommands(L);
+            continue;
+        }
+
+        if (!IsPortAlive(L))
+        {
+            // 장치 분리 - 타임아웃까지 기다리지 않음
+            CompleteSend(L, false);
+            LinkDown(L, "GONE");
+            continue;
+        }
+
+        PumpReceive(L);
+        bool got = RxNext(&L->Rx, &L->LastResp);
+
+        // 응답을 기다리는 동안 들어온 쓰기 명령도 바로 처리
+        ServiceCommands(L);
+
+        if (got)
         {
-            LogMessage("COM OK");
-            m_nRetryCount = 0;
+            CompleteSend(L, L->LastResp.Cmd == RESP_CMD_ACK && L->LastResp.Status == RESP_STATUS_OK);
+        }
+        else if (GetTickCount() - L->SendTick >= (DWORD)timeoutMs)
+        {
+            CompleteSend(L, false);
         }
         else
         {
-            LogMessage("COM FAIL");
+            waiting++;
         }
     }
+
+    // 응답 대기 중에도 우선 전송 변경은 바로 (응답이 없는 프레임이라 순서가 꼬이지 않음)
+    SendPriority();
+    FinishWrites();
+
+    return waiting;
+}
+
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::HandleSendFailure(TEspLink* L)
+{
+    L->RetryCount++;
+    InterlockedIncrement(&m_Metrics.Link[L - m_Links].Retries);
+
+    // 포트는 있는데 연속 무응답이면 닫고 감시자에게 재연결을 맡긴다
+    if (L->RetryCount >= m_nMaxRetries)
+        LinkDown(L, "TMO");
+}
+
+//---------------------------------------------------------------------------
+// 포트 장치 확인 (USB-시리얼 분리 시 핸들은 남아 있어도 상태 조회가 실패)
+//---------------------------------------------------------------------------
+bool __fastcall TGa1Agent::IsPortAlive(TEspLink* L)
+{
+    if (!L->Opened || L->Comm == NULL || !L->Comm->Active())
+        return false;
+
+    DWORD modem;
+    return (GetCommModemStatus((HANDLE)L->Comm->Handle, &modem) != FALSE);
+}
+
+//---------------------------------------------------------------------------
+// 포트 끊김 처리 - 닫고 감시자에 등록 (타이머 스레드는 대기하지 않음)
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::LinkDown(TEspLink* L, String reason)
+{
+    if (L->Down)
+        return;
+
+    LogMessage(LinkTag(L) + "COM LOST " + reason);
+
+    CloseSerialPort(L);
+    L->Opened = false;
+    L->WaitingAck = false;
+    L->Down = true;
+    L->DownTick = GetTickCount();
+    L->RetryCount = 0;
+    L->BaudState = BAUD_ST_IDLE;        // 복구 후 처음부터 다시 협상
+    L->SchemaWait = false;
+
+    if (m_PortSup)
+        m_PortSup->Watch((int)(L - m_Links), L->ComPort, true);
+}
+
+//---------------------------------------------------------------------------
+// 끊긴 포트 복구 - 감시자가 장치를 확인했을 때만 연다
+// 끊긴 동안에도 MergeItems 가 프레임을 계속 패치하므로 복구 직후
+// 첫 프레임이 현재 값을 싣는다.
+//---------------------------------------------------------------------------
+void __fastcall TGa1Agent::RecoverLink(TEspLink* L)
+{
+    int l = (int)(L - m_Links);
+    if (m_PortSup == NULL || !m_PortSup->TakeReady(l))
+        return;
+
+    if (!InitSerialPort(L, L->BaseBaud))
+    {
+        m_PortSup->Watch(l, L->ComPort, false);
+        return;
+    }
+    if (L->AutoBaud)
+        AutoBaud(L);
+
+    L->Down = false;
+    L->FirstSend = true;
+    L->SchemaPending = L->Schema;       // ESP32 가 재부팅했을 수 있음
+    LogMessage(LinkTag(L) + "COM RECOVER T:" + IntToStr((int)(GetTickCount() - L->DownTick)) + "ms");
 }
 
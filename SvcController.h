@@ -10,8 +10,14 @@
 #include "VaComm.hpp"
 #include <ExtCtrls.hpp>
 
-// OPC Automation 
+// OPC Automation 헤더
 #include "OPCAutomation_TLB.h"
+#include "EspProto.h"
+#include "BinLog.h"
+#include "RingLog.h"
+#include "ScanRec.h"
+#include "Reactor.h"
+#include "ScanCycle.h"
 
 using namespace Opcautomation_tlb;
 
@@ -19,40 +25,247 @@ typedef IOPCAutoServerPtr _di_IOPCAutoServer;
 typedef IOPCGroupsPtr     _di_IOPCGroups;
 typedef IOPCGroupPtr      _di_IOPCGroup;
 
-// (: Items Item 'I'  ̸ ǾǷ ̷ մϴ)
+// (주의: Items와 Item은 'I'가 빠진 이름으로 생성되었으므로 이렇게 연결합니다)
 typedef OPCItemsPtr       _di_IOPCItems;
 typedef OPCItemPtr        _di_IOPCItem;
 
 //---------------------------------------------------------------------------
-//  
-#define PROTO_STX       0x02
-#define PROTO_ETX       0x03
-#define MAX_OPC_ITEMS   500
-
-//  ڵ
-#define RESP_CMD_ACK    0x01
-#define RESP_CMD_NAK    0x02
-#define RESP_STATUS_OK  0x00
-#define RESP_STATUS_CHK 0x01
-#define RESP_STATUS_LEN 0x02
-#define RESP_STATUS_TMO 0x03
+// 프로토콜 상수 (MAX_OPC_ITEMS / MAX_ESP_LINKS 는 ScanCycle.h)
+#define MAX_OPC_SERVERS 8       // OPC 서버(수집 작업자) 최대 수
+
+// 응답 대기
 #define RESP_TIMEOUT_MS 5000
 
+// 설정 파일 변경 후 재적재까지 대기 (편집기가 나눠 쓰는 동안)
+#define CFG_SETTLE_MS   1000
+#define CFG_MAX_ERR_LOG 5       // CSV 오류 행 로그 최대 수 (나머지는 개수만)
+#define LOG_LINE_MAX    1024    // 로그 한 줄 (시각/줄바꿈 포함, 넘는 부분은 자름)
+
 #define HK_DEBUG		0		// debug enable
-#define	SERVER_SIMULATE	0		// ùķ̼ 
+#define	SERVER_SIMULATE	0		// 시뮬레이션 모드
+
+class TOpcWorker;
+class TPortSupervisor;
+class TMetricsServer;
 
-// OPC   ü
-struct TOPCItemInfo
+// OPC 아이템 정보 구조체 (수집 주기 부분은 TCycleItem - 값/품질/시각/포트 슬롯)
+struct TOPCItemInfo : TCycleItem
 {
     int         ItemID;
     String      TagName;
     String      DataType;
     String      Description;
-    OPCItem*    pItem;          // _di_IOPCItem  OPCItem* 
-    VARIANT     varValue;
-    VARIANT     varPrevValue;
-    long        Quality;
-    bool        Changed;
+    String      Server;         // OPC 서버 ProgID (CSV 5번째 컬럼, 비면 기본 서버)
+    int         Priority;       // 전송 우선순위 (CSV 6번째 컬럼, 1: 변경 즉시 우선 전송 프레임)
+    long        ServerHandle;   // 마지막 등록 결과 (담당 작업자가 기록, 0 = 미등록)
+    long        AddError;       // 마지막 AddItem 결과 (HRESULT)
+
+    // 우선 전송 (Priority 아이템, m_csItems 보호 - 작업자가 변경을 표시, 메인이 전송)
+    bool        PrioArmed;      // 기준 값 있음 (첫 읽기는 변경으로 보지 않음)
+    bool        PrioPending;
+    long        PrioValue;      // 마지막으로 읽은 값/품질
+    BYTE        PrioQCode;
+    LARGE_INTEGER PrioTime;     // 변경을 처음 표시한 시각 (QPC, 전송 지연 측정)
+};
+
+// ItemID -> 테이블 인덱스 (열린 주소 해시, 세대별)
+// 크기는 2의 거듭제곱, MAX_OPC_ITEMS 의 2배 이상 (채움률 50% 이하)
+#define ITEM_INDEX_BITS     10
+#define ITEM_INDEX_SIZE     (1 << ITEM_INDEX_BITS)
+
+struct TItemIndex
+{
+    WORD        ItemID;
+    short       Slot;           // -1: 빈 칸
+};
+
+// 아이템 테이블 캐시 (oem_param.bin, CSV 옆)
+// CSV 가 바뀌지 않았으면 파싱 없이 이 이미지를 매핑해서 테이블을 채운다.
+// [HDR][REC x Count][문자열 풀 (NUL 종료)]
+// 서버 핸들은 그룹마다 새로 발급되므로 재사용하지 않고 마지막 등록 결과로만 남긴다.
+#define ITEM_CACHE_MAGIC    0x43494147      // "GAIC"
+#define ITEM_CACHE_VERSION  2
+
+struct TItemCacheHdr
+{
+    DWORD       Magic;
+    WORD        Version;
+    WORD        Count;
+    DWORD       CsvSize;
+    FILETIME    CsvTime;
+    DWORD       CsvHash;        // CSV 내용 해시
+    DWORD       SrvHash;        // 기본 서버 이름 해시 (5번째 컬럼이 빈 아이템에 적용)
+    DWORD       PoolSize;
+};
+
+struct TItemCacheRec
+{
+    long        ItemID;
+    DWORD       Tag;            // 문자열 풀 오프셋
+    DWORD       Type;
+    DWORD       Desc;
+    DWORD       Server;
+    long        ServerHandle;
+    long        AddError;
+    long        Priority;
+};
+
+// 링크 통계 (주기적으로 로그에 요약)
+struct TLinkStats
+{
+    DWORD       Frames;         // 전송 프레임 수
+    DWORD       ZFrames;        // 압축해서 보낸 프레임 수
+    DWORD       ZRawBytes;      // 압축 대상 원본 바이트 합
+    DWORD       ZOutBytes;      // 실제 전송 바이트 합 (압축 안 된 경우 원본 그대로)
+    double      ZCpuUs;         // 압축에 쓴 CPU 시간 합 (us)
+};
+
+// 실시간 지표 ([Agent] MetricsPort, TMetricsServer 가 Prometheus 텍스트로 제공)
+// 갱신하는 쪽은 Interlocked 만 쓰고 지표 서버는 잠금 없이 읽으므로,
+// 스크레이프가 수집/전송 주기를 막지 않는다. 카운터는 32비트 (넘치면 0부터).
+#define METRICS_NAME_LEN    64
+
+struct TScanMetrics             // OPC 작업자 1개 (작업자가 생성/소멸 시 칸을 잡고 놓음)
+{
+    volatile LONG   Active;
+    char            Name[METRICS_NAME_LEN];     // ProgID
+    volatile LONG   Connected;
+    volatile LONG   Scans;          // 읽기 주기 수
+    volatile LONG   ScanMs;         // 읽기 시간 누적 (ms)
+    volatile LONG   LastScanMs;     // 직전 읽기 시간
+    volatile LONG   ItemsRead;
+    volatile LONG   ReadErrors;
+};
+
+struct TLinkMetrics             // 출력 포트 1개
+{
+    volatile LONG   ComPort;
+    volatile LONG   BaudRate;
+    volatile LONG   Up;
+    volatile LONG   Frames;         // 데이터 프레임 (응답 완료 기준)
+    volatile LONG   TxBytes;
+    volatile LONG   Acks;
+    volatile LONG   Naks;
+    volatile LONG   Timeouts;
+    volatile LONG   Retries;
+    volatile LONG   QueueDepth;     // ACK 를 기다리는 샘플 (묶음 포트) / 아이템 수
+    volatile LONG   PrioFrames;     // 우선 전송 프레임 (응답 없음)
+    volatile LONG   Coalesced;      // 전송 전에 최신 값으로 합쳐진 샘플
+};
+
+struct TAgentMetrics
+{
+    volatile LONG   Cycles;         // 메인 주기 수
+    volatile LONG   CycleMs;        // 직전 주기 처리 시간 (반영 ~ 응답 대기)
+    volatile LONG   Changes;        // 값/품질 변경 누적 (시각만 바뀐 샘플 제외)
+    volatile LONG   LastChanges;    // 직전 주기 변경 수
+    volatile LONG   ItemCount;
+    volatile LONG   WriteCmds;      // ESP32 쓰기 명령 수
+    volatile LONG   WriteQueue;     // 처리 중인 쓰기 명령
+    volatile LONG   LinkCount;
+    volatile LONG   ScanInterval;   // 현재 수집 주기 (적응 주기면 ScanMin ~ ScanMax)
+    volatile LONG   PrioEdges;      // 우선 전송 아이템 변경 수
+    volatile LONG   PrioLatencyUs;  // 직전 우선 전송 지연 (변경 확인 ~ 송신, 프레임 안 가장 오래된 변경)
+    volatile LONG   PrioLatencyMsSum;   // 우선 전송 지연 누적 (ms, 프레임 수로 나누면 평균)
+                                        // 부호 없이 읽어 지연 합 2^32 ms (약 49.7일) 에 0 으로 돈다
+    TScanMetrics    Server[MAX_OPC_SERVERS];
+    TLinkMetrics    Link[MAX_ESP_LINKS];
+};
+
+// 적응 주기: 연속 2주기 변경이 이어지면 주기를 절반으로, 연속 5주기 조용하면
+// 1.5배로 (줄일 때는 빠르게, 늘릴 때는 천천히 - 한 번씩 튀는 변경에는 그대로)
+#define SCAN_TIGHTEN_CYCLES 2
+#define SCAN_RELAX_CYCLES   5
+#define SCAN_MIN_FLOOR      50          // ScanMin 하한 (ms)
+
+// 우선 전송 대기 변경 (메인 스레드 작업 목록)
+struct TPrioEdge
+{
+    int         Index;          // 테이블 인덱스
+    long        Value;
+    BYTE        QCode;
+    LARGE_INTEGER Time;
+};
+
+// 이진 이벤트 로그 버퍼 (레코드 수)
+#define BLOG_BUF_RECS       256
+
+// ESP32 쓰기 명령 (프레임 하나)
+// 아이템을 서버별 작업자에 나눠 넣고, 결과가 모두 모이거나 제한 시간이 지나면
+// 아이템별 결과 코드와 처리 시간을 FRAME_WRITE_ACK 로 돌려준다.
+#define WRITE_QUEUE         8           // 동시에 처리 중인 명령 수 (2의 거듭제곱, 16 이하)
+#define WRITE_TIMEOUT_MS    3000
+#define WRITE_POLL_MS       20          // 응답/명령 수신 확인 간격 (이벤트 루프 타이머)
+
+struct TWriteCmd
+{
+    bool        InUse;
+    int         Serial;         // 슬롯 재사용 구분 (늦은 결과 보고 무시)
+    int         Link;
+    BYTE        Seq;
+    int         Count;
+    int         Pending;        // 결과를 기다리는 아이템 수
+    BYTE        Result[WRITE_MAX];
+    DWORD       RecvTick;
+    LARGE_INTEGER RecvTime;     // 명령 수신 시각
+    LARGE_INTEGER DoneTime;     // 마지막 결과 시각
+};
+
+// 보오레이트 협상 단계 (포트별)
+// 응답을 기다리며 멈추지 않고 응답 확인 타이머(WRITE_POLL_MS)가 올 때마다
+// 한 단계씩 진행한다. 협상 중인 포트는 데이터/우선/쓰기 응답 전송을 쉰다.
+#define BAUD_ST_IDLE        0
+#define BAUD_ST_REQ         1           // FRAME_BAUD 응답 대기 (현재 속도)
+#define BAUD_ST_SETTLE      2           // 새 속도로 바꾼 뒤 잠시 대기
+#define BAUD_ST_PROBE       3           // FRAME_PROBE 응답 대기 (새 속도)
+#define BAUD_ST_REVERT      4           // 실패 - ESP32 가 기본 속도로 돌아갈 때까지 조용히 대기
+#define BAUD_REQ_TMO_MS     500
+#define BAUD_PROBE_TMO_MS   200
+#define BAUD_SETTLE_MS      50
+
+// 스키마 사전 ACK 대기 (협상처럼 응답 확인 타이머가 마무리 - 그동안 데이터 보류)
+#define SCHEMA_TMO_MS       1000
+
+// 출력 포트 (ESP32/로거 1대분)
+// 아이템 부분집합, 속도, 프로토콜 옵션, 전송/응답 상태를 포트마다 따로 가진다.
+// 슬롯/프레임/묶음 샘플/응답 대기 등 수집 주기 부분은 TCycleLink.
+struct TEspLink : TCycleLink
+{
+    TVaComm*    Comm;               // 1번 포트는 MyComm, 추가 포트는 런타임 생성
+    int         ComPort;
+    int         BaudRate;           // 현재 링크 속도
+    int         BaseBaud;           // 기본 속도 (ESP32 부팅 속도, INI BaudRate)
+    bool        AutoBaud;           // 자동 보오레이트 협상 사용
+    int         BaudSteps[8];       // 협상 후보 (높은 순)
+    int         BaudStepCount;
+    int         BaudState;          // 협상 단계 (BAUD_ST_xxx)
+    int         BaudStep;           // 시도 중인 후보 (BaudSteps 인덱스)
+    int         BaudProbe;          // 응답 받은 프로브 수
+    DWORD       BaudTick;           // 현재 단계 시작 시각
+    bool        Compress;           // 키프레임 압축 사용
+    bool        Schema;             // 스키마 사전 + 위치 기반 데이터 프레임 사용
+    DWORD       HeartbeatMs;        // Heartbeat 주기 (ms)
+    DWORD       KeepaliveMs;        // 생존 확인 주기 (ms, 0: 값이 그대로여도 Heartbeat 로 전체 프레임)
+    bool        Opened;
+    bool        Down;               // 끊김 - 감시자가 장치 재등장을 확인 중
+    DWORD       DownTick;           // 끊긴 시각 (복구 로그용)
+
+    BYTE        CtrlBuf[EXT_SIZE(BAUD_PROBE_LEN)];
+    DWORD       SchemaHash;         // 현재 슬롯 배치의 스키마 해시
+    bool        SchemaPending;      // 데이터 전에 스키마 사전부터 보내야 함
+    bool        SchemaWait;         // 사전을 보내고 ACK 대기 중
+    DWORD       SchemaTick;         // 사전 전송 시각
+    DWORD       SchemaTxHash;       // 보낸 사전의 해시
+
+    // 전송 상태
+    bool        FirstSend;
+    DWORD       LastSendTick;       // 마지막 전송 시간 (Heartbeat 기준)
+    WORD        KeepaliveSeq;
+    BYTE        PrioSeq;            // 우선 전송 프레임 번호
+    int         RetryCount;
+    int         WinSends;           // 오류율 창: 전송 수
+    int         WinFails;           // 오류율 창: 실패 수
+    TLinkStats  Stats;
 };
 
 //---------------------------------------------------------------------------
@@ -64,67 +277,252 @@ __published:    // IDE-managed Components
 	void __fastcall Timer1Timer(TObject *Sender);
     void __fastcall ServiceStart(TService *Sender, bool &Started);
     void __fastcall ServiceStop(TService *Sender, bool &Stopped);
+    void __fastcall ServiceExecute(TService *Sender);
 
     
 private:        // User declarations
-    // OPC  ()
-    _di_IOPCAutoServer OPCServer;
-    _di_IOPCGroups     OPCGroups;
-    _di_IOPCGroup      MyGroup;
-    _di_IOPCItems      MyItems;
-
-     // === INI   ===
-    int m_nComPort;         // COM Ʈ ȣ (ڸ)
-    int m_nBaudRate;        //  ӵ
-    int m_nTimeInterval;    // Ÿ̸  (ms)
+    friend class TOpcWorker;
+
+    // OPC 관련 (서버마다 작업자 스레드 하나)
+    TOpcWorker*     m_Workers[MAX_OPC_SERVERS];
+    int             m_nWorkerCount;
+    String          m_DefaultServer;        // [Agent] OPCServer
+    CRITICAL_SECTION m_csItems;             // 아이템 값 (작업자 <-> 메인)
+    CRITICAL_SECTION m_csLog;               // 로그 파일
+
+     // === INI 설정 변수 ===
+    int m_nTimeInterval;    // 타이머 간격 (ms)
+
+    // 적응 주기 ([Agent] ScanMin < ScanMax 일 때, TimeInterval 은 시작 주기)
+    bool m_bAdaptive;
+    int m_nScanMin;
+    int m_nScanMax;
+    int m_nScanBusy;        // 이 수 이상 변경된 주기를 "변경 있음"으로 봄
+    int m_nScanInterval;    // 현재 적용 중인 주기 (고정이면 TimeInterval)
+    int m_nBusyCycles;
+    int m_nQuietCycles;
+
+    // 출력 포트 (한 번의 OPC 읽기로 모든 포트에 공급)
+    TEspLink        m_Links[MAX_ESP_LINKS];
+    int             m_nLinkCount;
+    String          m_LinkItems[MAX_ESP_LINKS];     // Items= 설정 (ItemID 목록, 비면 전체)
+    String          m_LinkSection[MAX_ESP_LINKS];   // INI 섹션 이름 (재적재용)
+    TPortSupervisor* m_PortSup;                     // 끊긴 포트 재연결 감시
+
+    // 실시간 지표 (loopback TCP, [Agent] MetricsPort - 0 이면 끔)
+    TAgentMetrics   m_Metrics;
+    TMetricsServer* m_MetricsSrv;
+    int             m_nMetricsPort;
         
-    //  迭
-    TOPCItemInfo    m_Items[MAX_OPC_ITEMS];
+    // 아이템 배열 (이중 버퍼 - 재적재 시 대기 쪽에 새 테이블을 만들고 주기 사이에 교체)
+    TOPCItemInfo    m_ItemBuf[2][MAX_OPC_ITEMS];
+    TOPCItemInfo*   m_Items;                // 사용 중인 테이블 (= m_ItemBuf[m_nItemGen & 1])
+    TItemIndex      m_ItemIndex[2][ITEM_INDEX_SIZE];    // 세대별 ItemID 색인
     int             m_ItemCount;
-    
-    // ø  
-    bool            m_bCommOpened;
-    BYTE            m_SendBuffer[1024];
-    bool            m_bFirstSend;
+    int             m_nItemGen;             // 테이블 세대 (재적재마다 증가)
+
+    // 설정 파일 감시
+    HANDLE          m_hCfgWatch;
+    int             m_nCfgAgeCsv;
+    int             m_nCfgAgeIni;
+    bool            m_bCfgPending;
+    DWORD           m_dwCfgTick;
 
-	//  
-	int             m_nRetryCount;
+    // 아이템 테이블 캐시 (사용 중인 테이블을 만든 CSV 의 크기/시각/해시)
+    bool            m_bCsvStamp;
+    DWORD           m_dwCsvSize;
+    FILETIME        m_ftCsvTime;
+    DWORD           m_dwCsvHash;
+    bool            m_bCacheDirty;
+
+    // 키프레임 압축 (포트 공용 작업 버퍼)
+    TLzEncoder      m_Lz;
+    BYTE            m_ZScratch[FRAME_SIZE(MAX_OPC_ITEMS)];
+    BYTE            m_ZBuf[FRAME_SIZE(MAX_OPC_ITEMS)];
+
+    // 이진 이벤트 로그 ([Agent] BinLog=1, 모아서 주기 끝에 파일로)
+    bool            m_bBinLog;
+    TBinLogRec      m_BinBuf[BLOG_BUF_RECS];
+    int             m_nBinCount;
+    SYSTEMTIME      m_BinDate;              // 버퍼에 담긴 레코드의 날짜
+
+    // 수집 기록 ([Agent] Record=1 -> scanrec_YYYYMMDD_HHMMSS.srec, 주기마다 추가)
+    bool            m_bRecord;
+    HANDLE          m_hRecord;
+    LONGLONG        m_RecClock;
+    TScanSample     m_RecSamples[MAX_OPC_ITEMS];
+    int             m_nRecCount;
+    BYTE            m_RecBuf[SREC_CYCLE_SIZE(MAX_OPC_ITEMS)];
+
+    // 기록 재생 ([Agent] Replay=파일 - OPC 대신 기록된 샘플을 주기마다 반영)
+    bool            m_bReplay;
+    String          m_ReplayFile;
+    double          m_dReplaySpeed;         // 배속 (0: 최대 속도)
+    BYTE*           m_ReplayData;
+    int             m_nReplayLen;
+    int             m_nReplayPos;
+    LONGLONG        m_ReplayClock;          // 대기 중인 주기의 기록 시각
+    LONGLONG        m_ReplayStartMs;        // 기록 시작 시각
+    int             m_nReplayCycles;
+    DWORD           m_dwReplayTick;         // 재생 시작 시각 (배속 기준, 소요 시간 로그)
+    int             m_nReplayPending;       // 다음 주기 샘플 수 (m_RecSamples 에 미리 해석)
+
+    // ESP32 쓰기 명령 (작업자가 결과 기록, 메인 스레드가 응답)
+    TWriteCmd       m_WriteCmds[WRITE_QUEUE];
+    int             m_nWriteSerial;
+    CRITICAL_SECTION m_csWrite;
+    BYTE            m_WriteAck[EXT_SIZE(4 + WRITE_MAX)];
+
+    // 이벤트 루프 (서비스 스레드 하나에서 수집 주기 / 응답 확인 / 설정 감시)
+    // 수집 주기는 한 번만 울리는 타이머 - 주기가 끝나면 (응답까지) 다음 주기를 건다
+    TReactor        m_Reactor;
+    int             m_nScanTimerId;
+    int             m_nPollTimerId;         // WRITE_POLL_MS 마다 응답/명령 수신
+    int             m_nCfgWatchId;
+    bool            m_bCycleOpen;           // 전송 후 응답 대기 중인 주기
+    DWORD           m_dwCycleTick;
+    int             m_nReplayWait;          // 재생 중 다음 주기까지 (ms)
+
+    // 우선 전송 (작업자가 변경 표시 -> 메인 스레드가 20ms 안에 전송)
+    volatile LONG   m_lPrioPending;
+    LONG            m_nPrioLatRemUs;        // 지연 누적에 아직 못 넣은 1ms 미만 (us)
+    TPrioEdge       m_PrioEdges[MAX_OPC_ITEMS];
+    BYTE            m_PrioPayload[PRIO_HDR_LEN + PRIO_MAX * PRIO_ITEM_LEN];
+    BYTE            m_PrioFrame[PRIO_SIZE(PRIO_MAX)];
+
+    // 다중 샘플 프레임 (포트 공용 작업 버퍼)
+    BYTE            m_BatchFrame[BATCH_SIZE(MAX_OPC_ITEMS)];
+
+    // 스키마 사전 (포트 공용 작업 버퍼)
+    BYTE            m_SchemaBuf[SCHEMA_SIZE(MAX_OPC_ITEMS)];
+    BYTE            m_SchemaFrame[SCHEMA_SIZE(MAX_OPC_ITEMS)];
+
+	// 응답 관련
 	int             m_nMaxRetries;
-	bool            m_bWaitingResponse;
-    DWORD           m_dwLastSendTick;       //   ð
-	DWORD           m_dwHeartbeatInterval;  // Heartbeat ֱ (ms)
+	DWORD           m_dwHeartbeatInterval;  // Heartbeat 기본 주기 (ms)
 
-    // α
+    // 로그
     TCHAR gbuf[65535];
+    TRingLog        m_LogRing;              // logsave.ring (고정 크기, 메모리 맵)
+    bool            m_bLogOpened;           // 링 열기 시도 여부
+    DWORD           m_dwLogSize;            // 링 데이터 크기 ([Agent] LogSizeKB)
 
-    //  Լ - 
+    // 내부 함수 - 기존
     void __fastcall LogMessage(String msg);
+    void __fastcall LogText(const char* msg, int len);
+    void __fastcall WriteLogLine(const char* msg, int len);
+    void __fastcall OpenLogRing();
     String __fastcall VariantToString(const tagVARIANT &v);
     int __fastcall GetQualityCode(long quality);
 
-        // ===  ε Լ ===
+        // === 설정 로드 함수 ===
     void __fastcall LoadSettings();
+    void __fastcall LoadLinkSettings(TIniFile *ini, String section);
+    void __fastcall ReadLinkSettings(TIniFile *ini, String section, TEspLink* L);
+    void __fastcall AssignLinkItems();
+    void __fastcall AssignLink(int l, TStrings *spec);
+    String __fastcall LinkTag(TEspLink* L);
+    int __fastcall PutLinkTag(char* p, TEspLink* L);
+
+    // 내부 함수 - CSV 로드
+    bool __fastcall LoadItemConfig(String filename, TOPCItemInfo* items, int &count);
+    int __fastcall ParseItemRows(const char* data, int len, TOPCItemInfo* items, int &count, int &errors);
+    bool __fastcall LoadItemCache(String csvFile, TOPCItemInfo* items, int &count);
+    void __fastcall SaveItemCache(String csvFile);
+
+    // 내부 함수 - 설정 재적재
+    void __fastcall WatchConfig();
+    void __fastcall ConfigNotify();
+    void __fastcall CheckConfigChange();
+    bool __fastcall ReloadConfig();
+    void __fastcall ReloadSettings();
+    int __fastcall ReadScanBounds(TIniFile *ini, int interval);
+    void __fastcall SetScanInterval(int interval);
+    void __fastcall AdaptScanRate(int changes);
+    void __fastcall ReloadWorkers(const int* oldIndex);
+    void __fastcall RebuildLinks(const int* oldIndex, TOPCItemInfo* oldItems);
+
+    // 내부 함수 - OPC 수집 작업자
+    void __fastcall StartWorkers();
+    void __fastcall StopWorkers();
+    void __fastcall PublishItem(int gen, int index, VARIANT* value, long quality, double srcTime = 0);
+    void __fastcall MarkPriority(TOPCItemInfo* item, long value, BYTE qcode);
+    void __fastcall SendPriority();
+    TOPCItemInfo* __fastcall ItemTable(int gen) { return m_ItemBuf[gen & 1]; }
+    void __fastcall BuildItemIndex(int gen, int count);
+    int __fastcall FindItem(int gen, int itemId);
+    void __fastcall MergeItems();
+    TOpcWorker* __fastcall WorkerFor(const String &server);
+
+    // 내부 함수 - ESP32 쓰기 명령
+    void __fastcall BinLogEvent(TBinLogRec* r);
+    void __fastcall FlushBinLog();
+    void __fastcall ServiceCommands(TEspLink* L);
+    void __fastcall StartWrite(TEspLink* L, const TRxCommand* cmd);
+    void __fastcall CompleteWrite(int cmd, int pos, BYTE result);
+    void __fastcall FinishWrites();
+
+    // 내부 함수 - 실시간 지표
+    TScanMetrics* __fastcall OpenScanMetrics(String progId);
+    void __fastcall CloseScanMetrics(TScanMetrics* m);
+    void __fastcall UpdateGaugeMetrics();
+
+    // 내부 함수 - 수집 기록/재생
+    void __fastcall OpenRecord();
+    void __fastcall CloseRecord();
+    void __fastcall RecordCycle(LONGLONG nowMs);
+    bool __fastcall OpenReplay();
+    bool __fastcall ReplayStep();
+    bool __fastcall ReplayCycle();
 
-    //  Լ - CSV ε
-    bool __fastcall LoadItemConfig(String filename);
+    // 내부 함수 - 이벤트 루프
+    static void ScanTimerProc(void* self);
+    static void PollTimerProc(void* self);
+    static void CfgWatchProc(void* self);
+    void __fastcall PollTick();
+    bool __fastcall StartSends();
+    void __fastcall EndCycle();
     
-    //  Լ - ø 
-    bool __fastcall InitSerialPort(int portNum, int baudRate);
-    void __fastcall CloseSerialPort();
+    // 내부 함수 - 시리얼 통신
+    TVaComm* __fastcall CreateComm();
+    bool __fastcall InitSerialPort(TEspLink* L, int baudRate);
+    void __fastcall CloseSerialPort(TEspLink* L);
+    bool __fastcall SetLinkBaud(TEspLink* L, int baudRate);
+    bool __fastcall PostControlFrame(TEspLink* L, BYTE type, const BYTE* payload, int len);
+    void __fastcall BeginBaud(TEspLink* L, int step);
+    void __fastcall SendBaudProbe(TEspLink* L);
+    void __fastcall FailBaud(TEspLink* L, bool switched);
+    void __fastcall ServiceBaud(TEspLink* L);
+    void __fastcall AutoBaud(TEspLink* L);
+    void __fastcall TrackLinkErrors(TEspLink* L, bool ok);
     BYTE __fastcall CalcChecksum(BYTE* data, int len);
-    int __fastcall BuildPacket(BYTE* buffer);
-    void __fastcall SendToESP32(int changeCount = 0, bool isHeartbeat = false);
+    int __fastcall BuildPacket(TEspLink* L);
+    int __fastcall BuildSchema(TEspLink* L, BYTE* payload, DWORD* hash);
+    bool __fastcall PostSchema(TEspLink* L);
+    void __fastcall ServiceSchema(TEspLink* L);
+    void __fastcall PrepareLink(TEspLink* L);
+    void __fastcall UpdateFrameItem(int index);
+    void __fastcall CaptureSample(int index);
+    int __fastcall CompressFrame(TEspLink* L);
+    void __fastcall LogLinkStats(TEspLink* L);
+    void __fastcall ScheduleLink(TEspLink* L);
+    void __fastcall SendToESP32(TEspLink* L, int changeCount = 0, bool isHeartbeat = false, bool batch = false);
+    void __fastcall SendKeepalive(TEspLink* L);
+    void __fastcall CompleteSend(TEspLink* L, bool ok);
 
-    //  Լ -  
-    bool __fastcall IsValueChanged(int index);
-    bool __fastcall HasAnyChanges();
+    // 내부 함수 - 값 변환
     long __fastcall VariantToLong(const VARIANT &v);
 
-	bool __fastcall WaitForResponse(int timeoutMs);
-	void __fastcall HandleSendFailure();
+	int __fastcall PumpReceive(TEspLink* L);
+	int __fastcall PollResponses(int timeoutMs);
+	void __fastcall HandleSendFailure(TEspLink* L);
+	bool __fastcall IsPortAlive(TEspLink* L);
+	void __fastcall LinkDown(TEspLink* L, String reason);
+	void __fastcall RecoverLink(TEspLink* L);
 
 public:         // User declarations
 	__fastcall TGa1Agent(TComponent* Owner);
+	__fastcall ~TGa1Agent();
 	TServiceController __fastcall GetServiceController(void);
 
 	friend void __stdcall ServiceController(unsigned CtrlCode);